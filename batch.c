@@ -0,0 +1,400 @@
+/**
+ * @file batch.c
+ * @brief Batch mode: runs inventory commands from a file or standard input without the menu.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "frontend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+
+#define BATCH_BUFFER_SIZE (1 << 20)
+#define BATCH_PATH_SIZE 512
+
+/**
+ * @brief Writes one product as a machine-readable batch result line.
+ *
+ * @param out Output stream.
+ * @param tag Line tag, such as "FOUND" or "ITEM".
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot of the product.
+ */
+static void batchPrintProduct(FILE *out, const char *tag, const Inventory *inv, size_t slot) {
+    char price[CENTS_BUF_SIZE];
+    Product product;
+    inventoryGet(inv, slot, &product);
+    fprintf(out, "%s %d %s %s %d\n", tag, product.id, product.name, formatCents(product.priceCents, price), product.quantity);
+}
+
+/**
+ * @brief Names a library status code the way batch ERR lines report it.
+ *
+ * @param status INV_OK or an INV_ERR_* code.
+ * @return NULL for INV_OK, otherwise the error word.
+ */
+static const char *batchError(int status) {
+    switch (status) {
+        case INV_OK:
+            return NULL;
+        case INV_ERR_EXISTS:
+            return "exists";
+        case INV_ERR_NOT_FOUND:
+            return "notfound";
+        case INV_ERR_STOCK:
+            return "stock";
+        case INV_ERR_NOMEM:
+            return "memory";
+        default:
+            return "invalid";
+    }
+}
+
+/**
+ * @brief Runs inventory commands read from a stream, without the menu.
+ *
+ * One command per line; blank lines and lines starting with '#' are ignored:
+ *   add <id> <name> <price> <quantity>     -> OK add <id>
+ *   update <id> <name> <price> <quantity>  -> OK update <id>
+ *   delete <id>                            -> OK delete <id>
+ *   search <id>                            -> FOUND <id> <name> <price> <quantity>
+ *   find <text>                            -> FOUND lines for names containing text, then OK find <count>
+ *   prefix <text>                          -> FOUND lines for names starting with text, then OK prefix <count>
+ *   bill <id> <quantity> [<id> <quantity>...] -> sells them: LINE <id> <name> <price> <quantity> <amount>
+ *                                             lines, then BILL <number> <total>
+ *   total                                  -> TOTAL <sales so far>
+ *   value                                  -> VALUE <stock value>
+ *   stats                                  -> STATS <stock value> <units> <products> <low-stock products>
+ *   lowstock <threshold>                   -> OK lowstock <low-stock products>
+ *   check                                  -> OK check, if the running totals match a full recount
+ *   range <price|quantity> <low> <high>    -> ITEM lines, lowest first, then OK range <count>
+ *   top <price|quantity> <count>           -> ITEM lines, highest first, then OK top <count>
+ *   bottom <price|quantity> <count>        -> ITEM lines, lowest first, then OK bottom <count>
+ *   revenue <id> <days>                    -> REVENUE <id> <units> <amount> over the last days, today included
+ *   sellers <count> <days>                 -> SELLER <id> <units> <amount> lines, best revenue first, then
+ *                                             OK sellers <count>
+ *   reorder <count>                        -> REORDER <id> <quantity> <point> <days of cover> <order units>
+ *                                             lines, fewest days of cover first, then OK reorder <count>
+ *   rule <id> <point> <order units>        -> OK rule <id>; 0 order units sizes orders from demand
+ *   order <path>                           -> writes a purchase order: OK order <lines> <total>
+ * A failed command prints "ERR <line> <command> <reason>". Output is fully buffered in large
+ * blocks, and logged changes are committed in groups rather than per command.
+ *
+ * @param inv Pointer to the inventory.
+ * @param ledger Pointer to the sales ledger.
+ * @param in Command stream.
+ * @param out Result stream.
+ * @return Number of commands that failed.
+ */
+size_t runBatch(Inventory *inv, Ledger *ledger, FILE *in, FILE *out) {
+    static char inBuffer[BATCH_BUFFER_SIZE];
+    static char outBuffer[BATCH_BUFFER_SIZE];
+    setvbuf(in, inBuffer, _IOFBF, sizeof(inBuffer));
+    setvbuf(out, outBuffer, _IOFBF, sizeof(outBuffer));
+
+    char *line = NULL; // grown by getline, so a full cart fits on one line
+    size_t lineSize = 0;
+    size_t lineNumber = 0;
+    size_t failures = 0;
+    Product product;
+    char amount[CENTS_BUF_SIZE];
+
+    while (getline(&line, &lineSize, in) != -1) {
+        lineNumber++;
+        const char *end = line + strcspn(line, "\r\n");
+        const char *p = skipBlanks(line, end);
+        if (p == end || *p == '#') {
+            continue;
+        }
+        const char *command = p;
+        while (p < end && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        int length = (int)(p - command);
+        const char *error = NULL;
+
+        if (length == 3 && strncmp(command, "add", 3) == 0) {
+            if (parseRecordLine(p, end, &product) != INV_OK) {
+                error = "invalid";
+            } else {
+                error = batchError(inv_add(inv, product.id, product.name, product.priceCents, product.quantity));
+            }
+            if (error == NULL) {
+                fprintf(out, "OK add %d\n", product.id);
+            }
+        } else if (length == 6 && strncmp(command, "update", 6) == 0) {
+            if (parseRecordLine(p, end, &product) != INV_OK) {
+                error = "invalid";
+            } else {
+                error = batchError(inv_update(inv, product.id, product.name, product.priceCents, product.quantity));
+            }
+            if (error == NULL) {
+                fprintf(out, "OK update %d\n", product.id);
+            }
+        } else if ((length == 6 && strncmp(command, "delete", 6) == 0) ||
+                   (length == 6 && strncmp(command, "search", 6) == 0)) {
+            int id;
+            const char *rest = scanInt(skipBlanks(p, end), end, &id);
+            if (rest == NULL || skipBlanks(rest, end) != end) {
+                error = "invalid";
+            } else if (command[0] == 'd') {
+                if ((error = batchError(inv_delete(inv, id))) == NULL) {
+                    fprintf(out, "OK delete %d\n", id);
+                }
+            } else if ((error = batchError(inv_find(inv, id, &product))) == NULL) {
+                fprintf(out, "FOUND %d %s %s %d\n", product.id, product.name, formatCents(product.priceCents, amount), product.quantity);
+            }
+        } else if (length == 4 && strncmp(command, "bill", 4) == 0) {
+            // bill <id> <quantity> [<id> <quantity> ...] sells the whole cart or nothing
+            Cart cart;
+            cart.count = 0;
+            p = skipBlanks(p, end);
+            while (p != NULL && p < end) {
+                int id, quantity;
+                p = scanInt(p, end, &id);
+                p = p != NULL ? scanInt(skipBlanks(p, end), end, &quantity) : NULL;
+                if (p == NULL || cartAdd(&cart, id, quantity) != INV_OK) {
+                    p = NULL;
+                } else {
+                    p = skipBlanks(p, end);
+                }
+            }
+            const LedgerBill *bill;
+            int status = p == NULL || cart.count == 0 ? INV_ERR_INVALID : inv_sell(inv, ledger, &cart, &bill, NULL);
+            if (status == INV_OK) {
+                char price[CENTS_BUF_SIZE];
+                for (size_t i = 0; i < bill->lineCount; i++) {
+                    const SaleLine *line = &ledger->lines[bill->firstLine + i];
+                    fprintf(out, "LINE %d %s %s %d %s\n", line->id, inventoryName(inv, inventoryFind(inv, line->id)), formatCents(line->priceCents, price),
+                            line->quantity, formatCents((long long)line->priceCents * line->quantity, amount));
+                }
+                fprintf(out, "BILL %llu %s\n", (unsigned long long)bill->number, formatCents(bill->totalCents, amount));
+            } else {
+                error = batchError(status);
+            }
+        } else if (length == 5 && strncmp(command, "total", 5) == 0) {
+            fprintf(out, "TOTAL %s\n", formatCents(calculateTotalSales(ledger), amount));
+        } else if (length == 5 && strncmp(command, "value", 5) == 0) {
+            fprintf(out, "VALUE %s\n", formatCents(calculateStockValue(inv), amount));
+        } else if ((length == 5 && strncmp(command, "stats", 5) == 0) ||
+                   (length == 5 && strncmp(command, "check", 5) == 0)) {
+            InventoryTotals totals, recounted;
+            inventoryTotals(inv, &totals);
+            if (command[0] == 's') {
+                fprintf(out, "STATS %s %lld %zu %zu\n", formatCents(totals.stockValueCents, amount), totals.units,
+                        totals.skus, totals.lowStock);
+            } else {
+                inventoryRecount(inv, &recounted);
+                if (memcmp(&totals, &recounted, sizeof(totals)) == 0) {
+                    fprintf(out, "OK check\n");
+                } else {
+                    error = "mismatch";
+                }
+            }
+        } else if (length == 8 && strncmp(command, "lowstock", 8) == 0) {
+            int threshold;
+            const char *rest = scanInt(skipBlanks(p, end), end, &threshold);
+            if (rest == NULL || skipBlanks(rest, end) != end) {
+                error = "invalid";
+            } else {
+                inventorySetLowStock(inv, threshold);
+                fprintf(out, "OK lowstock %zu\n", inv->lowStock);
+            }
+        } else if ((length == 5 && strncmp(command, "range", 5) == 0) ||
+                   (length == 3 && strncmp(command, "top", 3) == 0) ||
+                   (length == 6 && strncmp(command, "bottom", 6) == 0)) {
+            // range <price|quantity> <low> <high>, or top|bottom <price|quantity> <count>
+            int isRange = command[0] == 'r';
+            p = skipBlanks(p, end);
+            const char *word = p;
+            while (p < end && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            int column = -1;
+            if (p - word == 5 && strncmp(word, "price", 5) == 0) {
+                column = ORDER_PRICE;
+            } else if (p - word == 8 && strncmp(word, "quantity", 8) == 0) {
+                column = ORDER_QUANTITY;
+            }
+
+            int low = 0, high = 0, wanted = 0;
+            if (column < 0) {
+                p = NULL;
+            } else if (!isRange) {
+                p = scanInt(skipBlanks(p, end), end, &wanted);
+            } else if (column == ORDER_PRICE) {
+                p = scanCents(skipBlanks(p, end), end, &low);
+                p = p != NULL ? scanCents(skipBlanks(p, end), end, &high) : NULL;
+            } else {
+                p = scanInt(skipBlanks(p, end), end, &low);
+                p = p != NULL ? scanInt(skipBlanks(p, end), end, &high) : NULL;
+            }
+
+            size_t limit = isRange || (size_t)wanted > inv->liveCount ? inv->liveCount : (size_t)wanted;
+            size_t *slots = NULL;
+            size_t found = 0;
+            if (p == NULL || wanted < 0 || skipBlanks(p, end) != end) {
+                error = "invalid";
+            } else if ((slots = (size_t *)malloc((limit ? limit : 1) * sizeof(size_t))) == NULL) {
+                error = "memory";
+            } else {
+                found = isRange ? inventoryRange(inv, column, low, high, slots, limit)
+                                : inventoryTop(inv, column, command[0] == 't', limit, slots);
+                if (found == NO_SLOT) {
+                    error = "memory";
+                }
+            }
+            if (error == NULL) {
+                for (size_t i = 0; i < found; i++) {
+                    batchPrintProduct(out, "ITEM", inv, slots[i]);
+                }
+                fprintf(out, "OK %.*s %zu\n", length, command, found);
+            }
+            free(slots);
+        } else if ((length == 4 && strncmp(command, "find", 4) == 0) ||
+                   (length == 6 && strncmp(command, "prefix", 6) == 0)) {
+            // find <text> matches anywhere in the name, prefix <text> only at its start
+            const char *query = skipBlanks(p, end);
+            p = query;
+            while (p < end && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            char text[NAME_SIZE];
+            size_t queryLength = (size_t)(p - query);
+            size_t *slots = NULL;
+            size_t found = 0;
+            if (queryLength == 0 || queryLength >= NAME_SIZE || skipBlanks(p, end) != end) {
+                error = "invalid";
+            } else if ((slots = (size_t *)malloc((inv->liveCount ? inv->liveCount : 1) * sizeof(size_t))) == NULL) {
+                error = "memory";
+            } else {
+                memcpy(text, query, queryLength);
+                text[queryLength] = '\0';
+                found = inventorySearchName(inv, text, command[0] == 'p', slots, inv->liveCount);
+                if (found == NO_SLOT) {
+                    error = "memory";
+                }
+            }
+            if (error == NULL) {
+                for (size_t i = 0; i < found; i++) {
+                    batchPrintProduct(out, "FOUND", inv, slots[i]);
+                }
+                fprintf(out, "OK %.*s %zu\n", length, command, found);
+            }
+            free(slots);
+        } else if ((length == 7 && strncmp(command, "revenue", 7) == 0) ||
+                   (length == 7 && strncmp(command, "sellers", 7) == 0)) {
+            // revenue <id> <days>, or sellers <count> <days>, over the days up to today
+            int number, days;
+            p = scanInt(skipBlanks(p, end), end, &number);
+            p = p != NULL ? scanInt(skipBlanks(p, end), end, &days) : NULL;
+            int32_t today = historyDay((int64_t)time(NULL));
+            if (p == NULL || days < 0 || skipBlanks(p, end) != end || (command[0] == 's' && number < 0)) {
+                error = "invalid";
+            } else if (ledger->history == NULL) {
+                error = "nohistory";
+            } else if (command[0] == 'r') {
+                ProductSales sales;
+                historyProductSales(ledger->history, number, today - days + 1, today, &sales);
+                fprintf(out, "REVENUE %d %lld %s\n", number, (long long)sales.units, formatCents(sales.revenueCents, amount));
+            } else {
+                ProductSales *top = (ProductSales *)malloc((number ? (size_t)number : 1) * sizeof(ProductSales));
+                if (top == NULL) {
+                    error = "memory";
+                } else {
+                    size_t found = historyTopSellers(ledger->history, today - days + 1, today, 1, (size_t)number, top);
+                    for (size_t i = 0; i < found; i++) {
+                        fprintf(out, "SELLER %d %lld %s\n", top[i].id, (long long)top[i].units, formatCents(top[i].revenueCents, amount));
+                    }
+                    fprintf(out, "OK sellers %zu\n", found);
+                    free(top);
+                }
+            }
+        } else if ((length == 7 && strncmp(command, "reorder", 7) == 0) ||
+                   (length == 4 && strncmp(command, "rule", 4) == 0)) {
+            // reorder <count>, or rule <id> <point> <order units>
+            int number, point = 0, units = 0;
+            int isRule = command[1] == 'u';
+            p = scanInt(skipBlanks(p, end), end, &number);
+            if (isRule) {
+                p = p != NULL ? scanInt(skipBlanks(p, end), end, &point) : NULL;
+                p = p != NULL ? scanInt(skipBlanks(p, end), end, &units) : NULL;
+            }
+            if (p == NULL || skipBlanks(p, end) != end || (!isRule && number < 0)) {
+                error = "invalid";
+            } else if (inv->reorder == NULL) {
+                error = "noreorder";
+            } else if (isRule) {
+                int status = reorderSetRule(inv, number, point, units);
+                if (status != INV_OK) {
+                    error = status == INV_ERR_NOT_FOUND ? "notfound" : "invalid";
+                } else if (inv->wal != NULL && reorderSaveRules(inv->reorder, REORDER_FILE) != INV_OK) {
+                    error = "io";
+                } else {
+                    fprintf(out, "OK rule %d\n", number);
+                }
+            } else {
+                ReorderItem *items = (ReorderItem *)malloc((number ? (size_t)number : 1) * sizeof(ReorderItem));
+                if (items == NULL) {
+                    error = "memory";
+                } else {
+                    size_t found = reorderDue(inv->reorder, (int64_t)time(NULL), items, (size_t)number);
+                    for (size_t i = 0; i < found; i++) {
+                        fprintf(out, "REORDER %d %d %d ", items[i].id, items[i].quantity, items[i].point);
+                        if (isinf(items[i].daysOfCover)) {
+                            fprintf(out, "- %d\n", items[i].orderUnits);
+                        } else {
+                            fprintf(out, "%.1f %d\n", items[i].daysOfCover, items[i].orderUnits);
+                        }
+                    }
+                    fprintf(out, "OK reorder %zu\n", found);
+                    free(items);
+                }
+            }
+        } else if (length == 5 && strncmp(command, "order", 5) == 0) {
+            const char *path = skipBlanks(p, end);
+            char file[BATCH_PATH_SIZE];
+            size_t lines;
+            long long total;
+            if (path == end || end - path >= (long)sizeof(file)) {
+                error = "invalid";
+            } else if (inv->reorder == NULL) {
+                error = "noreorder";
+            } else {
+                memcpy(file, path, (size_t)(end - path));
+                file[end - path] = '\0';
+                int status = reorderWritePurchaseOrder(inv, file, (int64_t)time(NULL), &lines, &total);
+                if (status != INV_OK) {
+                    error = status == INV_ERR_NOMEM ? "memory" : "io";
+                } else {
+                    fprintf(out, "OK order %zu %s\n", lines, formatCents(total, amount));
+                }
+            }
+        } else {
+            error = "unknown";
+        }
+
+        if (error != NULL) {
+            failures++;
+            fprintf(out, "ERR %zu %.*s %s\n", lineNumber, length, command, error);
+        }
+    }
+    free(line);
+
+    if (inventoryCommit(inv) != INV_OK) {
+        fprintf(out, "ERR %zu wal io\n", lineNumber);
+        failures++;
+    }
+    if (ledgerSync(ledger) != INV_OK) {
+        fprintf(out, "ERR %zu ledger io\n", lineNumber);
+        failures++;
+    }
+    fflush(out);
+    return failures;
+}
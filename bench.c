@@ -0,0 +1,1776 @@
+/**
+ * @file bench.c
+ * @brief Benchmarks of the inventory engine, run with "supermarket --bench <name>".
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "frontend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+// Linked-list node: the layout products were stored in before the column store,
+// with a float price. It is only kept as the baseline for benchmarks.
+typedef struct node {
+    int id;
+    char name[NAME_SIZE];
+    float price;
+    int quantity;
+    struct node *next;
+} Node;
+
+/**
+ * @brief Returns the next value of a small xorshift generator, used for benchmark workloads.
+ *
+ * @param state Pointer to the generator state (must be non-zero).
+ * @return Next pseudo-random value.
+ */
+uint32_t benchRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/**
+ * @brief Builds a linked list of n synthetic products, newest first, as addProduct used to.
+ *
+ * @param n Number of products.
+ * @return Head of the list, or NULL if memory allocation failed.
+ */
+static Node *benchBuildList(int n) {
+    Node *head = NULL;
+    for (int i = 1; i <= n; i++) {
+        Node *node = (Node *)malloc(sizeof(Node));
+        if (node == NULL) {
+            break;
+        }
+        node->id = i;
+        snprintf(node->name, NAME_SIZE, "item%d", i);
+        node->price = (float)(i % 1000) + 0.99f;
+        node->quantity = i % 50;
+        node->next = head;
+        head = node;
+    }
+    return head;
+}
+
+/**
+ * @brief Frees a list built by benchBuildList.
+ *
+ * @param head Head of the list.
+ */
+static void benchFreeList(Node *head) {
+    while (head != NULL) {
+        Node *next = head->next;
+        free(head);
+        head = next;
+    }
+}
+
+/**
+ * @brief Fills an inventory with n synthetic products matching benchBuildList.
+ *
+ * @param inv Pointer to an empty inventory.
+ * @param n Number of products.
+ * @return 0 on success, -1 if memory allocation failed.
+ */
+static int benchFillInventory(Inventory *inv, int n) {
+    Product product;
+    for (int i = 1; i <= n; i++) {
+        product.id = i;
+        snprintf(product.name, NAME_SIZE, "item%d", i);
+        product.priceCents = (i % 1000) * 100 + 99;
+        product.quantity = i % 50;
+        if (inventoryInsert(inv, &product) == NO_SLOT) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Compares ID lookup latency of the hash index against a linked-list scan.
+ *
+ * For 10k, 100k and 1M products this function times random lookups through the ID index
+ * and through a head-to-tail walk of a linked list, which is how lookups used to work.
+ */
+static void benchLookup(void) {
+    const int sizes[] = {10000, 100000, 1000000};
+
+    printf("%10s %16s %16s %10s\n", "products", "list ns/lookup", "index ns/lookup", "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        Inventory inv;
+        inventoryInit(&inv);
+        Node *list = benchBuildList(n);
+        if (list == NULL || benchFillInventory(&inv, n) != 0) {
+            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+            benchFreeList(list);
+            inventoryFree(&inv);
+            return;
+        }
+
+        uint32_t seed = 12345;
+        long long found = 0;
+
+        // The list scan is O(n) per lookup, so scale its lookup count down to keep runs short
+        int listLookups = 200000000 / n;
+        double start = nowSeconds();
+        for (int i = 0; i < listLookups; i++) {
+            int id = (int)(benchRandom(&seed) % n) + 1;
+            for (Node *head = list; head != NULL; head = head->next) {
+                if (head->id == id) {
+                    found += head->quantity;
+                    break;
+                }
+            }
+        }
+        double listNs = (nowSeconds() - start) * 1e9 / listLookups;
+
+        int indexLookups = 2000000;
+        start = nowSeconds();
+        for (int i = 0; i < indexLookups; i++) {
+            int id = (int)(benchRandom(&seed) % n) + 1;
+            size_t slot = inventoryFind(&inv, id);
+            if (slot != NO_SLOT) {
+                found += inv.quantities[slot];
+            }
+        }
+        double indexNs = (nowSeconds() - start) * 1e9 / indexLookups;
+
+        printf("%10d %16.1f %16.1f %9.0fx\n", n, listNs, indexNs, listNs / indexNs);
+        if (found < 0) { // Keeps the lookups from being optimized away
+            printf("%lld\n", found);
+        }
+        benchFreeList(list);
+        inventoryFree(&inv);
+    }
+}
+
+/**
+ * @brief Times one stock valuation kernel over a pair of columns.
+ *
+ * @param kernel Kernel to time.
+ * @param priceCents Price column, in cents.
+ * @param quantities Quantity column.
+ * @param n Number of slots.
+ * @param repeats Number of passes to average over.
+ * @param total Receives the kernel's result.
+ * @return Average nanoseconds per slot.
+ */
+static double benchKernel(ValuationKernel kernel, const int *priceCents, const int *quantities, size_t n, int repeats, long long *total) {
+    ValuationKernel volatile call = kernel; // stops the compiler hoisting the pure call out of the loop
+    double start = nowSeconds();
+    for (int r = 0; r < repeats; r++) {
+        *total = call(priceCents, quantities, n);
+    }
+    return (nowSeconds() - start) * 1e9 / ((double)n * repeats);
+}
+
+/**
+ * @brief Compares the old float list loop against the scalar and SIMD valuation kernels.
+ *
+ * Reports nanoseconds per product for each path, and the totals so the float rounding error
+ * is visible. The integer kernels must agree exactly.
+ */
+static void benchValuation(void) {
+    const int sizes[] = {10000, 100000, 1000000};
+    char buf[CENTS_BUF_SIZE];
+
+    printf("%10s %12s %12s %12s %12s %20s %20s\n", "products", "list float", "scalar", "sse4.1", "avx2", "float total", "exact total");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        int repeats = 50000000 / n;
+        int *priceCents = (int *)malloc(n * sizeof(int));
+        int *quantities = (int *)malloc(n * sizeof(int));
+        Node *list = benchBuildList(n);
+        if (priceCents == NULL || quantities == NULL || list == NULL) {
+            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+            free(priceCents);
+            free(quantities);
+            benchFreeList(list);
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            priceCents[i] = ((i + 1) % 1000) * 100 + 99;
+            quantities[i] = (i + 1) % 50;
+        }
+
+        // The loop the original total-sales function ran
+        float floatTotal = 0;
+        double start = nowSeconds();
+        for (int r = 0; r < repeats; r++) {
+            floatTotal = 0;
+            for (Node *head = list; head != NULL; head = head->next) {
+                floatTotal += head->price * head->quantity;
+            }
+        }
+        double listNs = (nowSeconds() - start) * 1e9 / ((double)n * repeats);
+
+        long long scalarTotal = 0;
+        double scalarNs = benchKernel(valuationScalar, priceCents, quantities, n, repeats, &scalarTotal);
+        double sseNs = 0, avxNs = 0;
+#ifdef HAVE_X86_SIMD
+        __builtin_cpu_init();
+        long long simdTotal = 0;
+        if (__builtin_cpu_supports("sse4.1")) {
+            sseNs = benchKernel(valuationSse41, priceCents, quantities, n, repeats, &simdTotal);
+            if (simdTotal != scalarTotal) {
+                printf(ANSI_COLOR_RED"SSE4.1 kernel disagrees with scalar kernel.\n"ANSI_COLOR_RESET);
+            }
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            avxNs = benchKernel(valuationAvx2, priceCents, quantities, n, repeats, &simdTotal);
+            if (simdTotal != scalarTotal) {
+                printf(ANSI_COLOR_RED"AVX2 kernel disagrees with scalar kernel.\n"ANSI_COLOR_RESET);
+            }
+        }
+#endif
+
+        printf("%10d %9.3f ns %9.3f ns %9.3f ns %9.3f ns %20.2f %20s\n", n, listNs, scalarNs, sseNs, avxNs, floatTotal, formatCents(scalarTotal, buf));
+        free(priceCents);
+        free(quantities);
+        benchFreeList(list);
+    }
+    printf("(0 ns means the CPU does not support that kernel)\n");
+}
+
+/**
+ * @brief Compares restoring a text backup into per-node mallocs against the column store.
+ *
+ * Writes a 1M-line backup, then restores it three ways: the old list restore (fscanf and one
+ * malloc per line, one free per node on teardown), the streaming text loader, and a binary
+ * snapshot. Reports allocator calls, times and records per second.
+ */
+static void benchRestore(void) {
+    const int n = 1000000;
+    const char *path = "bench_inventory_backup.txt";
+    Inventory inv;
+    inventoryInit(&inv);
+
+    if (benchFillInventory(&inv, n) != 0 || inventorySaveText(&inv, path) != INV_OK) {
+        printf(ANSI_COLOR_RED"Could not create the benchmark backup.\n"ANSI_COLOR_RESET);
+        inventoryFree(&inv);
+        return;
+    }
+    inventoryFree(&inv);
+
+    // The old restore: parse each line into its own malloc'd node, then free them one by one
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf(ANSI_COLOR_RED"Could not read the benchmark backup.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    Node *head = NULL;
+    size_t listAllocations = 0;
+    double start = nowSeconds();
+    Node scratch;
+    while (fscanf(fp, "%d %99s %f %d", &scratch.id, scratch.name, &scratch.price, &scratch.quantity) == 4) {
+        Node *node = (Node *)malloc(sizeof(Node));
+        if (node == NULL) {
+            break;
+        }
+        listAllocations++;
+        *node = scratch;
+        node->next = head;
+        head = node;
+    }
+    double listLoad = nowSeconds() - start;
+    fclose(fp);
+    start = nowSeconds();
+    benchFreeList(head);
+    double listFree = nowSeconds() - start;
+
+    storeAllocations = 0;
+    start = nowSeconds();
+    inventoryLoadText(&inv, path, NULL);
+    double textLoad = nowSeconds() - start;
+    size_t textAllocations = storeAllocations;
+
+    const char *snapshotPath = "bench_inventory_snapshot.bin";
+    inventorySaveSnapshot(&inv, snapshotPath, 0);
+    storeAllocations = 0;
+    start = nowSeconds();
+    inventoryLoadSnapshot(&inv, snapshotPath, NULL, NULL);
+    double snapshotLoad = nowSeconds() - start;
+    size_t snapshotAllocations = storeAllocations;
+
+    start = nowSeconds();
+    inventoryFree(&inv);
+    double storeFree = nowSeconds() - start;
+    remove(path);
+    remove(snapshotPath);
+
+    printf("%-28s %14s %12s %14s %12s\n", "restore of 1M lines", "allocations", "load s", "records/s", "teardown s");
+    printf("%-28s %14zu %12.3f %14.0f %12.3f\n", "list, fscanf + malloc/node", listAllocations + listAllocations, listLoad, n / listLoad, listFree);
+    printf("%-28s %14zu %12.3f %14.0f %12.3f\n", "column store, streamed text", textAllocations, textLoad, n / textLoad, storeFree);
+    printf("%-28s %14zu %12.3f %14.0f %12s\n", "column store, snapshot", snapshotAllocations, snapshotLoad, n / snapshotLoad, "-");
+    printf("(list allocations count one malloc and one free per node)\n");
+}
+
+/**
+ * @brief Removes a benchmark's sales history directory and every month file in it.
+ *
+ * @param dir Directory path.
+ */
+static void benchRemoveHistory(const char *dir) {
+    DIR *listing = opendir(dir);
+    if (listing == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(listing)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            remove(path);
+        }
+    }
+    closedir(listing);
+    rmdir(dir);
+}
+
+/**
+ * @brief Times the sales history on three years of bills: opening it from raw month files and
+ * from rollups, one product's revenue over 90 days, and this month's top 20 sellers, against
+ * scanning every bill line for the same answers.
+ */
+static void benchHistory(void) {
+    const char *dir = "bench_sales_history";
+    const int products = 5000, days = 3 * 365, billsPerDay = 300, linesPerBill = 10;
+    int32_t today = historyDay((int64_t)time(NULL));
+    size_t lineCount = (size_t)days * billsPerDay * linesPerBill;
+    HistoryLine *lines = (HistoryLine *)malloc(lineCount * sizeof(HistoryLine));
+    SalesHistory history;
+    historyInit(&history);
+    benchRemoveHistory(dir);
+    if (lines == NULL || historyOpen(&history, dir) != INV_OK) {
+        printf(ANSI_COLOR_RED"Could not create the benchmark history.\n"ANSI_COLOR_RESET);
+        free(lines);
+        return;
+    }
+
+    // Popular products sell far more often: squaring a uniform number skews IDs toward 1
+    uint32_t seed = 12345;
+    size_t n = 0;
+    uint64_t billNumber = 0;
+    for (int32_t day = today - days + 1; day <= today; day++) {
+        int year, month, dayOfMonth;
+        historyDate(day, &year, &month, &dayOfMonth);
+        struct tm noon;
+        memset(&noon, 0, sizeof(noon));
+        noon.tm_year = year - 1900;
+        noon.tm_mon = month - 1;
+        noon.tm_mday = dayOfMonth;
+        noon.tm_hour = 12;
+        noon.tm_isdst = -1;
+        int64_t when = (int64_t)mktime(&noon);
+        for (int b = 0; b < billsPerDay; b++) {
+            SaleLine bill[10];
+            for (int i = 0; i < linesPerBill; i++) {
+                double u = (benchRandom(&seed) % 1000000) / 1e6;
+                bill[i].id = 1 + (int)(u * u * products);
+                bill[i].quantity = 1 + (int)(benchRandom(&seed) % 5);
+                bill[i].priceCents = 100 + bill[i].id % 2000;
+                lines[n++] = (HistoryLine){billNumber + 1, day, bill[i].id, bill[i].quantity, bill[i].priceCents};
+            }
+            if (historyRecord(&history, ++billNumber, when, bill, (size_t)linesPerBill) != INV_OK) {
+                printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+                historyFree(&history);
+                free(lines);
+                return;
+            }
+        }
+    }
+    double start = nowSeconds();
+    int synced = historySync(&history);
+    double syncTime = nowSeconds() - start;
+    historyFree(&history);
+
+    start = nowSeconds();
+    int opened = synced == INV_OK ? historyOpen(&history, dir) : synced;
+    double rawOpen = nowSeconds() - start;
+    historyFree(&history);
+    start = nowSeconds();
+    opened = opened == INV_OK ? historyOpen(&history, dir) : opened;
+    double rollupOpen = nowSeconds() - start;
+    if (opened != INV_OK) {
+        printf(ANSI_COLOR_RED"Could not reopen the benchmark history.\n"ANSI_COLOR_RESET);
+        historyFree(&history);
+        benchRemoveHistory(dir);
+        free(lines);
+        return;
+    }
+
+    // One product's revenue over the last 90 days, for many products
+    const int queries = 100000;
+    long long checksum = 0;
+    ProductSales sales;
+    start = nowSeconds();
+    for (int q = 0; q < queries; q++) {
+        historyProductSales(&history, 1 + q % products, today - 89, today, &sales);
+        checksum += sales.revenueCents;
+    }
+    double productQuery = (nowSeconds() - start) / queries;
+    int scans = 20;
+    long long scanned = 0;
+    start = nowSeconds();
+    for (int q = 0; q < scans; q++) {
+        int id = 1 + q % products;
+        for (size_t i = 0; i < lineCount; i++) {
+            if (lines[i].id == id && lines[i].day >= today - 89) {
+                scanned += (long long)lines[i].quantity * lines[i].priceCents;
+            }
+        }
+    }
+    double productScan = (nowSeconds() - start) / scans;
+
+    // This month's top 20 sellers by revenue
+    int year, month, dayOfMonth;
+    historyDate(today, &year, &month, &dayOfMonth);
+    ProductSales top[20];
+    const int topQueries = 1000;
+    size_t found = 0;
+    start = nowSeconds();
+    for (int q = 0; q < topQueries; q++) {
+        found = historyTopSellers(&history, today - dayOfMonth + 1, today, 1, 20, top);
+    }
+    double topQuery = (nowSeconds() - start) / topQueries;
+    int64_t *revenue = (int64_t *)calloc((size_t)products + 1, sizeof(int64_t));
+    double topScan = 0;
+    if (revenue != NULL) {
+        start = nowSeconds();
+        for (size_t i = 0; i < lineCount; i++) {
+            if (lines[i].day >= today - dayOfMonth + 1) {
+                revenue[lines[i].id] += (int64_t)lines[i].quantity * lines[i].priceCents;
+            }
+        }
+        int64_t best = 0;
+        for (int id = 1; id <= products; id++) {
+            best = revenue[id] > best ? revenue[id] : best;
+        }
+        topScan = nowSeconds() - start;
+        checksum += best;
+        free(revenue);
+    }
+
+    printf("%zu bill lines over %d days, %d products\n", lineCount, days, products);
+    printf("%-36s %12s\n", "operation", "ms");
+    printf("%-36s %12.3f\n", "sync to month files", syncTime * 1e3);
+    printf("%-36s %12.3f\n", "open, scanning month files", rawOpen * 1e3);
+    printf("%-36s %12.3f\n", "open, from rollups", rollupOpen * 1e3);
+    printf("%-36s %12.6f\n", "product revenue, last 90 days", productQuery * 1e3);
+    printf("%-36s %12.3f\n", "  same, scanning every line", productScan * 1e3);
+    printf("%-36s %12.6f\n", "top 20 sellers this month", topQuery * 1e3);
+    printf("%-36s %12.3f\n", "  same, scanning every line", topScan * 1e3);
+    printf("(%zu top sellers; checksum %lld)\n", found, checksum + scanned);
+    historyFree(&history);
+    benchRemoveHistory(dir);
+    free(lines);
+}
+
+/**
+ * @brief Compares listing 1M products with one printf per row against the buffered report
+ * renderer, in each report format, all written to /dev/null.
+ */
+static void benchReport(void) {
+    const int n = 1000000;
+    static const char *const labels[] = {"report table", "report csv", "report tsv"};
+    Inventory inv;
+    inventoryInit(&inv);
+    FILE *sink = fopen("/dev/null", "w");
+    int fd = open("/dev/null", O_WRONLY);
+    if (sink == NULL || fd < 0 || benchFillInventory(&inv, n) != 0) {
+        printf(ANSI_COLOR_RED"Could not set up the report benchmark.\n"ANSI_COLOR_RESET);
+        if (sink != NULL) {
+            fclose(sink);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        inventoryFree(&inv);
+        return;
+    }
+
+    printf("%-20s %10s %14s %10s\n", "1M-row listing", "seconds", "rows/s", "speedup");
+    double start = nowSeconds();
+    char price[CENTS_BUF_SIZE];
+    Product product;
+    size_t cursor = 0;
+    while (inv_next(&inv, &cursor, &product)) {
+        fprintf(sink, "%d\t     \t%s\t%s\t%d\n", product.id, product.name, formatCents(product.priceCents, price), product.quantity);
+    }
+    fflush(sink);
+    double baseline = nowSeconds() - start;
+    printf("%-20s %10.3f %14.0f %9.2fx\n", "printf per row", baseline, n / baseline, 1.0);
+
+    for (int format = REPORT_TABLE; format <= REPORT_TSV; format++) {
+        start = nowSeconds();
+        long long rows = reportProducts(&inv, fd, format, 0);
+        double seconds = nowSeconds() - start;
+        if (rows != n) {
+            printf(ANSI_COLOR_RED"Report failed.\n"ANSI_COLOR_RESET);
+            break;
+        }
+        printf("%-20s %10.3f %14.0f %9.2fx\n", labels[format], seconds, n / seconds, baseline / seconds);
+    }
+    fclose(sink);
+    close(fd);
+    inventoryFree(&inv);
+}
+
+/**
+ * @brief Measures how the parallel text loader scales with the number of threads.
+ *
+ * Writes a 2M-line backup and loads it with 1, 2, 4, 8 and 16 parser threads, next to the
+ * single-threaded streaming loader.
+ */
+static void benchParse(void) {
+    const int n = 2000000;
+    const int threadCounts[] = {1, 2, 4, 8, 16};
+    const char *path = "bench_inventory_backup.txt";
+    Inventory inv;
+    inventoryInit(&inv);
+
+    if (benchFillInventory(&inv, n) != 0 || inventorySaveText(&inv, path) != INV_OK) {
+        printf(ANSI_COLOR_RED"Could not create the benchmark backup.\n"ANSI_COLOR_RESET);
+        inventoryFree(&inv);
+        return;
+    }
+
+    printf("%-20s %10s %14s %10s\n", "2M-line text load", "seconds", "records/s", "speedup");
+    double start = nowSeconds();
+    inventoryLoadText(&inv, path, NULL);
+    double streaming = nowSeconds() - start;
+    printf("%-20s %10.3f %14.0f %9.2fx\n", "streaming", streaming, n / streaming, 1.0);
+
+    for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+        size_t records = 0;
+        start = nowSeconds();
+        int status = inventoryLoadTextParallel(&inv, path, threadCounts[t], &records);
+        double seconds = nowSeconds() - start;
+        if (status != INV_OK || records != (size_t)n) {
+            printf(ANSI_COLOR_RED"Parallel load failed.\n"ANSI_COLOR_RESET);
+            break;
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%d thread%s", threadCounts[t], threadCounts[t] == 1 ? "" : "s");
+        printf("%-20s %10.3f %14.0f %9.2fx\n", label, seconds, n / seconds, streaming / seconds);
+    }
+    printf("(%ld CPUs online)\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    inventoryFree(&inv);
+    remove(path);
+}
+
+/**
+ * @brief Compares price-band and top-K queries through the ordered indexes against full scans.
+ *
+ * For 10k, 100k and 1M products this function times the one-off index build, then random
+ * one-price-point band queries and top-10 queries answered both ways.
+ */
+static void benchRange(void) {
+    const int sizes[] = {10000, 100000, 1000000};
+    const int queries = 200;
+
+    printf("%10s %10s %14s %14s %14s %14s\n", "products", "build ms", "scan band us", "index band us", "scan top10 us", "index top10 us");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        Inventory inv;
+        inventoryInit(&inv);
+        size_t *slots = (size_t *)malloc((size_t)n * sizeof(size_t));
+        if (slots == NULL || benchFillInventory(&inv, n) != 0) {
+            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+            free(slots);
+            inventoryFree(&inv);
+            return;
+        }
+
+        double start = nowSeconds();
+        inventoryTop(&inv, ORDER_PRICE, 1, 0, slots);
+        double buildMs = (nowSeconds() - start) * 1e3;
+
+        uint32_t seed = 12345;
+        size_t found = 0;
+        start = nowSeconds();
+        for (int q = 0; q < queries; q++) {
+            int price = (int)(benchRandom(&seed) % 1000) * 100 + 99;
+            size_t matches = 0;
+            for (size_t i = 0; i < inv.count; i++) {
+                if (inv.live[i] && inv.priceCents[i] >= price && inv.priceCents[i] <= price) {
+                    slots[matches++] = i;
+                }
+            }
+            found += matches;
+        }
+        double scanBandUs = (nowSeconds() - start) * 1e6 / queries;
+
+        start = nowSeconds();
+        for (int q = 0; q < queries; q++) {
+            int price = (int)(benchRandom(&seed) % 1000) * 100 + 99;
+            found += inventoryRange(&inv, ORDER_PRICE, price, price, slots, (size_t)n);
+        }
+        double indexBandUs = (nowSeconds() - start) * 1e6 / queries;
+
+        // The scan keeps the ten most expensive products seen so far by insertion
+        start = nowSeconds();
+        for (int q = 0; q < queries; q++) {
+            size_t kept = 0;
+            for (size_t i = 0; i < inv.count; i++) {
+                if (!inv.live[i] || (kept == 10 && inv.priceCents[i] <= inv.priceCents[slots[9]])) {
+                    continue;
+                }
+                size_t j = kept < 10 ? kept++ : 9;
+                while (j > 0 && inv.priceCents[slots[j - 1]] < inv.priceCents[i]) {
+                    slots[j] = slots[j - 1];
+                    j--;
+                }
+                slots[j] = i;
+            }
+            found += kept;
+        }
+        double scanTopUs = (nowSeconds() - start) * 1e6 / queries;
+
+        start = nowSeconds();
+        for (int q = 0; q < queries; q++) {
+            found += inventoryTop(&inv, ORDER_PRICE, 1, 10, slots);
+        }
+        double indexTopUs = (nowSeconds() - start) * 1e6 / queries;
+
+        printf("%10d %10.1f %14.1f %14.1f %14.1f %14.2f\n", n, buildMs, scanBandUs, indexBandUs, scanTopUs, indexTopUs);
+        if (found == 0) { // Keeps the queries from being optimized away
+            printf("%zu\n", found);
+        }
+        free(slots);
+        inventoryFree(&inv);
+    }
+}
+
+/**
+ * @brief Compares the quantiles of a sorted latency sample, for qsort.
+ */
+int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Measures name search latency over a 500k-product catalogue.
+ *
+ * Names are built from brand, product and pack-size words. Random substrings and prefixes of
+ * existing names are looked up, a screenful of matches at a time, through the trigram index
+ * and by scanning the names, and the latency percentiles of each are reported.
+ */
+static void benchNames(void) {
+    static const char *brands[] = {"amul", "nestle", "britannia", "tata", "haldiram", "parle", "dabur", "patanjali", "mtr", "aashirvaad"};
+    static const char *items[] = {"milk", "butter", "cheese", "biscuit", "tea", "salt", "namkeen", "honey", "atta", "ghee", "curd", "coffee", "noodles", "juice", "paneer"};
+    const int n = 500000;
+    const int queries = 2000;
+
+    Inventory inv;
+    inventoryInit(&inv);
+    double *indexNs = (double *)malloc(queries * sizeof(double));
+    double *scanNs = (double *)malloc(queries * sizeof(double));
+    size_t *slots = (size_t *)malloc(NAME_SEARCH_LIMIT * sizeof(size_t));
+    Product product;
+    uint32_t seed = 12345;
+    int ok = indexNs != NULL && scanNs != NULL && slots != NULL;
+    for (int i = 1; ok && i <= n; i++) {
+        product.id = i;
+        snprintf(product.name, NAME_SIZE, "%s_%s_%dg", brands[benchRandom(&seed) % 10], items[benchRandom(&seed) % 15], (int)(benchRandom(&seed) % 2000));
+        product.priceCents = (i % 1000) * 100 + 99;
+        product.quantity = i % 50;
+        ok = inventoryInsert(&inv, &product) != NO_SLOT;
+    }
+    if (!ok) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        free(indexNs);
+        free(scanNs);
+        free(slots);
+        inventoryFree(&inv);
+        return;
+    }
+
+    double start = nowSeconds();
+    inventorySearchName(&inv, "warm", 0, slots, NAME_SEARCH_LIMIT);
+    double buildMs = (nowSeconds() - start) * 1e3;
+
+    size_t found = 0;
+    char query[NAME_SIZE];
+    for (int q = 0; q < queries; q++) {
+        const char *name = inventoryName(&inv, benchRandom(&seed) % inv.count);
+        size_t length = strlen(name);
+        size_t queryLength = 3 + benchRandom(&seed) % 6;
+        size_t offset = q % 2 ? 0 : benchRandom(&seed) % (length - 2);
+        if (offset + queryLength > length) {
+            queryLength = length - offset;
+        }
+        memcpy(query, name + offset, queryLength);
+        query[queryLength] = '\0';
+
+        start = nowSeconds();
+        found += inventorySearchName(&inv, query, q % 2, slots, NAME_SEARCH_LIMIT);
+        indexNs[q] = (nowSeconds() - start) * 1e9;
+
+        // The scan stops at the same point as the index: once a screenful is exceeded
+        start = nowSeconds();
+        size_t matches = 0;
+        for (size_t i = 0; i < inv.count && matches <= NAME_SEARCH_LIMIT; i++) {
+            matches += inv.live[i] && nameMatches(inventoryName(&inv, i), query, queryLength, q % 2);
+        }
+        found += matches;
+        scanNs[q] = (nowSeconds() - start) * 1e9;
+    }
+    qsort(indexNs, queries, sizeof(double), compareDoubles);
+    qsort(scanNs, queries, sizeof(double), compareDoubles);
+
+    printf("name search over %d products, %d queries (index built in %.1f ms)\n", n, queries, buildMs);
+    printf("%-14s %12s %12s %12s %12s\n", "", "p50 us", "p90 us", "p99 us", "max us");
+    printf("%-14s %12.1f %12.1f %12.1f %12.1f\n", "trigram index", indexNs[queries / 2] / 1e3, indexNs[queries * 9 / 10] / 1e3, indexNs[queries * 99 / 100] / 1e3, indexNs[queries - 1] / 1e3);
+    printf("%-14s %12.1f %12.1f %12.1f %12.1f\n", "full scan", scanNs[queries / 2] / 1e3, scanNs[queries * 9 / 10] / 1e3, scanNs[queries * 99 / 100] / 1e3, scanNs[queries - 1] / 1e3);
+    if (found == 0) { // Keeps the searches from being optimized away
+        printf("%zu\n", found);
+    }
+    free(indexNs);
+    free(scanNs);
+    free(slots);
+    inventoryFree(&inv);
+}
+
+/**
+ * @brief Reports resident bytes per product for the linked list, the old fixed-width name
+ * column and the interned name arena.
+ *
+ * Fills 1M products whose names (brand, product and pack size, about 15 characters) repeat
+ * the way a real catalogue's do, then totals the allocated capacity of every structure.
+ */
+static void benchMemory(void) {
+    static const char *brands[] = {"amul", "nestle", "britannia", "tata", "haldiram", "parle", "dabur", "patanjali", "mtr", "aashirvaad"};
+    static const char *items[] = {"milk", "butter", "cheese", "biscuit", "tea", "salt", "namkeen", "honey", "atta", "ghee", "curd", "coffee", "noodles", "juice", "paneer"};
+    const int n = 1000000;
+    Inventory inv;
+    inventoryInit(&inv);
+    Product product;
+    uint32_t seed = 12345;
+    size_t nameBytes = 0;
+    for (int i = 1; i <= n; i++) {
+        product.id = i;
+        snprintf(product.name, NAME_SIZE, "%s_%s_%dg", brands[benchRandom(&seed) % 10], items[benchRandom(&seed) % 15], (int)(benchRandom(&seed) % 2000));
+        product.priceCents = (i % 1000) * 100 + 99;
+        product.quantity = i % 50;
+        nameBytes += strlen(product.name);
+        if (inventoryInsert(&inv, &product) == NO_SLOT) {
+            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+            inventoryFree(&inv);
+            return;
+        }
+    }
+
+    // Each malloc'd list node also pays for the allocator's header
+    double listBytes = sizeof(Node) + 2 * sizeof(size_t);
+    double columns = (double)inv.capacity * (3 * sizeof(int) + 1 + sizeof(NameRef)) / n;
+    double index = (double)inv.index.capacity * sizeof(uint32_t) / n;
+    double arena = (double)(inv.arena.capacity + inv.arena.tableCapacity * sizeof(uint32_t)) / n;
+    double fixedNames = (double)inv.capacity * NAME_SIZE / n;
+
+    printf("1M products, names average %.1f characters, %zu distinct\n", (double)nameBytes / n, inv.arena.distinct);
+    printf("%-34s %12s\n", "layout", "bytes/SKU");
+    printf("%-34s %12.1f\n", "linked list node", listBytes);
+    printf("%-34s %12.1f\n", "columns, char name[100]", columns - sizeof(NameRef) + fixedNames + index);
+    printf("%-34s %12.1f\n", "columns, interned names", columns + index + arena);
+    printf("%-34s %12.1f\n", "  of which columns", columns);
+    printf("%-34s %12.1f\n", "  of which ID index", index);
+    printf("%-34s %12.1f\n", "  of which name arena", arena);
+    inventoryFree(&inv);
+}
+
+// Work and results of one checkout benchmark thread
+typedef struct {
+    SharedInventory *shared;
+    int products;
+    int checkouts;
+    uint32_t seed;
+    size_t sold;
+    size_t rejected;
+} CheckoutTask;
+
+// State of the benchmark's restocking thread
+typedef struct {
+    SharedInventory *shared;
+    int hot;
+    long long *restocked; // units added per hot product
+    size_t restocks;
+    int done;             // set by the benchmark, read under the store lock
+} RestockTask;
+
+/**
+ * @brief Checkout benchmark thread: sells random carts of one to four products.
+ *
+ * @param arg Pointer to a CheckoutTask.
+ * @return NULL.
+ */
+static void *benchCheckoutWorker(void *arg) {
+    CheckoutTask *task = (CheckoutTask *)arg;
+    for (int c = 0; c < task->checkouts; c++) {
+        Cart cart;
+        cart.count = 0;
+        int lines = 1 + (int)(benchRandom(&task->seed) % 4);
+        for (int l = 0; l < lines; l++) {
+            // A quarter of the lines pick one of the 64 scarce, contended products
+            int id = benchRandom(&task->seed) % 4 == 0 ? 1 + (int)(benchRandom(&task->seed) % 64)
+                                                        : 1 + (int)(benchRandom(&task->seed) % (uint32_t)task->products);
+            cartAdd(&cart, id, 1 + (int)(benchRandom(&task->seed) % 3));
+        }
+        if (sharedCheckout(task->shared, &cart, NULL, NULL) == INV_OK) {
+            task->sold++;
+        } else {
+            task->rejected++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Restocking benchmark thread: keeps topping up the scarce products under the
+ * exclusive lock while checkouts run.
+ *
+ * @param arg Pointer to a RestockTask.
+ * @return NULL.
+ */
+static void *benchRestockWorker(void *arg) {
+    RestockTask *task = (RestockTask *)arg;
+    uint32_t seed = 777;
+    struct timespec pause = {0, 200000};
+    for (;;) {
+        sharedLock(task->shared);
+        if (task->done) {
+            sharedUnlock(task->shared);
+            return NULL;
+        }
+        Inventory *inv = task->shared->inv;
+        int hot = (int)(benchRandom(&seed) % (uint32_t)task->hot);
+        size_t slot = inventoryFind(inv, hot + 1);
+        inventorySetQuantity(inv, slot, inv->quantities[slot] + 20);
+        task->restocked[hot] += 20;
+        task->restocks++;
+        sharedUnlock(task->shared);
+        nanosleep(&pause, NULL);
+    }
+}
+
+/**
+ * @brief Measures checkout throughput as the number of tills grows, and checks nothing is oversold.
+ *
+ * Each round fills 100k products, 64 of them scarce, and runs 200k checkouts per thread
+ * against one shared inventory while another thread restocks the scarce products. Afterwards
+ * every product's stock must equal its starting stock plus restocks minus units in the ledger.
+ */
+static void benchCheckout(void) {
+    const int n = 100000;
+    const int hot = 64;
+    const int perThread = 200000;
+    const int threadCounts[] = {1, 2, 4, 8, 16};
+
+    printf("%-10s %10s %14s %9s %10s %9s %8s\n", "threads", "seconds", "checkouts/s", "speedup", "rejected", "restocks", "stock");
+    double base = 0;
+    for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+        int threads = threadCounts[t];
+        Inventory inv;
+        Ledger ledger;
+        SharedInventory shared;
+        inventoryInit(&inv);
+        ledgerInit(&ledger);
+        long long *restocked = (long long *)calloc((size_t)hot, sizeof(long long));
+        int *initial = (int *)malloc((size_t)n * sizeof(int));
+        CheckoutTask *tasks = (CheckoutTask *)calloc((size_t)threads, sizeof(CheckoutTask));
+        pthread_t *ids = (pthread_t *)malloc((size_t)threads * sizeof(pthread_t));
+        if (restocked == NULL || initial == NULL || tasks == NULL || ids == NULL ||
+            benchFillInventory(&inv, n) != 0 || sharedInit(&shared, &inv, &ledger) != INV_OK) {
+            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+            free(restocked);
+            free(initial);
+            free(tasks);
+            free(ids);
+            inventoryFree(&inv);
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            inventorySetQuantity(&inv, (size_t)i, i < hot ? 50 : 1000000);
+            initial[i] = inv.quantities[i];
+        }
+
+        RestockTask restock = {&shared, hot, restocked, 0, 0};
+        pthread_t restocker;
+        int restocking = pthread_create(&restocker, NULL, benchRestockWorker, &restock) == 0;
+        double start = nowSeconds();
+        int started = 0;
+        for (; started < threads; started++) {
+            tasks[started] = (CheckoutTask){&shared, n, perThread, 0x9e3779b9u * (uint32_t)(started + 1), 0, 0};
+            if (pthread_create(&ids[started], NULL, benchCheckoutWorker, &tasks[started]) != 0) {
+                break;
+            }
+        }
+        size_t sold = 0, rejected = 0;
+        for (int i = 0; i < started; i++) {
+            pthread_join(ids[i], NULL);
+            sold += tasks[i].sold;
+            rejected += tasks[i].rejected;
+        }
+        double seconds = nowSeconds() - start;
+        sharedLock(&shared);
+        restock.done = 1;
+        sharedUnlock(&shared);
+        if (restocking) {
+            pthread_join(restocker, NULL);
+        }
+
+        // Replay the ledger against the starting stock
+        int consistent = sold == ledger.billCount;
+        for (size_t i = 0; i < ledger.lineCount; i++) {
+            initial[inventoryFind(&inv, ledger.lines[i].id)] -= ledger.lines[i].quantity;
+        }
+        for (int i = 0; i < n; i++) {
+            long long expected = initial[i] + (i < hot ? restocked[i] : 0);
+            if (inv.quantities[i] < 0 || inv.quantities[i] != expected) {
+                consistent = 0;
+            }
+        }
+
+        if (threads == 1) {
+            base = sold / seconds;
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%d", started);
+        printf("%-10s %10.3f %14.0f %8.2fx %10zu %9zu %8s\n", label, seconds, sold / seconds, sold / seconds / base,
+               rejected, restock.restocks, consistent ? "ok" : "OVERSOLD");
+
+        sharedDestroy(&shared);
+        ledgerFree(&ledger);
+        inventoryFree(&inv);
+        free(restocked);
+        free(initial);
+        free(tasks);
+        free(ids);
+    }
+    printf("(%ld CPUs online)\n", sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+// Work and results of one snapshot benchmark writer thread
+typedef struct {
+    SharedInventory *shared;
+    int products;
+    uint32_t seed;
+    size_t moves;
+    double maxWait; // longest wait for the store lock, in seconds
+    int done;       // set by the benchmark, read under the store lock
+} MoveTask;
+
+/**
+ * @brief Snapshot benchmark writer thread: every 100 us moves one unit between two random
+ * products, so the total units never change, and records how long it waits for the store lock.
+ *
+ * @param arg Pointer to a MoveTask.
+ * @return NULL.
+ */
+static void *benchMoveWorker(void *arg) {
+    MoveTask *task = (MoveTask *)arg;
+    struct timespec pause = {0, 100000};
+    for (;;) {
+        double start = nowSeconds();
+        sharedLock(task->shared);
+        double wait = nowSeconds() - start;
+        if (task->done) {
+            sharedUnlock(task->shared);
+            return NULL;
+        }
+        task->maxWait = wait > task->maxWait ? wait : task->maxWait;
+        Inventory *inv = task->shared->inv;
+        size_t from = inventoryFind(inv, 1 + (int)(benchRandom(&task->seed) % (uint32_t)task->products));
+        size_t to = inventoryFind(inv, 1 + (int)(benchRandom(&task->seed) % (uint32_t)task->products));
+        if (from != to && inv->quantities[from] > 0) {
+            inventorySetQuantity(inv, from, inv->quantities[from] - 1);
+            inventorySetQuantity(inv, to, inv->quantities[to] + 1);
+        }
+        task->moves++;
+        sharedUnlock(task->shared);
+        nanosleep(&pause, NULL);
+    }
+}
+
+/**
+ * @brief Compares a backup taken under the store lock with a snapshot backup, while writer
+ * threads keep moving stock between products.
+ *
+ * Reports how long each backup took, how many changes the writers made meanwhile, and the
+ * longest any writer waited for the lock. Each backup is loaded back and its total units
+ * checked against the unchanging total, which only a consistent point-in-time copy matches.
+ */
+static void benchSnapshot(void) {
+    const int n = 1000000, writers = 4;
+    const char *path = "bench_snapshot_backup.txt";
+    static const char *const labels[] = {"locked backup", "snapshot backup"};
+    Inventory inv;
+    Ledger ledger;
+    SharedInventory shared;
+    inventoryInit(&inv);
+    ledgerInit(&ledger);
+    if (benchFillInventory(&inv, n) != 0 || sharedInit(&shared, &inv, &ledger) != INV_OK) {
+        printf(ANSI_COLOR_RED"Could not set up the benchmark.\n"ANSI_COLOR_RESET);
+        inventoryFree(&inv);
+        return;
+    }
+    long long units = inv.units;
+
+    // Taking a snapshot copies nothing, whatever the inventory's size
+    InventorySnapshot snapshot;
+    const int takes = 1000000;
+    double start = nowSeconds();
+    for (int i = 0; i < takes; i++) {
+        inventorySnapshot(&inv, &snapshot);
+        inventorySnapshotRelease(&inv, &snapshot);
+    }
+    double takeNs = (nowSeconds() - start) / takes * 1e9;
+
+    printf("%-18s %10s %14s %14s %12s\n", "backup of 1M", "seconds", "writer ops/s", "max wait ms", "consistent");
+    for (int mode = 0; mode < 2; mode++) {
+        MoveTask tasks[4];
+        pthread_t ids[4];
+        int started = 0;
+        for (; started < writers; started++) {
+            tasks[started] = (MoveTask){&shared, n, 0x9e3779b9u * (uint32_t)(started + 1), 0, 0, 0};
+            if (pthread_create(&ids[started], NULL, benchMoveWorker, &tasks[started]) != 0) {
+                break;
+            }
+        }
+        struct timespec settle = {0, 50000000};
+        nanosleep(&settle, NULL);
+        sharedLock(&shared);
+        size_t movesBefore = 0;
+        for (int t = 0; t < started; t++) {
+            movesBefore += tasks[t].moves;
+            tasks[t].maxWait = 0;
+        }
+        sharedUnlock(&shared);
+
+        start = nowSeconds();
+        int status;
+        if (mode == 0) {
+            sharedLock(&shared);
+            status = inventorySaveText(&inv, path);
+            sharedUnlock(&shared);
+        } else {
+            status = sharedSaveText(&shared, path);
+        }
+        double seconds = nowSeconds() - start;
+
+        sharedLock(&shared);
+        size_t moves = 0;
+        double maxWait = 0;
+        for (int t = 0; t < started; t++) {
+            moves += tasks[t].moves;
+            maxWait = tasks[t].maxWait > maxWait ? tasks[t].maxWait : maxWait;
+            tasks[t].done = 1;
+        }
+        sharedUnlock(&shared);
+        for (int t = 0; t < started; t++) {
+            pthread_join(ids[t], NULL);
+        }
+
+        Inventory copy;
+        inventoryInit(&copy);
+        int consistent = status == INV_OK && inventoryLoadText(&copy, path, NULL) == INV_OK && copy.units == units && copy.liveCount == (size_t)n;
+        inventoryFree(&copy);
+        printf("%-18s %10.3f %14.0f %14.3f %12s\n", labels[mode], seconds, (moves - movesBefore) / seconds, maxWait * 1e3,
+               consistent ? "yes" : "NO");
+    }
+    printf("taking and releasing a snapshot: %.1f ns\n", takeNs);
+    remove(path);
+    sharedDestroy(&shared);
+    ledgerFree(&ledger);
+    inventoryFree(&inv);
+}
+
+/**
+ * @brief Orders the reorder list by days of cover, then ID, for the rescanning baseline.
+ */
+static int compareCover(const void *a, const void *b) {
+    const ReorderItem *x = (const ReorderItem *)a;
+    const ReorderItem *y = (const ReorderItem *)b;
+    if (x->daysOfCover != y->daysOfCover) {
+        return x->daysOfCover < y->daysOfCover ? -1 : 1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/**
+ * @brief Measures the reorder queue on 1M products: building it, what each sale costs with it
+ * kept up to date, listing the most urgent products, and writing the purchase order, against
+ * rescanning the whole catalogue for every list.
+ */
+static void benchReorder(void) {
+    const int n = 1000000;
+    const int sales = 200000;
+    const int rescans = 5;
+    ReorderItem top[100];
+    const size_t listed = sizeof(top) / sizeof(top[0]);
+    Inventory inv;
+    Ledger ledger;
+    ReorderQueue queue;
+    inventoryInit(&inv);
+    ledgerInit(&ledger);
+    reorderInit(&queue, LOW_STOCK_DEFAULT - 1);
+    ReorderItem *items = (ReorderItem *)malloc((size_t)n * sizeof(ReorderItem));
+    if (items == NULL || benchFillInventory(&inv, n) != 0) {
+        printf(ANSI_COLOR_RED"Could not set up the reorder benchmark.\n"ANSI_COLOR_RESET);
+        free(items);
+        inventoryFree(&inv);
+        return;
+    }
+    // The same sales with the queue detached, then attached
+    uint32_t seed = 42;
+    Cart cart;
+    cart.count = 1;
+    cart.lines[0].quantity = 1;
+    double start = nowSeconds();
+    for (int s = 0; s < sales; s++) {
+        cart.lines[0].id = 1 + (int)(benchRandom(&seed) % (uint32_t)n);
+        if (inventoryCheckout(&inv, &ledger, &cart, NULL, NULL) != INV_OK) {
+            inventorySetQuantity(&inv, inventoryFind(&inv, cart.lines[0].id), 50);
+        }
+    }
+    double plain = (nowSeconds() - start) / sales;
+
+    start = nowSeconds();
+    int attached = reorderAttach(&queue, &inv);
+    double attach = nowSeconds() - start;
+    if (attached != INV_OK) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        free(items);
+        ledgerFree(&ledger);
+        inventoryFree(&inv);
+        return;
+    }
+    reorderReplay(&queue, &ledger);
+    start = nowSeconds();
+    for (int s = 0; s < sales; s++) {
+        cart.lines[0].id = 1 + (int)(benchRandom(&seed) % (uint32_t)n);
+        if (inventoryCheckout(&inv, &ledger, &cart, NULL, NULL) != INV_OK) {
+            inventorySetQuantity(&inv, inventoryFind(&inv, cart.lines[0].id), 50);
+        }
+    }
+    double tracked = (nowSeconds() - start) / sales;
+
+    int64_t now = (int64_t)time(NULL);
+    start = nowSeconds();
+    size_t found = 0;
+    for (int r = 0; r < rescans; r++) {
+        found = reorderDue(&queue, now, top, listed);
+    }
+    double heapList = (nowSeconds() - start) / rescans;
+
+    // Baseline: re-evaluate every product, then sort those due
+    size_t due = 0;
+    start = nowSeconds();
+    for (int r = 0; r < rescans; r++) {
+        due = 0;
+        for (size_t i = 0; i < queue.count; i++) {
+            const ReorderEntry *entry = &queue.entries[i];
+            if (entry->quantity <= entry->point) {
+                double demand = exp(entry->logDemand - now / 86400.0 / REORDER_DEMAND_DAYS) / REORDER_DEMAND_DAYS;
+                items[due].id = entry->id;
+                items[due].daysOfCover = entry->quantity <= 0 ? 0 : demand > 0 ? entry->quantity / demand : INFINITY;
+                due++;
+            }
+        }
+        qsort(items, due, sizeof(ReorderItem), compareCover);
+    }
+    double scanList = (nowSeconds() - start) / rescans;
+
+    int same = found == (due < listed ? due : listed);
+    for (size_t i = 0; i < found && same; i++) {
+        same = top[i].id == items[i].id;
+    }
+
+    size_t lines = 0;
+    start = nowSeconds();
+    int written = reorderWritePurchaseOrder(&inv, "bench_purchase_order.csv", now, &lines, NULL);
+    double order = nowSeconds() - start;
+    remove("bench_purchase_order.csv");
+
+    printf("%-34s %14s\n", "1M products", "time");
+    printf("%-34s %11.1f ms\n", "build queue", attach * 1e3);
+    printf("%-34s %11.3f us\n", "sale, no queue", plain * 1e6);
+    printf("%-34s %11.3f us\n", "sale, queue kept up to date", tracked * 1e6);
+    printf("%-34s %11.3f us\n", "top 100 from heap", heapList * 1e6);
+    printf("%-34s %11.3f us   (%.0fx)\n", "top 100 by full rescan and sort", scanList * 1e6, scanList / heapList);
+    printf("%-34s %11.1f ms   (%zu lines%s)\n", "purchase order", order * 1e3, lines, written == INV_OK ? "" : ", failed");
+    printf("%zu of %d products due; the %zu most urgent %s.\n", due, n, found, same ? "match the rescan" : "DO NOT match the rescan");
+
+    inv.reorder = NULL;
+    reorderFree(&queue);
+    free(items);
+    ledgerFree(&ledger);
+    inventoryFree(&inv);
+}
+
+/**
+ * @brief Fills an inventory with a catalogue shaped like a real one: near-sequential IDs with
+ * gaps, names and prices drawn from a few thousand brand, product and pack-size combinations,
+ * and varied stock.
+ *
+ * @param inv Pointer to an empty inventory.
+ * @param n Number of products.
+ * @return 0 on success, -1 if memory allocation failed.
+ */
+static int benchFillCatalogue(Inventory *inv, int n) {
+    static const char *const brands[] = {"Amul", "Nestle", "Britannia", "Tata", "Dabur", "Parle", "Haldiram", "Patanjali",
+                                         "Aashirvaad", "Fortune", "Saffola", "Mother", "Kissan", "Maggi", "Lays", "Cadbury"};
+    static const char *const goods[] = {"Milk", "Butter", "Biscuits", "Tea", "Honey", "Rusk", "Namkeen", "Ghee",
+                                        "Atta", "Oil", "Oats", "Curd", "Jam", "Noodles", "Chips", "Chocolate"};
+    static const int sizes[] = {50, 100, 200, 250, 500, 750, 1000, 5000};
+    uint32_t seed = 7;
+    Product product;
+    int id = 100000;
+    for (int i = 0; i < n; i++) {
+        uint32_t r = benchRandom(&seed);
+        id += 1 + (r % 16 == 0 ? (int)(r >> 4) % 20 : 0);
+        int brand = (int)(r >> 8) % 16, good = (int)(r >> 12) % 16, size = (int)(r >> 16) % 8;
+        product.id = id;
+        snprintf(product.name, NAME_SIZE, "%s-%s-%dg", brands[brand], goods[good], sizes[size]);
+        product.priceCents = ((good + 1) * 500 + sizes[size] * 8 + brand * 100) / 100 * 100 + 99;
+        product.quantity = (int)(r >> 20) % 200;
+        if (inventoryInsert(inv, &product) == NO_SLOT) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Tells whether two inventories hold the same products, in the same order.
+ */
+static int benchSameProducts(const Inventory *a, const Inventory *b) {
+    if (a->liveCount != b->liveCount) {
+        return 0;
+    }
+    Product x, y;
+    size_t i = 0, j = 0;
+    while (inv_next(a, &i, &x)) {
+        if (!inv_next(b, &j, &y) || x.id != y.id || x.priceCents != y.priceCents ||
+            x.quantity != y.quantity || strcmp(x.name, y.name) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Compares the compressed backup with the text backup and the binary snapshot on a
+ * 2M-product catalogue: file size, save time and load time, and checks that each round trip
+ * gives back the same products.
+ *
+ * @param threads Threads for the parallel loads; 0 means one per online CPU.
+ */
+static void benchPack(int threads) {
+    const int n = 2000000;
+    const char *textPath = "bench_inventory_backup.txt";
+    const char *snapshotPath = "bench_inventory_snapshot.bin";
+    const char *packPath = "bench_inventory_backup.pak";
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    Inventory original, loaded;
+    inventoryInit(&original);
+    inventoryInit(&loaded);
+    if (benchFillCatalogue(&original, n) != 0) {
+        printf(ANSI_COLOR_RED"Could not set up the compression benchmark.\n"ANSI_COLOR_RESET);
+        inventoryFree(&original);
+        return;
+    }
+
+    double start = nowSeconds();
+    int failed = inventorySaveText(&original, textPath) != INV_OK;
+    double textSave = nowSeconds() - start;
+    start = nowSeconds();
+    failed |= inventorySaveSnapshot(&original, snapshotPath, 0) != INV_OK;
+    double snapshotSave = nowSeconds() - start;
+    start = nowSeconds();
+    failed |= inventorySaveCompressed(&original, packPath) != INV_OK;
+    double packSave = nowSeconds() - start;
+    struct stat textStat, snapshotStat, packStat;
+    if (failed || stat(textPath, &textStat) != 0 || stat(snapshotPath, &snapshotStat) != 0 || stat(packPath, &packStat) != 0) {
+        printf(ANSI_COLOR_RED"Could not write the benchmark backups.\n"ANSI_COLOR_RESET);
+        inventoryFree(&original);
+        remove(textPath);
+        remove(snapshotPath);
+        remove(packPath);
+        return;
+    }
+
+    printf("%-24s %10s %8s %10s %10s %14s %6s\n", "2M products", "MB", "ratio", "save s", "load s", "records/s", "same");
+    double textMb = textStat.st_size / 1e6;
+    for (int method = 0; method < 5; method++) {
+        char label[32];
+        double mb, save;
+        int status;
+        start = nowSeconds();
+        switch (method) {
+            case 0:
+                snprintf(label, sizeof(label), "text, streaming");
+                status = inventoryLoadText(&loaded, textPath, NULL);
+                mb = textMb;
+                save = textSave;
+                break;
+            case 1:
+                snprintf(label, sizeof(label), "text, %d thread%s", threads, threads == 1 ? "" : "s");
+                status = inventoryLoadTextParallel(&loaded, textPath, threads, NULL);
+                mb = textMb;
+                save = textSave;
+                break;
+            case 2:
+                snprintf(label, sizeof(label), "snapshot");
+                status = inventoryLoadSnapshot(&loaded, snapshotPath, NULL, NULL);
+                mb = snapshotStat.st_size / 1e6;
+                save = snapshotSave;
+                break;
+            default:
+                snprintf(label, sizeof(label), "compressed, %d thread%s", method == 3 ? 1 : threads, method == 3 || threads == 1 ? "" : "s");
+                status = inventoryLoadCompressed(&loaded, packPath, method == 3 ? 1 : threads, NULL);
+                mb = packStat.st_size / 1e6;
+                save = packSave;
+        }
+        double load = nowSeconds() - start;
+        printf("%-24s %10.1f %7.2fx %10.3f %10.3f %14.0f %6s\n", label, mb, textMb / mb, save, load, n / load,
+               status == INV_OK && benchSameProducts(&original, &loaded) ? "yes" : "NO");
+    }
+
+    inventoryFree(&original);
+    inventoryFree(&loaded);
+    remove(textPath);
+    remove(snapshotPath);
+    remove(packPath);
+}
+
+/**
+ * @brief Measures how chain-wide queries scale with threads: 32 branches of 100k products
+ * each, recounted, searched by ID and listed for low stock with 1 to 16 threads.
+ */
+static void benchChain(void) {
+    const int stores = 32;
+    const int perStore = 100000;
+    const int threadCounts[] = {1, 2, 4, 8, 16};
+    const int recounts = 5;
+    const int finds = 20000;
+    StoreChain chain;
+    int failed = chainInit(&chain, stores, 0) != INV_OK;
+    char name[NAME_SIZE];
+    for (int s = 0; s < stores && !failed; s++) {
+        for (int i = 1; i <= perStore && !failed; i++) {
+            snprintf(name, sizeof(name), "item%d", i);
+            failed = chainAdd(&chain, s, i, name, (i % 1000) * 100 + 99, (i * 7 + s * 13) % 50) != INV_OK;
+        }
+        // A few bills per branch, so there are sales to add up
+        Cart cart;
+        cart.count = 1;
+        cart.lines[0].quantity = 1;
+        for (int b = 0; b < 100 && !failed; b++) {
+            cart.lines[0].id = 1 + (b * 997) % perStore;
+            chainSell(&chain, s, &cart, NULL, NULL);
+        }
+    }
+    ChainItem *items = failed ? NULL : (ChainItem *)malloc((size_t)stores * perStore * sizeof(ChainItem));
+    if (items == NULL) {
+        printf(ANSI_COLOR_RED"Could not set up the chain benchmark.\n"ANSI_COLOR_RESET);
+        chainFree(&chain);
+        return;
+    }
+
+    InventoryTotals running, recounted;
+    long long sales;
+    chainTotals(&chain, 0, &running, &sales);
+    char value[CENTS_BUF_SIZE], amount[CENTS_BUF_SIZE];
+    printf("%d stores x %d products: stock value %s, %zu low on stock, sales %s\n", stores, perStore,
+           formatCents(running.stockValueCents, value), running.lowStock, formatCents(sales, amount));
+    chainLowStock(&chain, 5, items, (size_t)stores * perStore); // builds each store's quantity index untimed
+    printf("%-8s %14s %8s %14s %8s %14s %8s\n", "threads", "recount ms", "speedup", "low stock ms", "speedup", "find by ID us", "speedup");
+    double baseRecount = 0, baseLow = 0, baseFind = 0;
+    int consistent = 1;
+    size_t lowCount = 0;
+    for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+        int threads = chainSetThreads(&chain, threadCounts[t]);
+
+        double start = nowSeconds();
+        for (int r = 0; r < recounts; r++) {
+            chainTotals(&chain, 1, &recounted, NULL);
+        }
+        double recount = (nowSeconds() - start) / recounts;
+        consistent &= memcmp(&running, &recounted, sizeof(running)) == 0;
+
+        start = nowSeconds();
+        size_t low = 0;
+        for (int r = 0; r < recounts; r++) {
+            low = chainLowStock(&chain, 5, items, (size_t)stores * perStore);
+        }
+        double lowSeconds = (nowSeconds() - start) / recounts;
+        consistent &= t == 0 || low == lowCount;
+        lowCount = low;
+
+        ChainHit hits[64];
+        uint32_t seed = 5;
+        size_t hitCount = 0;
+        start = nowSeconds();
+        for (int f = 0; f < finds; f++) {
+            hitCount += chainFind(&chain, 1 + (int)(benchRandom(&seed) % (uint32_t)perStore), hits, 64);
+        }
+        double find = (nowSeconds() - start) / finds;
+        consistent &= hitCount == (size_t)finds * stores;
+
+        if (t == 0) {
+            baseRecount = recount;
+            baseLow = lowSeconds;
+            baseFind = find;
+        }
+        printf("%-8d %14.2f %7.2fx %14.2f %7.2fx %14.2f %7.2fx\n", threads, recount * 1e3, baseRecount / recount,
+               lowSeconds * 1e3, baseLow / lowSeconds, find * 1e6, baseFind / find);
+    }
+    printf("%zu products below 5 units across the chain; results %s.\n", lowCount, consistent ? "agree at every thread count" : "DISAGREE");
+    printf("(%ld CPUs online)\n", sysconf(_SC_NPROCESSORS_ONLN));
+    free(items);
+    chainFree(&chain);
+}
+
+// Zipf-distributed ranks in [0, n), drawn in constant time after an O(n) setup (the method of
+// Gray et al., as used by YCSB); rank 0 is the most popular
+typedef struct {
+    uint64_t n;
+    double theta;
+    double alpha;
+    double zetan;
+    double eta;
+    double secondCut;  // 1 + 0.5^theta: draws below this are rank 1
+    uint32_t seed;
+} ZipfGenerator;
+
+/**
+ * @brief Sets up a Zipf generator.
+ *
+ * @param zipf Pointer to the generator.
+ * @param n Number of ranks.
+ * @param theta Skew, in [0, 1); 0.99 is the usual "hot set" workload.
+ * @param seed Non-zero random seed.
+ */
+static void zipfInit(ZipfGenerator *zipf, uint64_t n, double theta, uint32_t seed) {
+    double zetan = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+        zetan += 1.0 / pow((double)i, theta);
+    }
+    zipf->n = n;
+    zipf->theta = theta;
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->zetan = zetan;
+    zipf->secondCut = 1.0 + pow(0.5, theta);
+    zipf->eta = (1.0 - pow(2.0 / (double)n, 1.0 - theta)) / (1.0 - zipf->secondCut / zetan);
+    zipf->seed = seed;
+}
+
+/**
+ * @brief Draws the next Zipf-distributed rank.
+ *
+ * @param zipf Pointer to the generator.
+ * @return Rank in [0, n).
+ */
+static uint64_t zipfNext(ZipfGenerator *zipf) {
+    double u = benchRandom(&zipf->seed) / 4294967296.0;
+    double uz = u * zipf->zetan;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < zipf->secondCut) {
+        return 1;
+    }
+    uint64_t rank = (uint64_t)((double)zipf->n * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+    return rank < zipf->n ? rank : zipf->n - 1;
+}
+
+/**
+ * @brief Maps a popularity rank to a product ID in 1..n, scattering the hot products across the store.
+ *
+ * @param rank Rank in [0, n).
+ * @param n Number of products; must not be divisible by 2654435761.
+ * @return Product ID.
+ */
+static int suiteId(uint64_t rank, uint64_t n) {
+    return (int)((rank * 2654435761ULL) % n) + 1;
+}
+
+/**
+ * @brief Prints one result row of the benchmark suite and appends it to the CSV.
+ *
+ * @param csv CSV stream, or NULL.
+ * @param skus Catalogue size.
+ * @param operation Operation name.
+ * @param latencies Latency of each operation in nanoseconds; sorted in place.
+ * @param ops Number of operations.
+ * @param seconds Wall time of the whole run.
+ */
+static void suiteReport(FILE *csv, size_t skus, const char *operation, double *latencies, size_t ops, double seconds) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    qsort(latencies, ops, sizeof(double), compareDoubles);
+    double p50 = latencies[ops / 2];
+    double p90 = latencies[ops * 90 / 100];
+    double p99 = latencies[ops * 99 / 100];
+    double p999 = latencies[ops * 999 / 1000];
+    double max = latencies[ops - 1];
+    printf("%10zu %-12s %10zu %14.0f %10.0f %10.0f %10.0f %10.0f %12.0f %12ld\n", skus, operation, ops, ops / seconds,
+           p50, p90, p99, p999, max, usage.ru_maxrss);
+    if (csv != NULL) {
+        fprintf(csv, "%zu,%s,%zu,%.6f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%ld\n", skus, operation, ops, seconds, ops / seconds,
+                p50, p90, p99, p999, max, usage.ru_maxrss);
+    }
+}
+
+/**
+ * @brief Benchmark suite: times every inventory operation over catalogues of growing size and
+ * writes ops/s, latency percentiles and peak RSS to a CSV.
+ *
+ * Usage: supermarket --bench suite [max SKUs] [CSV path] [Zipf theta]
+ * For 1k, 10k, ... up to max SKUs (default 1M, at most 10M) it adds every product, then runs
+ * searches, updates and one-product checkouts on Zipf-skewed IDs, reads of stock value and
+ * total sales, snapshot backups and restores, and deletes of a tenth of the products. These
+ * call the engine behind the menu's add, search, update, delete, bill, total and backup/restore
+ * options. Peak RSS is the process's high-water mark so far, in KiB.
+ *
+ * @param argc Number of suite arguments.
+ * @param argv Suite arguments.
+ */
+static void benchSuite(int argc, char *argv[]) {
+    long maxSkus = argc >= 1 ? atol(argv[0]) : 1000000;
+    const char *csvPath = argc >= 2 ? argv[1] : "bench_suite.csv";
+    double theta = argc >= 3 ? atof(argv[2]) : 0.99;
+    const char *snapshotPath = "bench_suite_snapshot.bin";
+    const size_t lookups = 1000000;
+    const size_t changes = 200000;
+    if (maxSkus < 1000 || maxSkus > 10000000 || theta < 0 || theta >= 1) {
+        printf("Max SKUs must be between 1000 and 10000000, and theta in [0, 1).\n");
+        return;
+    }
+
+    size_t most = (size_t)maxSkus > lookups ? (size_t)maxSkus : lookups;
+    double *latencies = (double *)malloc(most * sizeof(double));
+    FILE *csv = fopen(csvPath, "w");
+    if (latencies == NULL || csv == NULL) {
+        printf(ANSI_COLOR_RED"Could not start the benchmark suite.\n"ANSI_COLOR_RESET);
+        free(latencies);
+        if (csv != NULL) {
+            fclose(csv);
+        }
+        return;
+    }
+    fprintf(csv, "skus,operation,ops,seconds,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,peak_rss_kb\n");
+    printf("Zipf theta %.2f; latencies in ns\n", theta);
+    printf("%10s %-12s %10s %14s %10s %10s %10s %10s %12s %12s\n", "skus", "operation", "ops", "ops/s", "p50", "p90", "p99",
+           "p99.9", "max", "peak RSS KiB");
+
+    for (size_t n = 1000; n <= (size_t)maxSkus; n *= 10) {
+        Inventory inv;
+        Ledger ledger;
+        Product product;
+        ZipfGenerator zipf;
+        inventoryInit(&inv);
+        ledgerInit(&ledger);
+        zipfInit(&zipf, n, theta, 0x2545f491u);
+        long long sink = 0;
+        int failed = 0;
+
+        double start = nowSeconds();
+        for (size_t i = 0; i < n && !failed; i++) {
+            product.id = (int)i + 1;
+            snprintf(product.name, NAME_SIZE, "sku%zu_%zu", i % 9973, i % 89);
+            product.priceCents = 100 + (int)(i % 10000);
+            product.quantity = 1000000;
+            double t = nowSeconds();
+            failed = inventoryInsert(&inv, &product) == NO_SLOT;
+            latencies[i] = (nowSeconds() - t) * 1e9;
+        }
+        if (failed) {
+            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+            inventoryFree(&inv);
+            break;
+        }
+        suiteReport(csv, n, "add", latencies, n, nowSeconds() - start);
+
+        start = nowSeconds();
+        for (size_t i = 0; i < lookups; i++) {
+            double t = nowSeconds();
+            size_t slot = inventoryFind(&inv, suiteId(zipfNext(&zipf), n));
+            inventoryGet(&inv, slot, &product);
+            latencies[i] = (nowSeconds() - t) * 1e9;
+            sink += product.quantity;
+        }
+        suiteReport(csv, n, "search", latencies, lookups, nowSeconds() - start);
+
+        start = nowSeconds();
+        for (size_t i = 0; i < changes && !failed; i++) {
+            double t = nowSeconds();
+            size_t slot = inventoryFind(&inv, suiteId(zipfNext(&zipf), n));
+            inventoryGet(&inv, slot, &product);
+            product.priceCents += 1;
+            failed = inventoryUpdate(&inv, slot, &product) != INV_OK;
+            latencies[i] = (nowSeconds() - t) * 1e9;
+        }
+        suiteReport(csv, n, "update", latencies, changes, nowSeconds() - start);
+
+        start = nowSeconds();
+        for (size_t i = 0; i < changes && !failed; i++) {
+            Cart cart;
+            cart.count = 0;
+            cartAdd(&cart, suiteId(zipfNext(&zipf), n), 1);
+            double t = nowSeconds();
+            failed = inventoryCheckout(&inv, &ledger, &cart, NULL, NULL) != INV_OK;
+            latencies[i] = (nowSeconds() - t) * 1e9;
+        }
+        suiteReport(csv, n, "checkout", latencies, changes, nowSeconds() - start);
+
+        start = nowSeconds();
+        for (size_t i = 0; i < lookups; i++) {
+            double t = nowSeconds();
+            sink += i % 2 ? calculateStockValue(&inv) : calculateTotalSales(&ledger);
+            latencies[i] = (nowSeconds() - t) * 1e9;
+        }
+        suiteReport(csv, n, "totals", latencies, lookups, nowSeconds() - start);
+
+        const size_t repeats = n >= 1000000 ? 3 : 10;
+        start = nowSeconds();
+        for (size_t i = 0; i < repeats && !failed; i++) {
+            double t = nowSeconds();
+            failed = inventorySaveSnapshot(&inv, snapshotPath, 0) != INV_OK;
+            latencies[i] = (nowSeconds() - t) * 1e9;
+        }
+        suiteReport(csv, n, "backup", latencies, repeats, nowSeconds() - start);
+
+        start = nowSeconds();
+        for (size_t i = 0; i < repeats && !failed; i++) {
+            double t = nowSeconds();
+            failed = inventoryLoadSnapshot(&inv, snapshotPath, NULL, NULL) != INV_OK;
+            latencies[i] = (nowSeconds() - t) * 1e9;
+        }
+        suiteReport(csv, n, "restore", latencies, repeats, nowSeconds() - start);
+
+        // Distinct IDs, spread over the store
+        size_t deletes = n / 10;
+        start = nowSeconds();
+        for (size_t i = 0; i < deletes; i++) {
+            double t = nowSeconds();
+            size_t slot = inventoryFind(&inv, suiteId(i, n));
+            if (slot != NO_SLOT) {
+                inventoryRemove(&inv, slot);
+            }
+            latencies[i] = (nowSeconds() - t) * 1e9;
+        }
+        suiteReport(csv, n, "delete", latencies, deletes, nowSeconds() - start);
+
+        if (failed) {
+            printf(ANSI_COLOR_RED"An operation failed; results for %zu SKUs are incomplete.\n"ANSI_COLOR_RESET, n);
+        }
+        if (sink == 42) {
+            printf(" ");
+        }
+        ledgerFree(&ledger);
+        inventoryFree(&inv);
+    }
+
+    fclose(csv);
+    free(latencies);
+    remove(snapshotPath);
+    printf("Results written to %s\n", csvPath);
+}
+
+/**
+ * @brief Runs a named benchmark from the command line.
+ *
+ * Usage: supermarket --bench lookup|valuation|restore|parse|range|names|memory|checkout|snapshot|report|history|reorder|pack|chain|suite
+ *
+ * @param argc Number of benchmark arguments.
+ * @param argv Benchmark arguments; argv[0] names the benchmark.
+ * @param threads Parser threads given with --threads, 0 for one per online CPU.
+ * @return Process exit status.
+ */
+int runBenchmark(int argc, char *argv[], int threads) {
+    if (argc >= 1 && strcmp(argv[0], "lookup") == 0) {
+        benchLookup();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "valuation") == 0) {
+        benchValuation();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "restore") == 0) {
+        benchRestore();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "parse") == 0) {
+        benchParse();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "range") == 0) {
+        benchRange();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "names") == 0) {
+        benchNames();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "memory") == 0) {
+        benchMemory();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "checkout") == 0) {
+        benchCheckout();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "report") == 0) {
+        benchReport();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "snapshot") == 0) {
+        benchSnapshot();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "history") == 0) {
+        benchHistory();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "reorder") == 0) {
+        benchReorder();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "pack") == 0) {
+        benchPack(threads);
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "chain") == 0) {
+        benchChain();
+        return 0;
+    }
+    if (argc >= 1 && strcmp(argv[0], "suite") == 0) {
+        benchSuite(argc - 1, argv + 1);
+        return 0;
+    }
+    printf("Available benchmarks: lookup, valuation, restore, parse, range, names, memory, checkout, snapshot, report, history, reorder, pack, chain, suite\n");
+    return 1;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file frontend.h
+ * @brief Shared by the modules of the supermarket program: the menu (supermarketV1.c), batch
+ * mode (batch.c), the socket server (server.c), the load generator (loadgen.c) and the
+ * benchmarks (bench.c). They only use the inventory engine through inventory.h.
+ */
+
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include "inventory.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+// Define ANSI color codes for better visual presentation in the terminal
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_BLUE    "\x1b[34m"
+#define ANSI_COLOR_MAGENTA "\x1b[35m"
+#define ANSI_COLOR_CYAN    "\x1b[36m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define REORDER_FILE "reorder_rules.txt"
+#define NAME_SEARCH_LIMIT 50 // name search results shown at once
+
+/**
+ * @brief Returns a monotonic timestamp in seconds, used for timing and benchmarks.
+ *
+ * @return Current monotonic time in seconds.
+ */
+static inline double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Menu (supermarketV1.c)
+long long reportProducts(const Inventory *inv, int fd, int format, size_t pageRows);
+
+// Batch mode (batch.c)
+size_t runBatch(Inventory *inv, Ledger *ledger, FILE *in, FILE *out);
+
+// Socket server and load generator (server.c, loadgen.c)
+int runServer(Inventory *inv, Ledger *ledger, const char *address, FILE *status);
+int runLoadgen(int argc, char *argv[]);
+
+// Benchmarks (bench.c)
+uint32_t benchRandom(uint32_t *state);
+int compareDoubles(const void *a, const void *b);
+int runBenchmark(int argc, char *argv[], int threads);
+
+#endif
@@ -0,0 +1,6465 @@
+/**
+ * @file inventory.c
+ * @brief Inventory engine: column store, indexes, snapshots, change log, ledger and checkout.
+ *
+ * See inventory.h for the public interface. This file does no terminal I/O.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "inventory.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#define INDEX_MIN_CAPACITY 16
+#define INDEX_EMPTY UINT32_MAX
+#define VERSION_NONE UINT32_MAX
+#define STORE_MIN_CAPACITY 64
+#define LOAD_CHUNK_SIZE (1 << 16)
+#define SNAPSHOT_MAGIC "SMINVSNP"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER 0x01020304U
+
+// Header of a binary inventory snapshot. Snapshots are written in native byte order;
+// byteOrder lets a reader on a different machine reject the file.
+typedef struct {
+    char magic[8];      // SNAPSHOT_MAGIC, without the terminator
+    uint32_t version;   // SNAPSHOT_VERSION
+    uint32_t byteOrder; // SNAPSHOT_BYTE_ORDER as written by the saving machine
+    uint64_t count;     // number of products
+    uint64_t poolSize;  // bytes in the name pool
+    uint64_t checksum;  // checksumUpdate chained over each section after the header
+    uint64_t walLsn;    // last change-log record included (version 2 and later)
+} SnapshotHeader;
+
+#define PACK_MAGIC "SMINVPAK"
+#define PACK_VERSION 1
+#define PACK_BLOCK_ROWS 4096
+#define VARINT_MAX_BYTES 10
+#define PACK_ROW_MAX_BYTES 20 // four columns of at most five varint bytes
+
+// Header of a compressed backup. Like snapshots, the fixed-size fields are in native byte
+// order; the varints in the dictionary and blocks are the same everywhere.
+typedef struct {
+    char magic[8];           // PACK_MAGIC, without the terminator
+    uint32_t version;        // PACK_VERSION
+    uint32_t byteOrder;      // SNAPSHOT_BYTE_ORDER as written by the saving machine
+    uint64_t count;          // number of products
+    uint64_t names;          // distinct names in the dictionary
+    uint64_t poolSize;       // bytes of the names once expanded, terminators included
+    uint64_t dictionarySize; // bytes of the encoded dictionary
+    uint64_t blocks;         // product blocks, PACK_BLOCK_ROWS products each but the last
+    uint64_t checksum;       // checksumUpdate over the dictionary, then the block directory
+} PackHeader;
+
+// Block directory entry of a compressed backup
+typedef struct {
+    uint32_t rows;      // products in the block
+    uint32_t size;      // encoded bytes
+    uint64_t checksum;  // checksumUpdate over the encoded bytes
+} PackBlock;
+
+#define WAL_BUFFER_SIZE (1 << 16)
+#define WAL_GROUP_COMMIT 64
+#define WAL_COMPACT_SIZE (8 << 20)
+#define WAL_ADD 1
+#define WAL_UPDATE 2
+#define WAL_DELETE 3
+
+// One change-log record, followed in the file by nameLength bytes of name
+typedef struct {
+    uint64_t lsn;       // sequence number, increasing across the log's lifetime
+    int32_t id;
+    int32_t priceCents;
+    int32_t quantity;
+    uint8_t type;       // WAL_ADD, WAL_UPDATE or WAL_DELETE
+    uint8_t nameLength;
+    uint16_t reserved;
+    uint32_t checksum;  // checksumUpdate over the record and name, with this field zero
+} WalRecord;
+
+size_t storeAllocations = 0;
+
+#ifdef INVENTORY_STATS
+static InventoryStats stats;
+
+// Time a timed operation from STATS_START to STATS_STOP; both vanish without INVENTORY_STATS
+#define STATS_START(start) uint64_t start = statsNow()
+#define STATS_STOP(op, start) statsRecord(op, start)
+#define STATS_PRODUCTS(inv) statsProducts((inv)->liveCount)
+
+static uint64_t statsNow(void);
+static void statsRecord(int op, uint64_t start);
+static void statsProducts(size_t products);
+#else
+#define STATS_START(start)
+#define STATS_STOP(op, start)
+#define STATS_PRODUCTS(inv)
+#endif
+
+static void walAppend(Wal *wal, int type, int id, const Product *product);
+static ValuationKernel valuationKernel(void);
+
+
+/**
+ * @brief Mixes a product ID into a well-distributed hash value.
+ *
+ * Product IDs are usually near-sequential, so the bits are scrambled before masking.
+ *
+ * @param id Product ID to hash.
+ * @return Hash value.
+ */
+static size_t hashId(int id) {
+    uint32_t h = (uint32_t)id;
+    h ^= h >> 16;
+    h *= 0x7feb352dU;
+    h ^= h >> 15;
+    h *= 0x846ca68bU;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * @brief Resizes the ID index to a new power-of-two capacity and rehashes every entry.
+ *
+ * @param index Pointer to the ID index.
+ * @param ids ID column of the store the index points into.
+ * @param capacity New number of slots.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int indexResize(IdIndex *index, const int *ids, size_t capacity) {
+    uint32_t *slots = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    if (slots == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    memset(slots, 0xff, capacity * sizeof(uint32_t));
+    storeAllocations++;
+
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < index->capacity; i++) {
+        uint32_t slot = index->slots[i];
+        if (slot == INDEX_EMPTY) {
+            continue;
+        }
+        size_t j = hashId(ids[slot]) & mask;
+        while (slots[j] != INDEX_EMPTY) {
+            j = (j + 1) & mask;
+        }
+        slots[j] = slot;
+    }
+
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+    return INV_OK;
+}
+
+/**
+ * @brief Looks up the store slot of a product ID in the ID index.
+ *
+ * @param index Pointer to the ID index.
+ * @param ids ID column of the store the index points into.
+ * @param id Product ID to find.
+ * @return Store slot, or NO_SLOT if no product has that ID.
+ */
+static size_t indexFind(const IdIndex *index, const int *ids, int id) {
+    if (index->capacity == 0) {
+        return NO_SLOT;
+    }
+
+    size_t mask = index->capacity - 1;
+    size_t i = hashId(id) & mask;
+    while (index->slots[i] != INDEX_EMPTY) {
+        if (ids[index->slots[i]] == id) {
+            return index->slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return NO_SLOT;
+}
+
+/**
+ * @brief Adds a store slot to the ID index, growing the table to keep the load factor below 1/2.
+ *
+ * The caller must make sure the slot's ID is not already present.
+ *
+ * @param index Pointer to the ID index.
+ * @param ids ID column of the store the index points into.
+ * @param slot Store slot to index.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int indexInsert(IdIndex *index, const int *ids, size_t slot) {
+    if ((index->count + 1) * 2 > index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : INDEX_MIN_CAPACITY;
+        if (indexResize(index, ids, capacity) != INV_OK) {
+            return INV_ERR_NOMEM;
+        }
+    }
+
+    size_t mask = index->capacity - 1;
+    size_t i = hashId(ids[slot]) & mask;
+    while (index->slots[i] != INDEX_EMPTY) {
+        i = (i + 1) & mask;
+    }
+    index->slots[i] = (uint32_t)slot;
+    index->count++;
+    return INV_OK;
+}
+
+/**
+ * @brief Removes a product ID from the ID index.
+ *
+ * Uses backward-shift deletion so the table never accumulates tombstones.
+ *
+ * @param index Pointer to the ID index.
+ * @param ids ID column of the store the index points into.
+ * @param id Product ID to remove.
+ */
+static void indexRemove(IdIndex *index, const int *ids, int id) {
+    if (index->capacity == 0) {
+        return;
+    }
+
+    size_t mask = index->capacity - 1;
+    size_t i = hashId(id) & mask;
+    while (index->slots[i] != INDEX_EMPTY && ids[index->slots[i]] != id) {
+        i = (i + 1) & mask;
+    }
+    if (index->slots[i] == INDEX_EMPTY) {
+        return;
+    }
+
+    // Shift following entries of the probe run back into the hole
+    size_t j = i;
+    while (1) {
+        j = (j + 1) & mask;
+        if (index->slots[j] == INDEX_EMPTY) {
+            break;
+        }
+        size_t home = hashId(ids[index->slots[j]]) & mask;
+        // Move the entry only if its home slot is not cyclically within (i, j]
+        if ((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))) {
+            index->slots[i] = index->slots[j];
+            i = j;
+        }
+    }
+    index->slots[i] = INDEX_EMPTY;
+    index->count--;
+}
+
+/**
+ * @brief Tells whether one (key, product ID) pair sorts before another.
+ *
+ * @return Non-zero if (keyA, idA) comes first.
+ */
+static int orderBefore(int keyA, int idA, int keyB, int idB) {
+    return keyA < keyB || (keyA == keyB && idA < idB);
+}
+
+/**
+ * @brief Compares two ordered-index nodes by key, then product ID, for qsort.
+ */
+static int orderCompare(const void *a, const void *b) {
+    const OrderNode *x = (const OrderNode *)a;
+    const OrderNode *y = (const OrderNode *)b;
+    if (orderBefore(x->key, x->id, y->key, y->id)) {
+        return -1;
+    }
+    return orderBefore(y->key, y->id, x->key, x->id);
+}
+
+/**
+ * @brief Draws a random node priority (xorshift32).
+ *
+ * @param order Pointer to the ordered index.
+ * @return Priority.
+ */
+static uint32_t orderPriority(OrderIndex *order) {
+    uint32_t x = order->seed ? order->seed : 0x9e3779b9U;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    order->seed = x;
+    return x;
+}
+
+/**
+ * @brief Grows the node array of an ordered index to hold at least the given number of nodes.
+ *
+ * @param order Pointer to the ordered index.
+ * @param needed Minimum number of nodes required.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int orderReserve(OrderIndex *order, size_t needed) {
+    if (needed <= order->capacity) {
+        return INV_OK;
+    }
+    size_t capacity = order->capacity ? order->capacity : STORE_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    OrderNode *nodes = (OrderNode *)realloc(order->nodes, capacity * sizeof(OrderNode));
+    if (nodes == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    storeAllocations++;
+    order->nodes = nodes;
+    order->capacity = capacity;
+    return INV_OK;
+}
+
+/**
+ * @brief Empties an ordered index and marks it for rebuilding, keeping its node array.
+ *
+ * @param order Pointer to the ordered index.
+ */
+static void orderReset(OrderIndex *order) {
+    order->used = 0;
+    order->root = ORDER_NIL;
+    order->freeList = ORDER_NIL;
+    order->valid = 0;
+}
+
+/**
+ * @brief Splits a subtree into the nodes before (key, id) and the rest.
+ *
+ * @param nodes Node array.
+ * @param tree Root of the subtree.
+ * @param key Key to split at.
+ * @param id Product ID to split at.
+ * @param left Receives the root of the nodes sorting before (key, id).
+ * @param right Receives the root of the remaining nodes.
+ */
+static void orderSplit(OrderNode *nodes, uint32_t tree, int key, int id, uint32_t *left, uint32_t *right) {
+    while (tree != ORDER_NIL) {
+        if (orderBefore(nodes[tree].key, nodes[tree].id, key, id)) {
+            *left = tree;
+            left = &nodes[tree].right;
+            tree = nodes[tree].right;
+        } else {
+            *right = tree;
+            right = &nodes[tree].left;
+            tree = nodes[tree].left;
+        }
+    }
+    *left = ORDER_NIL;
+    *right = ORDER_NIL;
+}
+
+/**
+ * @brief Joins two subtrees where every node of the first sorts before every node of the second.
+ *
+ * @param nodes Node array.
+ * @param a Root of the first subtree.
+ * @param b Root of the second subtree.
+ * @return Root of the joined tree.
+ */
+static uint32_t orderMerge(OrderNode *nodes, uint32_t a, uint32_t b) {
+    uint32_t root;
+    uint32_t *link = &root;
+    while (a != ORDER_NIL && b != ORDER_NIL) {
+        if (nodes[a].priority > nodes[b].priority) {
+            *link = a;
+            link = &nodes[a].right;
+            a = nodes[a].right;
+        } else {
+            *link = b;
+            link = &nodes[b].left;
+            b = nodes[b].left;
+        }
+    }
+    *link = a != ORDER_NIL ? a : b;
+    return root;
+}
+
+/**
+ * @brief Adds a (key, product ID) pair to a built ordered index in expected O(log n).
+ *
+ * @param order Pointer to the ordered index.
+ * @param key Price in cents or quantity.
+ * @param id Product ID.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int orderInsert(OrderIndex *order, int key, int id) {
+    uint32_t node = order->freeList;
+    if (node != ORDER_NIL) {
+        order->freeList = order->nodes[node].left;
+    } else {
+        if (orderReserve(order, order->used + 1) != INV_OK) {
+            return INV_ERR_NOMEM;
+        }
+        node = (uint32_t)order->used++;
+    }
+
+    OrderNode *nodes = order->nodes;
+    nodes[node].key = key;
+    nodes[node].id = id;
+    nodes[node].priority = orderPriority(order);
+
+    // Walk down to where the new node's priority fits, then split that subtree around it
+    uint32_t *link = &order->root;
+    while (*link != ORDER_NIL && nodes[*link].priority >= nodes[node].priority) {
+        link = orderBefore(key, id, nodes[*link].key, nodes[*link].id) ? &nodes[*link].left : &nodes[*link].right;
+    }
+    orderSplit(nodes, *link, key, id, &nodes[node].left, &nodes[node].right);
+    *link = node;
+    return INV_OK;
+}
+
+/**
+ * @brief Removes a (key, product ID) pair from a built ordered index in expected O(log n).
+ *
+ * @param order Pointer to the ordered index.
+ * @param key Price in cents or quantity.
+ * @param id Product ID.
+ */
+static void orderRemove(OrderIndex *order, int key, int id) {
+    OrderNode *nodes = order->nodes;
+    uint32_t *link = &order->root;
+    while (*link != ORDER_NIL && (nodes[*link].key != key || nodes[*link].id != id)) {
+        link = orderBefore(key, id, nodes[*link].key, nodes[*link].id) ? &nodes[*link].left : &nodes[*link].right;
+    }
+    if (*link == ORDER_NIL) {
+        return;
+    }
+    uint32_t node = *link;
+    *link = orderMerge(nodes, nodes[node].left, nodes[node].right);
+    nodes[node].left = order->freeList;
+    order->freeList = node;
+}
+
+/**
+ * @brief Keeps an ordered index in step with a key change, if the index is built.
+ *
+ * An allocation failure drops the index back to unbuilt, so the next query rebuilds it.
+ *
+ * @param order Pointer to the ordered index.
+ * @param oldKey Previous key, ignored when adding.
+ * @param newKey New key, ignored when removing.
+ * @param id Product ID.
+ * @param change 1 to add, -1 to remove, 0 to move from oldKey to newKey.
+ */
+static void orderTrack(OrderIndex *order, int oldKey, int newKey, int id, int change) {
+    if (!order->valid || (change == 0 && oldKey == newKey)) {
+        return;
+    }
+    if (change <= 0) {
+        orderRemove(order, oldKey, id);
+    }
+    if (change >= 0 && orderInsert(order, newKey, id) != INV_OK) {
+        order->valid = 0;
+    }
+}
+
+/**
+ * @brief Maps a character to its symbol in the trigram alphabet, ignoring case.
+ *
+ * @param c Character.
+ * @return Symbol between 0 and NAME_ALPHABET - 1.
+ */
+static int nameSymbol(unsigned char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 1;
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 1;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 27;
+    }
+    return 0;
+}
+
+/**
+ * @brief Lists the distinct trigrams of a name.
+ *
+ * @param name Name text.
+ * @param length Bytes of name to use, at most NAME_SIZE - 1.
+ * @param trigrams Receives up to NAME_MAX_TRIGRAMS trigram codes.
+ * @return Number of distinct trigrams.
+ */
+static size_t nameTrigrams(const char *name, size_t length, uint32_t *trigrams) {
+    size_t count = 0;
+    for (size_t i = 0; i + 3 <= length; i++) {
+        uint32_t code = (uint32_t)((nameSymbol((unsigned char)name[i]) * NAME_ALPHABET +
+                                    nameSymbol((unsigned char)name[i + 1])) * NAME_ALPHABET +
+                                   nameSymbol((unsigned char)name[i + 2]));
+        size_t j = 0;
+        while (j < count && trigrams[j] != code) {
+            j++;
+        }
+        if (j == count) {
+            trigrams[count++] = code;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Adds a product's name to a built name index.
+ *
+ * An allocation failure drops the index back to unbuilt, so the next search rebuilds it.
+ *
+ * @param names Pointer to the name index.
+ * @param slot Store slot of the product.
+ * @param name Product name.
+ */
+static void nameAdd(NameIndex *names, size_t slot, const char *name) {
+    if (!names->valid) {
+        return;
+    }
+    uint32_t trigrams[NAME_MAX_TRIGRAMS];
+    size_t count = nameTrigrams(name, strnlen(name, NAME_SIZE - 1), trigrams);
+    for (size_t i = 0; i < count; i++) {
+        NamePosting *posting = &names->postings[trigrams[i]];
+        if (posting->count == posting->capacity) {
+            uint32_t capacity = posting->capacity ? posting->capacity * 2 : 4;
+            uint32_t *slots = (uint32_t *)realloc(posting->slots, capacity * sizeof(uint32_t));
+            if (slots == NULL) {
+                names->valid = 0;
+                return;
+            }
+            storeAllocations++;
+            posting->slots = slots;
+            posting->capacity = capacity;
+        }
+        posting->slots[posting->count++] = (uint32_t)slot;
+    }
+    names->entries += count;
+}
+
+/**
+ * @brief Records that a product's name left the index, by counting its entries as stale.
+ *
+ * @param names Pointer to the name index.
+ * @param name Name that is no longer current.
+ */
+static void nameDrop(NameIndex *names, const char *name) {
+    if (!names->valid) {
+        return;
+    }
+    uint32_t trigrams[NAME_MAX_TRIGRAMS];
+    names->stale += nameTrigrams(name, strnlen(name, NAME_SIZE - 1), trigrams);
+}
+
+/**
+ * @brief Empties a name index and marks it for rebuilding, keeping its posting lists.
+ *
+ * @param names Pointer to the name index.
+ */
+static void nameReset(NameIndex *names) {
+    if (names->postings != NULL) {
+        for (size_t i = 0; i < NAME_TRIGRAMS; i++) {
+            names->postings[i].count = 0;
+        }
+    }
+    names->entries = 0;
+    names->stale = 0;
+    names->renamed = 0;
+    names->valid = 0;
+}
+
+/**
+ * @brief Frees every posting list of a name index.
+ *
+ * @param names Pointer to the name index.
+ */
+static void nameFree(NameIndex *names) {
+    if (names->postings != NULL) {
+        for (size_t i = 0; i < NAME_TRIGRAMS; i++) {
+            free(names->postings[i].slots);
+        }
+        free(names->postings);
+    }
+    memset(names, 0, sizeof(*names));
+}
+
+/**
+ * @brief Tells whether a name contains, or starts with, a query, ignoring case.
+ *
+ * @param name Product name.
+ * @param query Query text.
+ * @param length Bytes in query.
+ * @param prefixOnly Non-zero to match only at the start of the name.
+ * @return Non-zero on a match.
+ */
+int nameMatches(const char *name, const char *query, size_t length, int prefixOnly) {
+    for (const char *start = name; *start != '\0'; start++) {
+        size_t i = 0;
+        while (i < length && start[i] != '\0' && tolower((unsigned char)start[i]) == tolower((unsigned char)query[i])) {
+            i++;
+        }
+        if (i == length) {
+            return 1;
+        }
+        if (prefixOnly) {
+            return 0;
+        }
+    }
+    return length == 0;
+}
+
+/**
+ * @brief Hashes a name for the intern table (FNV-1a).
+ *
+ * @param name Name bytes.
+ * @param length Number of bytes.
+ * @return Hash value.
+ */
+static uint32_t arenaHash(const char *name, size_t length) {
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * @brief Looks a name up in the intern table.
+ *
+ * @param arena Pointer to the name arena.
+ * @param name Name bytes.
+ * @param length Number of bytes.
+ * @param hash arenaHash of the name.
+ * @return Table position holding the name, or the empty position where it belongs.
+ */
+static size_t arenaProbe(const NameArena *arena, const char *name, size_t length, uint32_t hash) {
+    size_t mask = arena->tableCapacity - 1;
+    size_t i = hash & mask;
+    while (arena->table[i] != INDEX_EMPTY) {
+        const char *entry = arena->bytes + arena->table[i];
+        if (strncmp(entry, name, length) == 0 && entry[length] == '\0') { // stops at a shorter entry's end
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/**
+ * @brief Rehashes the intern table into a new table of the given capacity.
+ *
+ * @param arena Pointer to the name arena.
+ * @param capacity New capacity, a power of two.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int arenaResize(NameArena *arena, size_t capacity) {
+    uint32_t *table = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    if (table == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    storeAllocations++;
+    memset(table, 0xff, capacity * sizeof(uint32_t));
+    uint32_t *old = arena->table;
+    size_t oldCapacity = arena->tableCapacity;
+    arena->table = table;
+    arena->tableCapacity = capacity;
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i] != INDEX_EMPTY) {
+            const char *entry = arena->bytes + old[i];
+            size_t length = strlen(entry);
+            table[arenaProbe(arena, entry, length, arenaHash(entry, length))] = old[i];
+        }
+    }
+    free(old);
+    return INV_OK;
+}
+
+/**
+ * @brief Adds a name already stored in the arena to the intern table, unless it is there.
+ *
+ * @param arena Pointer to the name arena.
+ * @param offset Offset of the name.
+ * @param length Bytes in the name.
+ * @return Offset of the interned copy of the name, or INDEX_EMPTY if memory allocation failed.
+ */
+static uint32_t arenaTableAdd(NameArena *arena, uint32_t offset, size_t length) {
+    if ((arena->distinct + 1) * 2 > arena->tableCapacity &&
+        arenaResize(arena, arena->tableCapacity ? arena->tableCapacity * 2 : INDEX_MIN_CAPACITY) != INV_OK) {
+        return INDEX_EMPTY;
+    }
+    const char *name = arena->bytes + offset;
+    size_t i = arenaProbe(arena, name, length, arenaHash(name, length));
+    if (arena->table[i] == INDEX_EMPTY) {
+        arena->table[i] = offset;
+        arena->distinct++;
+    }
+    return arena->table[i];
+}
+
+/**
+ * @brief Stores a name in the arena, or finds the copy already there.
+ *
+ * Names loaded in bulk (a snapshot's name pool) are added to the intern table on the first
+ * call after the load, so loading itself does no hashing.
+ *
+ * @param arena Pointer to the name arena.
+ * @param name Name bytes; need not be terminated.
+ * @param length Bytes in the name, at most NAME_SIZE - 1.
+ * @param ref Receives the handle of the interned name.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int arenaIntern(NameArena *arena, const char *name, size_t length, NameRef *ref) {
+    while (arena->indexed < arena->used) {
+        size_t entryLength = strlen(arena->bytes + arena->indexed);
+        if (arenaTableAdd(arena, (uint32_t)arena->indexed, entryLength) == INDEX_EMPTY) {
+            return INV_ERR_NOMEM;
+        }
+        arena->indexed += entryLength + 1;
+    }
+    if ((arena->distinct + 1) * 2 > arena->tableCapacity &&
+        arenaResize(arena, arena->tableCapacity ? arena->tableCapacity * 2 : INDEX_MIN_CAPACITY) != INV_OK) {
+        return INV_ERR_NOMEM;
+    }
+
+    uint32_t hash = arenaHash(name, length);
+    size_t i = arenaProbe(arena, name, length, hash);
+    if (arena->table[i] == INDEX_EMPTY) {
+        if (arena->used + length + 1 > arena->capacity) {
+            size_t capacity = arena->capacity ? arena->capacity : LOAD_CHUNK_SIZE;
+            while (capacity < arena->used + length + 1) {
+                capacity *= 2;
+            }
+            char *bytes = capacity <= UINT32_MAX ? (char *)realloc(arena->bytes, capacity) : NULL;
+            if (bytes == NULL) {
+                return INV_ERR_NOMEM;
+            }
+            storeAllocations++;
+            arena->bytes = bytes;
+            arena->capacity = capacity;
+        }
+        memcpy(arena->bytes + arena->used, name, length);
+        arena->bytes[arena->used + length] = '\0';
+        arena->table[i] = (uint32_t)arena->used;
+        arena->distinct++;
+        arena->used += length + 1;
+        arena->indexed = arena->used;
+    }
+    ref->offset = arena->table[i];
+    ref->length = (uint32_t)length;
+    return INV_OK;
+}
+
+/**
+ * @brief Empties the arena, keeping its buffers.
+ *
+ * @param arena Pointer to the name arena.
+ */
+static void arenaReset(NameArena *arena) {
+    arena->used = 0;
+    arena->indexed = 0;
+    arena->distinct = 0;
+    arena->dropped = 0;
+    if (arena->table != NULL) {
+        memset(arena->table, 0xff, arena->tableCapacity * sizeof(uint32_t));
+    }
+}
+
+/**
+ * @brief Grows every column of the store to hold at least the given number of slots.
+ *
+ * @param inv Pointer to the inventory.
+ * @param needed Minimum number of slots required.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int storeReserve(Inventory *inv, size_t needed) {
+    if (needed <= inv->capacity) {
+        return INV_OK;
+    }
+    size_t capacity = inv->capacity ? inv->capacity : STORE_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    // Columns that were already grown stay valid if a later one fails
+    int *ids = (int *)realloc(inv->ids, capacity * sizeof(int));
+    if (ids == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    inv->ids = ids;
+    int *priceCents = (int *)realloc(inv->priceCents, capacity * sizeof(int));
+    if (priceCents == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    inv->priceCents = priceCents;
+    int *quantities = (int *)realloc(inv->quantities, capacity * sizeof(int));
+    if (quantities == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    inv->quantities = quantities;
+    NameRef *nameRefs = (NameRef *)realloc(inv->nameRefs, capacity * sizeof(NameRef));
+    if (nameRefs == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    inv->nameRefs = nameRefs;
+    unsigned char *live = (unsigned char *)realloc(inv->live, capacity);
+    if (live == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    inv->live = live;
+    if (inv->versions.heads != NULL) {
+        uint32_t *heads = (uint32_t *)realloc(inv->versions.heads, capacity * sizeof(uint32_t));
+        if (heads == NULL) {
+            return INV_ERR_NOMEM;
+        }
+        memset(heads + inv->capacity, 0xff, (capacity - inv->capacity) * sizeof(uint32_t));
+        inv->versions.heads = heads;
+    }
+
+    storeAllocations += 5;
+    inv->capacity = capacity;
+    return INV_OK;
+}
+
+/**
+ * @brief Squeezes tombstones out of the store, keeping products in insertion order.
+ *
+ * Slots change, so the ID index is rebuilt afterwards.
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void storeCompact(Inventory *inv) {
+    size_t out = 0;
+    for (size_t i = 0; i < inv->count; i++) {
+        if (!inv->live[i]) {
+            continue;
+        }
+        if (out != i) {
+            inv->ids[out] = inv->ids[i];
+            inv->priceCents[out] = inv->priceCents[i];
+            inv->quantities[out] = inv->quantities[i];
+            inv->nameRefs[out] = inv->nameRefs[i];
+            inv->live[out] = 1;
+        }
+        out++;
+    }
+    inv->count = out;
+    nameReset(&inv->nameIndex);
+
+    // The index never needs to grow here, since it already held every live product
+    memset(inv->index.slots, 0xff, inv->index.capacity * sizeof(uint32_t));
+    inv->index.count = 0;
+    for (size_t i = 0; i < inv->count; i++) {
+        indexInsert(&inv->index, inv->ids, i);
+    }
+}
+
+/**
+ * @brief Returns the name of the product in a slot.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot.
+ * @return NUL-terminated name, valid until the next change to the inventory.
+ */
+const char *inventoryName(const Inventory *inv, size_t slot) {
+    return inv->arena.bytes + inv->nameRefs[slot].offset;
+}
+
+/**
+ * @brief Rebuilds the name arena from the names still in use, once unused names fill half of it.
+ *
+ * New handles go to a fresh column, so running out of memory part-way leaves the store intact.
+ * Held back while snapshots are open, since their saved rows point into the old arena.
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void storeCompactNames(Inventory *inv) {
+    NameArena *arena = &inv->arena;
+    if (inv->versions.open > 0 || arena->used < ARENA_MIN_COMPACT || arena->dropped * 2 <= arena->used) {
+        return;
+    }
+    NameArena fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    NameRef *refs = (NameRef *)malloc(inv->capacity * sizeof(NameRef));
+    int failed = refs == NULL;
+    for (size_t i = 0; i < inv->count && !failed; i++) {
+        refs[i].offset = 0;
+        refs[i].length = 0;
+        if (inv->live[i]) {
+            failed = arenaIntern(&fresh, inventoryName(inv, i), inv->nameRefs[i].length, &refs[i]) != INV_OK;
+        }
+    }
+    if (failed) {
+        free(refs);
+        free(fresh.bytes);
+        free(fresh.table);
+        return;
+    }
+    free(inv->nameRefs);
+    free(arena->bytes);
+    free(arena->table);
+    inv->nameRefs = refs;
+    *arena = fresh;
+}
+
+/**
+ * @brief Forgets every saved row, once no open snapshot needs them.
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void versionsDrop(Inventory *inv) {
+    RowVersions *versions = &inv->versions;
+    for (size_t i = 0; i < versions->count; i++) {
+        versions->heads[versions->rows[i].slot] = VERSION_NONE;
+    }
+    versions->count = 0;
+}
+
+/**
+ * @brief Takes the view away from every open snapshot, whose next read then fails.
+ *
+ * Used when the store is replaced wholesale or a row could not be saved.
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void versionsInvalidate(Inventory *inv) {
+    RowVersions *versions = &inv->versions;
+    if (versions->open > 0) {
+        versions->generation++;
+        versions->open = 0;
+        versions->newest = 0;
+    }
+    versionsDrop(inv);
+}
+
+/**
+ * @brief Saves a row before it changes, if an open snapshot may still see it.
+ *
+ * A row written after the newest open snapshot was taken is invisible to all of them, so each
+ * row is saved at most once per snapshot however often it changes.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot about to change.
+ * @param quantity The row's quantity as the snapshots should see it (the current one, unless
+ *                 the caller has already changed it).
+ */
+static void versionSave(Inventory *inv, size_t slot, int quantity) {
+    RowVersions *versions = &inv->versions;
+    if (versions->open == 0) {
+        return;
+    }
+    uint32_t head = versions->heads != NULL ? versions->heads[slot] : VERSION_NONE;
+    if (head != VERSION_NONE && versions->rows[head].until > versions->newest) {
+        return;
+    }
+    if (versions->heads == NULL) {
+        versions->heads = (uint32_t *)malloc(inv->capacity * sizeof(uint32_t));
+        if (versions->heads == NULL) {
+            versionsInvalidate(inv);
+            return;
+        }
+        memset(versions->heads, 0xff, inv->capacity * sizeof(uint32_t));
+    }
+    if (versions->count == versions->capacity) {
+        size_t capacity = versions->capacity ? versions->capacity * 2 : STORE_MIN_CAPACITY;
+        RowVersion *rows = capacity < VERSION_NONE ? (RowVersion *)realloc(versions->rows, capacity * sizeof(RowVersion)) : NULL;
+        if (rows == NULL) {
+            versionsInvalidate(inv);
+            return;
+        }
+        versions->rows = rows;
+        versions->capacity = capacity;
+    }
+    RowVersion *row = &versions->rows[versions->count];
+    row->slot = (uint32_t)slot;
+    row->next = head;
+    row->until = versions->epoch;
+    row->id = inv->ids[slot];
+    row->priceCents = inv->priceCents[slot];
+    row->quantity = quantity;
+    row->name = inv->nameRefs[slot];
+    row->live = inv->live[slot];
+    versions->heads[slot] = (uint32_t)versions->count++;
+}
+
+/**
+ * @brief Initializes an empty inventory.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void inventoryInit(Inventory *inv) {
+    memset(inv, 0, sizeof(*inv));
+    inv->lowStockThreshold = LOW_STOCK_DEFAULT;
+}
+
+/**
+ * @brief Removes every product but keeps the allocated columns for reuse.
+ *
+ * A snapshot restore of similar size therefore makes no allocator calls at all.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void inventoryClear(Inventory *inv) {
+    versionsInvalidate(inv);
+    inv->count = 0;
+    inv->liveCount = 0;
+    inv->stockValueCents = 0;
+    inv->units = 0;
+    inv->lowStock = 0;
+    if (inv->index.slots != NULL) {
+        memset(inv->index.slots, 0xff, inv->index.capacity * sizeof(uint32_t));
+    }
+    inv->index.count = 0;
+    arenaReset(&inv->arena);
+    for (int c = 0; c < ORDER_COUNT; c++) {
+        orderReset(&inv->orders[c]);
+    }
+    nameReset(&inv->nameIndex);
+}
+
+/**
+ * @brief Frees all memory owned by the inventory, leaving it empty and detached from any log
+ * and reorder queue.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void inventoryFree(Inventory *inv) {
+    free(inv->ids);
+    free(inv->priceCents);
+    free(inv->quantities);
+    free(inv->nameRefs);
+    free(inv->live);
+    free(inv->arena.bytes);
+    free(inv->arena.table);
+    free(inv->index.slots);
+    for (int c = 0; c < ORDER_COUNT; c++) {
+        free(inv->orders[c].nodes);
+    }
+    nameFree(&inv->nameIndex);
+    free(inv->versions.rows);
+    free(inv->versions.heads);
+    inventoryInit(inv);
+}
+
+/**
+ * @brief Finds a product by ID in expected constant time.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id Product ID to find.
+ * @return Store slot of the product, or NO_SLOT if not found.
+ */
+size_t inventoryFind(const Inventory *inv, int id) {
+    return indexFind(&inv->index, inv->ids, id);
+}
+
+/**
+ * @brief Adds a product's price and quantity to the running totals, or takes them out.
+ *
+ * @param inv Pointer to the inventory.
+ * @param priceCents Product price.
+ * @param quantity Product quantity.
+ * @param change 1 to add the product, -1 to take it out.
+ */
+static void totalsTrack(Inventory *inv, int priceCents, int quantity, int change) {
+    inv->stockValueCents += change * (long long)priceCents * quantity;
+    inv->units += change * (long long)quantity;
+    if (quantity < inv->lowStockThreshold) {
+        inv->lowStock += (size_t)change;
+    }
+}
+
+/**
+ * @brief Recomputes the running totals from the columns, after a bulk load.
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void totalsRebuild(Inventory *inv) {
+    InventoryTotals totals;
+    inventoryRecount(inv, &totals);
+    inv->stockValueCents = totals.stockValueCents;
+    inv->units = totals.units;
+    inv->lowStock = totals.lowStock;
+}
+
+/**
+ * @brief Reads the stock report figures from the running totals, in constant time.
+ *
+ * @param inv Pointer to the inventory.
+ * @param totals Receives the figures.
+ */
+void inventoryTotals(const Inventory *inv, InventoryTotals *totals) {
+    totals->stockValueCents = inv->stockValueCents;
+    totals->units = inv->units;
+    totals->skus = inv->liveCount;
+    totals->lowStock = inv->lowStock;
+}
+
+/**
+ * @brief Computes the stock report figures from scratch by scanning every product.
+ *
+ * Used to rebuild the running totals and to check them: after any sequence of changes the
+ * result must equal inventoryTotals.
+ *
+ * @param inv Pointer to the inventory.
+ * @param totals Receives the figures.
+ */
+void inventoryRecount(const Inventory *inv, InventoryTotals *totals) {
+    totals->stockValueCents = valuationKernel()(inv->priceCents, inv->quantities, inv->count);
+    totals->units = 0;
+    totals->skus = 0;
+    totals->lowStock = 0;
+    for (size_t i = 0; i < inv->count; i++) {
+        if (inv->live[i]) {
+            totals->units += inv->quantities[i];
+            totals->skus++;
+            totals->lowStock += inv->quantities[i] < inv->lowStockThreshold;
+        }
+    }
+}
+
+/**
+ * @brief Sets the quantity below which a product counts as low on stock.
+ *
+ * Recounts the low-stock products, so this is the one report change that costs a scan.
+ *
+ * @param inv Pointer to the inventory.
+ * @param threshold New threshold.
+ */
+void inventorySetLowStock(Inventory *inv, int threshold) {
+    inv->lowStockThreshold = threshold;
+    totalsRebuild(inv);
+}
+
+/**
+ * @brief Adds two numbers given as logarithms, returning the logarithm of their sum.
+ *
+ * @param a Logarithm of the first number; -INFINITY for zero.
+ * @param b Logarithm of the second number; -INFINITY for zero.
+ * @return log(e^a + e^b), computed without overflowing.
+ */
+static double logAdd(double a, double b) {
+    if (a == -INFINITY) {
+        return b;
+    }
+    if (b == -INFINITY) {
+        return a;
+    }
+    return a > b ? a + log1p(exp(b - a)) : b + log1p(exp(a - b));
+}
+
+/**
+ * @brief Computes a reorder entry's heap key: the log of its days of cover, less now / tau.
+ *
+ * @param entry Pointer to the entry.
+ * @return -INFINITY when out of stock, INFINITY when nothing sold.
+ */
+static double reorderKey(const ReorderEntry *entry) {
+    if (entry->quantity <= 0) {
+        return -INFINITY;
+    }
+    if (entry->logDemand == -INFINITY) {
+        return INFINITY;
+    }
+    return log((double)entry->quantity) - entry->logDemand;
+}
+
+/**
+ * @brief Tells whether one entry is more urgent than another: less cover, then lower ID.
+ */
+static int reorderBefore(const ReorderQueue *queue, uint32_t a, uint32_t b) {
+    const ReorderEntry *x = &queue->entries[a];
+    const ReorderEntry *y = &queue->entries[b];
+    return x->key != y->key ? x->key < y->key : x->id < y->id;
+}
+
+/**
+ * @brief Puts an entry at a heap position and records the position in the entry.
+ */
+static void reorderPlace(ReorderQueue *queue, size_t position, uint32_t entry) {
+    queue->heap[position] = entry;
+    queue->entries[entry].heapPos = (uint32_t)position;
+}
+
+/**
+ * @brief Moves the entry at a heap position down until neither child comes before it.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param position Heap position.
+ */
+static void reorderSiftDown(ReorderQueue *queue, size_t position) {
+    uint32_t entry = queue->heap[position];
+    for (;;) {
+        size_t child = 2 * position + 1;
+        if (child >= queue->heapCount) {
+            break;
+        }
+        if (child + 1 < queue->heapCount && reorderBefore(queue, queue->heap[child + 1], queue->heap[child])) {
+            child++;
+        }
+        if (!reorderBefore(queue, queue->heap[child], entry)) {
+            break;
+        }
+        reorderPlace(queue, position, queue->heap[child]);
+        position = child;
+    }
+    reorderPlace(queue, position, entry);
+}
+
+/**
+ * @brief Moves the entry at a heap position up or down until the heap is ordered again.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param position Heap position whose entry's key changed.
+ */
+static void reorderSift(ReorderQueue *queue, size_t position) {
+    uint32_t entry = queue->heap[position];
+    while (position > 0 && reorderBefore(queue, entry, queue->heap[(position - 1) / 2])) {
+        reorderPlace(queue, position, queue->heap[(position - 1) / 2]);
+        position = (position - 1) / 2;
+    }
+    reorderPlace(queue, position, entry);
+    reorderSiftDown(queue, position);
+}
+
+/**
+ * @brief Re-keys an entry and adds it to the due heap, moves it, or takes it out, as its stock
+ * and reorder point now require.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param entry Entry that changed.
+ */
+static void reorderRefresh(ReorderQueue *queue, uint32_t entry) {
+    ReorderEntry *e = &queue->entries[entry];
+    e->key = reorderKey(e);
+    int due = e->quantity <= e->point;
+    if (e->heapPos != VERSION_NONE) {
+        size_t position = e->heapPos;
+        if (due) {
+            reorderSift(queue, position);
+            return;
+        }
+        e->heapPos = VERSION_NONE;
+        uint32_t last = queue->heap[--queue->heapCount];
+        if (position < queue->heapCount) {
+            reorderPlace(queue, position, last);
+            reorderSift(queue, position);
+        }
+    } else if (due) {
+        reorderPlace(queue, queue->heapCount++, entry);
+        reorderSift(queue, queue->heapCount - 1);
+    }
+}
+
+/**
+ * @brief Grows the entry, ID and heap arrays of a reorder queue to hold at least needed entries.
+ *
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int reorderReserve(ReorderQueue *queue, size_t needed) {
+    if (needed <= queue->capacity) {
+        return INV_OK;
+    }
+    size_t capacity = queue->capacity ? queue->capacity : STORE_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    ReorderEntry *entries = (ReorderEntry *)realloc(queue->entries, capacity * sizeof(ReorderEntry));
+    if (entries == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    queue->entries = entries;
+    int *ids = (int *)realloc(queue->ids, capacity * sizeof(int));
+    if (ids == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    queue->ids = ids;
+    uint32_t *heap = (uint32_t *)realloc(queue->heap, capacity * sizeof(uint32_t));
+    if (heap == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    queue->heap = heap;
+    queue->capacity = capacity;
+    return INV_OK;
+}
+
+/**
+ * @brief Appends an entry with the default reorder point and no sales, not yet indexed.
+ *
+ * @return Position of the entry, or NO_SLOT if memory allocation failed.
+ */
+static size_t reorderAppend(ReorderQueue *queue, int id, int quantity) {
+    if (queue->count >= VERSION_NONE || reorderReserve(queue, queue->count + 1) != INV_OK) {
+        return NO_SLOT;
+    }
+    ReorderEntry *entry = &queue->entries[queue->count];
+    memset(entry, 0, sizeof(*entry));
+    entry->id = id;
+    entry->quantity = quantity;
+    entry->point = queue->defaultPoint;
+    entry->heapPos = VERSION_NONE;
+    entry->logDemand = -INFINITY;
+    queue->ids[queue->count] = id;
+    return queue->count++;
+}
+
+/**
+ * @brief Starts tracking a newly added product.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param id Product ID.
+ * @param quantity Its stock.
+ */
+static void reorderTrack(ReorderQueue *queue, int id, int quantity) {
+    size_t entry = reorderAppend(queue, id, quantity);
+    if (entry == NO_SLOT || indexInsert(&queue->index, queue->ids, entry) != INV_OK) {
+        queue->count -= entry != NO_SLOT;
+        queue->failed = 1;
+        return;
+    }
+    reorderRefresh(queue, (uint32_t)entry);
+}
+
+/**
+ * @brief Brings a product's entry up to date after its stock changed.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param id Product ID.
+ * @param quantity New stock.
+ */
+static void reorderStock(ReorderQueue *queue, int id, int quantity) {
+    size_t entry = indexFind(&queue->index, queue->ids, id);
+    if (entry == NO_SLOT) {
+        return;
+    }
+    queue->entries[entry].quantity = quantity;
+    reorderRefresh(queue, (uint32_t)entry);
+}
+
+/**
+ * @brief Adds units sold to a product's demand. The stock change that goes with the sale
+ * re-keys the entry.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param id Product ID.
+ * @param units Units sold.
+ * @param time Time of the sale, seconds since the epoch.
+ */
+static void reorderSold(ReorderQueue *queue, int id, int units, int64_t time) {
+    size_t entry = indexFind(&queue->index, queue->ids, id);
+    if (entry != NO_SLOT && units > 0) {
+        ReorderEntry *e = &queue->entries[entry];
+        e->logDemand = logAdd(e->logDemand, log((double)units) + time / 86400.0 / REORDER_DEMAND_DAYS);
+    }
+}
+
+/**
+ * @brief Stops tracking a deleted product, moving the last entry into its place.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param id Product ID.
+ */
+static void reorderForget(ReorderQueue *queue, int id) {
+    size_t entry = indexFind(&queue->index, queue->ids, id);
+    if (entry == NO_SLOT) {
+        return;
+    }
+    queue->entries[entry].point = INT_MIN; // never due, so the refresh takes it out of the heap
+    reorderRefresh(queue, (uint32_t)entry);
+    indexRemove(&queue->index, queue->ids, id);
+    size_t last = --queue->count;
+    if (entry != last) {
+        indexRemove(&queue->index, queue->ids, queue->ids[last]);
+        queue->entries[entry] = queue->entries[last];
+        queue->ids[entry] = queue->ids[last];
+        indexInsert(&queue->index, queue->ids, entry); // never grows: two entries just left
+        if (queue->entries[entry].heapPos != VERSION_NONE) {
+            queue->heap[queue->entries[entry].heapPos] = (uint32_t)entry;
+        }
+    }
+}
+
+/**
+ * @brief Re-keys every entry and rebuilds the due heap bottom-up, in O(n).
+ *
+ * @param queue Pointer to the reorder queue.
+ */
+static void reorderHeapify(ReorderQueue *queue) {
+    queue->heapCount = 0;
+    for (size_t i = 0; i < queue->count; i++) {
+        ReorderEntry *entry = &queue->entries[i];
+        entry->key = reorderKey(entry);
+        entry->heapPos = VERSION_NONE;
+        if (entry->quantity <= entry->point) {
+            reorderPlace(queue, queue->heapCount++, (uint32_t)i);
+        }
+    }
+    for (size_t i = queue->heapCount / 2; i-- > 0;) {
+        reorderSiftDown(queue, i);
+    }
+}
+
+/**
+ * @brief Brings a reorder queue in line with the whole store after a bulk load: products that
+ * are gone are dropped, new ones added, and every stock re-read. Rules and demand of products
+ * still present are kept.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param inv Pointer to the inventory.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed (the queue is marked
+ *         failed).
+ */
+static int reorderRebuild(ReorderQueue *queue, const Inventory *inv) {
+    unsigned char *seen = (unsigned char *)calloc(queue->count + inv->liveCount + 1, 1);
+    int status = seen == NULL ? INV_ERR_NOMEM : INV_OK;
+    for (size_t slot = 0; slot < inv->count && status == INV_OK; slot++) {
+        if (!inv->live[slot]) {
+            continue;
+        }
+        size_t entry = indexFind(&queue->index, queue->ids, inv->ids[slot]);
+        if (entry == NO_SLOT) {
+            entry = reorderAppend(queue, inv->ids[slot], inv->quantities[slot]);
+            status = entry == NO_SLOT ? INV_ERR_NOMEM : INV_OK;
+        }
+        if (status == INV_OK) {
+            queue->entries[entry].quantity = inv->quantities[slot];
+            seen[entry] = 1;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < queue->count && status == INV_OK; i++) {
+        if (seen[i]) {
+            queue->entries[kept] = queue->entries[i];
+            queue->ids[kept++] = queue->ids[i];
+        }
+    }
+    free(seen);
+    if (status == INV_OK) {
+        queue->count = kept;
+        if (queue->index.slots != NULL) {
+            memset(queue->index.slots, 0xff, queue->index.capacity * sizeof(uint32_t));
+        }
+        queue->index.count = 0;
+        for (size_t i = 0; i < queue->count && status == INV_OK; i++) {
+            status = indexInsert(&queue->index, queue->ids, i) != INV_OK ? INV_ERR_NOMEM : INV_OK;
+        }
+    }
+    if (status != INV_OK) {
+        queue->failed = 1;
+        return status;
+    }
+    reorderHeapify(queue);
+    queue->failed = 0;
+    return INV_OK;
+}
+
+/**
+ * @brief Initializes an empty reorder queue.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param defaultPoint Reorder point of products without one of their own.
+ */
+void reorderInit(ReorderQueue *queue, int defaultPoint) {
+    memset(queue, 0, sizeof(*queue));
+    queue->defaultPoint = defaultPoint;
+}
+
+/**
+ * @brief Builds a reorder queue from an inventory's products and has the inventory keep it up
+ * to date from then on. Attaching again rebuilds it, keeping rules and demand.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param inv Pointer to the inventory.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+int reorderAttach(ReorderQueue *queue, Inventory *inv) {
+    int status = reorderRebuild(queue, inv);
+    if (status == INV_OK) {
+        inv->reorder = queue;
+    }
+    return status;
+}
+
+/**
+ * @brief Frees a reorder queue. Detach it from its inventory first.
+ *
+ * @param queue Pointer to the reorder queue.
+ */
+void reorderFree(ReorderQueue *queue) {
+    free(queue->entries);
+    free(queue->ids);
+    free(queue->heap);
+    free(queue->index.slots);
+    reorderInit(queue, queue->defaultPoint);
+}
+
+/**
+ * @brief Sets a product's own reorder point and order size.
+ *
+ * @param inv Pointer to the inventory, with a reorder queue attached.
+ * @param id Product ID.
+ * @param point Reorder when stock is at or below this many units.
+ * @param orderUnits Units to order; 0 sizes each order from recent demand.
+ * @return INV_OK on success, INV_ERR_INVALID if point or orderUnits is negative or no queue is
+ *         attached, INV_ERR_NOT_FOUND if there is no such product.
+ */
+int reorderSetRule(Inventory *inv, int id, int point, int orderUnits) {
+    if (inv->reorder == NULL || point < 0 || orderUnits < 0) {
+        return INV_ERR_INVALID;
+    }
+    ReorderQueue *queue = inv->reorder;
+    size_t entry = indexFind(&queue->index, queue->ids, id);
+    if (entry == NO_SLOT) {
+        return INV_ERR_NOT_FOUND;
+    }
+    queue->entries[entry].point = point;
+    queue->entries[entry].orderUnits = orderUnits;
+    queue->entries[entry].custom = 1;
+    reorderRefresh(queue, (uint32_t)entry);
+    return INV_OK;
+}
+
+/**
+ * @brief Reads reorder rules, one "id point units" line each, as written by reorderSaveRules.
+ *
+ * Rules for products no longer in the inventory are skipped.
+ *
+ * @param inv Pointer to the inventory, with a reorder queue attached.
+ * @param path Rules file path.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be read, INV_ERR_INVALID on a
+ *         malformed line.
+ */
+int reorderLoadRules(Inventory *inv, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return INV_ERR_IO;
+    }
+    char line[128];
+    int status = INV_OK;
+    while (status == INV_OK && fgets(line, sizeof(line), fp) != NULL) {
+        const char *end = line + strcspn(line, "\r\n");
+        int id, point, units;
+        const char *p = scanInt(skipBlanks(line, end), end, &id);
+        p = p != NULL ? scanInt(skipBlanks(p, end), end, &point) : NULL;
+        p = p != NULL ? scanInt(skipBlanks(p, end), end, &units) : NULL;
+        if (p == NULL || skipBlanks(p, end) != end) {
+            status = INV_ERR_INVALID;
+        } else if (reorderSetRule(inv, id, point, units) == INV_ERR_INVALID) {
+            status = INV_ERR_INVALID;
+        }
+    }
+    fclose(fp);
+    return status;
+}
+
+/**
+ * @brief Writes the rules set with reorderSetRule, one "id point units" line each.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param path Rules file path.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be written.
+ */
+int reorderSaveRules(const ReorderQueue *queue, const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        return INV_ERR_IO;
+    }
+    for (size_t i = 0; i < queue->count; i++) {
+        const ReorderEntry *entry = &queue->entries[i];
+        if (entry->custom) {
+            fprintf(fp, "%d %d %d\n", entry->id, entry->point, entry->orderUnits);
+        }
+    }
+    int status = ferror(fp) ? INV_ERR_IO : INV_OK;
+    if (fclose(fp) != 0) {
+        status = INV_ERR_IO;
+    }
+    return status;
+}
+
+/**
+ * @brief Adds every bill in a ledger to the products' demand, then re-keys the whole queue.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param ledger Pointer to the sales ledger.
+ */
+void reorderReplay(ReorderQueue *queue, const Ledger *ledger) {
+    for (size_t b = 0; b < ledger->billCount; b++) {
+        const LedgerBill *bill = &ledger->bills[b];
+        for (size_t i = 0; i < bill->lineCount; i++) {
+            const SaleLine *line = &ledger->lines[bill->firstLine + i];
+            reorderSold(queue, line->id, line->quantity, bill->time);
+        }
+    }
+    reorderHeapify(queue);
+}
+
+/**
+ * @brief Fills in a reorder list line from an entry.
+ *
+ * @param entry Pointer to the entry.
+ * @param now Current time, seconds since the epoch.
+ * @param item Receives the line.
+ */
+static void reorderItem(const ReorderEntry *entry, int64_t now, ReorderItem *item) {
+    double demand = exp(entry->logDemand - now / 86400.0 / REORDER_DEMAND_DAYS) / REORDER_DEMAND_DAYS;
+    item->id = entry->id;
+    item->quantity = entry->quantity;
+    item->point = entry->point;
+    item->dailyDemand = demand;
+    item->daysOfCover = entry->quantity <= 0 ? 0 : demand > 0 ? entry->quantity / demand : INFINITY;
+    if (entry->orderUnits > 0) {
+        item->orderUnits = entry->orderUnits;
+    } else {
+        double cover = ceil(demand * REORDER_COVER_DAYS);
+        item->orderUnits = entry->point - entry->quantity + (cover > 1 ? (cover < INT_MAX / 2 ? (int)cover : INT_MAX / 2) : 1);
+    }
+}
+
+/**
+ * @brief Lists the products due for reordering, fewest days of cover first.
+ *
+ * Walks the due heap best-first, so the k most urgent cost O(k log k) whatever the catalogue's
+ * size.
+ *
+ * @param queue Pointer to the reorder queue.
+ * @param now Current time, seconds since the epoch, for demand and cover.
+ * @param items Receives up to max products.
+ * @param max Products wanted.
+ * @return Products written to items.
+ */
+size_t reorderDue(const ReorderQueue *queue, int64_t now, ReorderItem *items, size_t max) {
+    if (max == 0 || queue->heapCount == 0) {
+        return 0;
+    }
+    // Frontier of heap positions whose parents were listed, itself a min-heap
+    uint32_t *frontier = (uint32_t *)malloc((max + 1) * sizeof(uint32_t));
+    if (frontier == NULL) {
+        return 0;
+    }
+    size_t found = 0, size = 0;
+    frontier[size++] = 0;
+    while (size > 0 && found < max) {
+        uint32_t position = frontier[0];
+        frontier[0] = frontier[--size];
+        for (size_t i = 0;;) { // sift the moved position down
+            size_t child = 2 * i + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && reorderBefore(queue, queue->heap[frontier[child + 1]], queue->heap[frontier[child]])) {
+                child++;
+            }
+            if (!reorderBefore(queue, queue->heap[frontier[child]], queue->heap[frontier[i]])) {
+                break;
+            }
+            uint32_t swap = frontier[i];
+            frontier[i] = frontier[child];
+            frontier[child] = swap;
+            i = child;
+        }
+        reorderItem(&queue->entries[queue->heap[position]], now, &items[found++]);
+
+        for (size_t c = 2 * (size_t)position + 1; c <= 2 * (size_t)position + 2 && c < queue->heapCount && size <= max; c++) {
+            size_t i = size++;
+            while (i > 0 && reorderBefore(queue, queue->heap[c], queue->heap[frontier[(i - 1) / 2]])) {
+                frontier[i] = frontier[(i - 1) / 2];
+                i = (i - 1) / 2;
+            }
+            frontier[i] = (uint32_t)c;
+        }
+    }
+    free(frontier);
+    return found;
+}
+
+/**
+ * @brief Writes one purchase order, as CSV, for every product due for reordering, most urgent
+ * first, with the order's total on a last row.
+ *
+ * @param inv Pointer to the inventory, with a reorder queue attached.
+ * @param path Purchase order file path.
+ * @param now Current time, seconds since the epoch.
+ * @param lines Receives the number of products ordered. May be NULL.
+ * @param totalCents Receives the order's value at current prices. May be NULL.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be written, INV_ERR_NOMEM if memory
+ *         allocation failed, INV_ERR_INVALID if no queue is attached.
+ */
+int reorderWritePurchaseOrder(const Inventory *inv, const char *path, int64_t now, size_t *lines, long long *totalCents) {
+    static const char *const titles[] = {"product id", "name", "on hand", "daily demand", "days of cover", "order units", "unit price", "amount"};
+    static const int widths[] = {10, -20, 8, 12, 13, 11, 10, 12};
+    const ReorderQueue *queue = inv->reorder;
+    if (queue == NULL) {
+        return INV_ERR_INVALID;
+    }
+    ReorderItem *items = (ReorderItem *)malloc((queue->heapCount ? queue->heapCount : 1) * sizeof(ReorderItem));
+    if (items == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    size_t found = reorderDue(queue, now, items, queue->heapCount);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    Report report;
+    if (fd < 0 || reportOpen(&report, fd, REPORT_CSV) != INV_OK) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(items);
+        return INV_ERR_IO;
+    }
+    reportColumns(&report, 8, titles, widths);
+    long long total = 0;
+    char number[32];
+    for (size_t i = 0; i < found; i++) {
+        size_t slot = inventoryFind(inv, items[i].id);
+        long long amount = (long long)items[i].orderUnits * inv->priceCents[slot];
+        total += amount;
+        reportInt(&report, items[i].id);
+        reportText(&report, inventoryName(inv, slot));
+        reportInt(&report, items[i].quantity);
+        snprintf(number, sizeof(number), "%.2f", items[i].dailyDemand);
+        reportText(&report, number);
+        snprintf(number, sizeof(number), "%.1f", items[i].daysOfCover);
+        reportText(&report, isinf(items[i].daysOfCover) ? "" : number);
+        reportInt(&report, items[i].orderUnits);
+        reportCents(&report, inv->priceCents[slot]);
+        reportCents(&report, amount);
+        reportEndRow(&report);
+    }
+    for (int c = 0; c < 7; c++) {
+        reportText(&report, c == 0 ? "total" : "");
+    }
+    reportCents(&report, total);
+    reportEndRow(&report);
+    free(items);
+    int status = reportClose(&report);
+    if (close(fd) != 0) {
+        status = INV_ERR_IO;
+    }
+    if (lines != NULL) {
+        *lines = found;
+    }
+    if (totalCents != NULL) {
+        *totalCents = total;
+    }
+    return status;
+}
+
+/**
+ * @brief Writes the name, price and quantity of a product into a slot.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot.
+ * @param product Product details. The ID is ignored.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed (the slot is left
+ *         unchanged).
+ */
+static int storeSet(Inventory *inv, size_t slot, const Product *product) {
+    if (arenaIntern(&inv->arena, product->name, strnlen(product->name, NAME_SIZE - 1), &inv->nameRefs[slot]) != INV_OK) {
+        return INV_ERR_NOMEM;
+    }
+    inv->priceCents[slot] = product->priceCents;
+    inv->quantities[slot] = product->quantity;
+    return INV_OK;
+}
+
+/**
+ * @brief Appends a product to the store and indexes it.
+ *
+ * @param inv Pointer to the inventory.
+ * @param product Product to insert. Its ID must not already be in the inventory.
+ * @return Store slot of the new product, or NO_SLOT if memory allocation failed.
+ */
+size_t inventoryInsert(Inventory *inv, const Product *product) {
+    if (storeReserve(inv, inv->count + 1) != INV_OK) {
+        return NO_SLOT;
+    }
+
+    size_t slot = inv->count;
+    if (storeSet(inv, slot, product) != INV_OK) {
+        return NO_SLOT;
+    }
+    inv->ids[slot] = product->id;
+    if (indexInsert(&inv->index, inv->ids, slot) != INV_OK) {
+        return NO_SLOT;
+    }
+    inv->live[slot] = 1;
+    inv->count++;
+    inv->liveCount++;
+    totalsTrack(inv, product->priceCents, product->quantity, 1);
+    orderTrack(&inv->orders[ORDER_PRICE], 0, product->priceCents, product->id, 1);
+    orderTrack(&inv->orders[ORDER_QUANTITY], 0, product->quantity, product->id, 1);
+    nameAdd(&inv->nameIndex, slot, inventoryName(inv, slot));
+    if (inv->reorder != NULL) {
+        reorderTrack(inv->reorder, product->id, product->quantity);
+    }
+    if (inv->wal != NULL) {
+        walAppend(inv->wal, WAL_ADD, product->id, product);
+    }
+    return slot;
+}
+
+/**
+ * @brief Overwrites the name, price and quantity of the product in a slot.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot of the product.
+ * @param product New product details. The ID is ignored.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed (the product is left
+ *         unchanged).
+ */
+int inventoryUpdate(Inventory *inv, size_t slot, const Product *product) {
+    versionSave(inv, slot, inv->quantities[slot]);
+    NameRef old = inv->nameRefs[slot];
+    int oldPrice = inv->priceCents[slot];
+    int oldQuantity = inv->quantities[slot];
+    if (storeSet(inv, slot, product) != INV_OK) {
+        return INV_ERR_NOMEM;
+    }
+    totalsTrack(inv, oldPrice, oldQuantity, -1);
+    totalsTrack(inv, product->priceCents, product->quantity, 1);
+    orderTrack(&inv->orders[ORDER_PRICE], oldPrice, product->priceCents, inv->ids[slot], 0);
+    orderTrack(&inv->orders[ORDER_QUANTITY], oldQuantity, product->quantity, inv->ids[slot], 0);
+    if (inv->nameRefs[slot].offset != old.offset) { // interning makes equal names share an offset
+        nameDrop(&inv->nameIndex, inv->arena.bytes + old.offset);
+        nameAdd(&inv->nameIndex, slot, inventoryName(inv, slot));
+        inv->nameIndex.renamed = 1;
+        inv->arena.dropped += old.length + 1;
+    }
+    if (inv->reorder != NULL) {
+        reorderStock(inv->reorder, inv->ids[slot], product->quantity);
+    }
+    if (inv->wal != NULL) {
+        walAppend(inv->wal, WAL_UPDATE, inv->ids[slot], product);
+    }
+    storeCompactNames(inv);
+    return INV_OK;
+}
+
+/**
+ * @brief Deletes the product in a slot, leaving a tombstone.
+ *
+ * Once tombstones make up more than half of the store it is compacted, unless a snapshot is
+ * open.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot of the product.
+ */
+void inventoryRemove(Inventory *inv, size_t slot) {
+    if (inv->wal != NULL) {
+        walAppend(inv->wal, WAL_DELETE, inv->ids[slot], NULL);
+    }
+    versionSave(inv, slot, inv->quantities[slot]);
+    if (inv->reorder != NULL) {
+        reorderForget(inv->reorder, inv->ids[slot]);
+    }
+    indexRemove(&inv->index, inv->ids, inv->ids[slot]);
+    orderTrack(&inv->orders[ORDER_PRICE], inv->priceCents[slot], 0, inv->ids[slot], -1);
+    orderTrack(&inv->orders[ORDER_QUANTITY], inv->quantities[slot], 0, inv->ids[slot], -1);
+    nameDrop(&inv->nameIndex, inventoryName(inv, slot));
+    inv->arena.dropped += inv->nameRefs[slot].length + 1;
+    totalsTrack(inv, inv->priceCents[slot], inv->quantities[slot], -1);
+    inv->live[slot] = 0;
+    inv->priceCents[slot] = 0;
+    inv->quantities[slot] = 0;
+    inv->liveCount--;
+
+    if (inv->versions.open == 0 && inv->count >= STORE_MIN_CAPACITY && inv->liveCount * 2 < inv->count) {
+        storeCompact(inv);
+    }
+    storeCompactNames(inv);
+}
+
+/**
+ * @brief Copies the product in a slot out of the store.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot of the product.
+ * @param product Receives the product details.
+ */
+void inventoryGet(const Inventory *inv, size_t slot, Product *product) {
+    product->id = inv->ids[slot];
+    memcpy(product->name, inventoryName(inv, slot), inv->nameRefs[slot].length + 1);
+    product->priceCents = inv->priceCents[slot];
+    product->quantity = inv->quantities[slot];
+}
+
+/**
+ * @brief Brings the running totals, the quantity index, the reorder queue and the change log up
+ * to date after a slot's quantity was set.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot whose quantity changed.
+ * @param oldQuantity Quantity before the change.
+ */
+static void stockChanged(Inventory *inv, size_t slot, int oldQuantity) {
+    totalsTrack(inv, inv->priceCents[slot], oldQuantity, -1);
+    totalsTrack(inv, inv->priceCents[slot], inv->quantities[slot], 1);
+    orderTrack(&inv->orders[ORDER_QUANTITY], oldQuantity, inv->quantities[slot], inv->ids[slot], 0);
+    if (inv->reorder != NULL) {
+        reorderStock(inv->reorder, inv->ids[slot], inv->quantities[slot]);
+    }
+    if (inv->wal != NULL) {
+        Product product;
+        inventoryGet(inv, slot, &product);
+        walAppend(inv->wal, WAL_UPDATE, product.id, &product);
+    }
+}
+
+/**
+ * @brief Sets the stock quantity of the product in a slot, leaving its other details alone.
+ *
+ * Unlike inventoryUpdate this never touches the name, so it cannot fail.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slot Store slot of the product.
+ * @param quantity New quantity.
+ */
+void inventorySetQuantity(Inventory *inv, size_t slot, int quantity) {
+    int oldQuantity = inv->quantities[slot];
+    versionSave(inv, slot, oldQuantity);
+    inv->quantities[slot] = quantity;
+    stockChanged(inv, slot, oldQuantity);
+}
+
+/**
+ * @brief Takes a point-in-time snapshot of the inventory in constant time.
+ *
+ * Nothing is copied: the snapshot only ends the current epoch. Afterwards the first change to
+ * each row saves the old row, so the snapshot keeps reading products as they were now while
+ * adds, updates, deletes and sales go on. While any snapshot is open the store is not
+ * compacted. Release every snapshot with inventorySnapshotRelease.
+ *
+ * @param inv Pointer to the inventory.
+ * @param snapshot Receives the snapshot.
+ */
+void inventorySnapshot(Inventory *inv, InventorySnapshot *snapshot) {
+    RowVersions *versions = &inv->versions;
+    snapshot->epoch = versions->epoch++;
+    snapshot->generation = versions->generation;
+    snapshot->count = inv->count;
+    snapshot->next = 0;
+    snapshot->open = 1;
+    versions->newest = snapshot->epoch;
+    versions->open++;
+}
+
+/**
+ * @brief Reads the next products of a snapshot, as they were when it was taken.
+ *
+ * With a SharedInventory, call this between sharedLock and sharedUnlock and read a few
+ * thousand products at a time, so changes only wait for one batch.
+ *
+ * @param inv Pointer to the inventory.
+ * @param snapshot Pointer to the snapshot, which remembers where reading stopped.
+ * @param products Receives up to max products, oldest first.
+ * @param max Products wanted.
+ * @param read Receives the number of products read; 0 once the snapshot is exhausted.
+ * @return INV_OK on success, INV_ERR_INVALID if the snapshot was released or lost its view (the
+ *         inventory was restored, or a changed row could not be saved).
+ */
+int inventorySnapshotRead(const Inventory *inv, InventorySnapshot *snapshot, Product *products, size_t max, size_t *read) {
+    const RowVersions *versions = &inv->versions;
+    *read = 0;
+    if (!snapshot->open || snapshot->generation != versions->generation) {
+        return INV_ERR_INVALID;
+    }
+    size_t n = 0;
+    for (; snapshot->next < snapshot->count && n < max; snapshot->next++) {
+        size_t slot = snapshot->next;
+        const RowVersion *seen = NULL;
+        uint32_t v = versions->heads != NULL ? versions->heads[slot] : VERSION_NONE;
+        for (; v != VERSION_NONE && versions->rows[v].until > snapshot->epoch; v = versions->rows[v].next) {
+            seen = &versions->rows[v];
+        }
+        if (seen == NULL) {
+            if (inv->live[slot]) {
+                inventoryGet(inv, slot, &products[n++]);
+            }
+        } else if (seen->live) {
+            Product *product = &products[n++];
+            product->id = seen->id;
+            memcpy(product->name, inv->arena.bytes + seen->name.offset, seen->name.length + 1);
+            product->priceCents = seen->priceCents;
+            product->quantity = seen->quantity;
+        }
+    }
+    *read = n;
+    return INV_OK;
+}
+
+/**
+ * @brief Releases a snapshot. Once none is open the saved rows are dropped and any compaction
+ * held back meanwhile is done.
+ *
+ * @param inv Pointer to the inventory.
+ * @param snapshot Pointer to the snapshot.
+ */
+void inventorySnapshotRelease(Inventory *inv, InventorySnapshot *snapshot) {
+    RowVersions *versions = &inv->versions;
+    if (!snapshot->open) {
+        return;
+    }
+    snapshot->open = 0;
+    if (snapshot->generation != versions->generation || versions->open == 0) {
+        return; // already invalidated, which released it
+    }
+    if (--versions->open > 0) {
+        return;
+    }
+    versions->newest = 0;
+    versionsDrop(inv);
+    if (inv->count >= STORE_MIN_CAPACITY && inv->liveCount * 2 < inv->count) {
+        storeCompact(inv);
+    }
+    storeCompactNames(inv);
+}
+
+/**
+ * @brief Returns the store column an ordered index is keyed on.
+ *
+ * @param inv Pointer to the inventory.
+ * @param column ORDER_PRICE or ORDER_QUANTITY.
+ * @return Price or quantity column.
+ */
+static const int *orderKeys(const Inventory *inv, int column) {
+    return column == ORDER_PRICE ? inv->priceCents : inv->quantities;
+}
+
+/**
+ * @brief Builds an ordered index from scratch if it is not already built.
+ *
+ * The live products are sorted by (key, product ID) and, with random priorities, turned into
+ * a treap in one left-to-right pass, so a rebuild after a bulk load costs one sort.
+ *
+ * @param inv Pointer to the inventory.
+ * @param column ORDER_PRICE or ORDER_QUANTITY.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int orderEnsure(Inventory *inv, int column) {
+    OrderIndex *order = &inv->orders[column];
+    if (order->valid) {
+        return INV_OK;
+    }
+    size_t n = inv->liveCount;
+    uint32_t *stack = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+    if (stack == NULL || orderReserve(order, n) != INV_OK) {
+        free(stack);
+        return INV_ERR_NOMEM;
+    }
+
+    orderReset(order);
+    const int *keys = orderKeys(inv, column);
+    OrderNode *nodes = order->nodes;
+    for (size_t i = 0; i < inv->count; i++) {
+        if (inv->live[i]) {
+            nodes[order->used].key = keys[i];
+            nodes[order->used].id = inv->ids[i];
+            order->used++;
+        }
+    }
+    qsort(nodes, n, sizeof(OrderNode), orderCompare);
+
+    // The stack holds the right spine of the tree built so far; each new node adopts the
+    // lower-priority part of the spine as its left subtree
+    size_t depth = 0;
+    for (size_t i = 0; i < n; i++) {
+        nodes[i].priority = orderPriority(order);
+        nodes[i].right = ORDER_NIL;
+        uint32_t last = ORDER_NIL;
+        while (depth > 0 && nodes[stack[depth - 1]].priority < nodes[i].priority) {
+            last = stack[--depth];
+        }
+        nodes[i].left = last;
+        if (depth > 0) {
+            nodes[stack[depth - 1]].right = (uint32_t)i;
+        }
+        stack[depth++] = (uint32_t)i;
+    }
+    order->root = n ? stack[0] : ORDER_NIL;
+    order->valid = 1;
+    free(stack);
+    return INV_OK;
+}
+
+/**
+ * @brief Appends the slots of the products in a subtree whose keys lie in [low, high], in key order.
+ *
+ * Subtrees entirely outside the range are skipped, so the walk visits O(log n + k) nodes.
+ */
+static void orderCollectRange(const Inventory *inv, const OrderNode *nodes, uint32_t tree, int low, int high, size_t *slots, size_t max, size_t *found) {
+    while (tree != ORDER_NIL && *found < max) {
+        if (nodes[tree].key < low) {
+            tree = nodes[tree].right;
+        } else if (nodes[tree].key > high) {
+            tree = nodes[tree].left;
+        } else {
+            orderCollectRange(inv, nodes, nodes[tree].left, low, high, slots, max, found);
+            if (*found < max) {
+                slots[(*found)++] = inventoryFind(inv, nodes[tree].id);
+            }
+            tree = nodes[tree].right;
+        }
+    }
+}
+
+/**
+ * @brief Appends the slots of the first products of a subtree in ascending or descending key order.
+ */
+static void orderCollectTop(const Inventory *inv, const OrderNode *nodes, uint32_t tree, int descending, size_t *slots, size_t k, size_t *found) {
+    while (tree != ORDER_NIL && *found < k) {
+        orderCollectTop(inv, nodes, descending ? nodes[tree].right : nodes[tree].left, descending, slots, k, found);
+        if (*found < k) {
+            slots[(*found)++] = inventoryFind(inv, nodes[tree].id);
+        }
+        tree = descending ? nodes[tree].left : nodes[tree].right;
+    }
+}
+
+/**
+ * @brief Finds the products whose price or quantity lies in a range, lowest first.
+ *
+ * Runs in O(log n + k) for k results. The index is rebuilt first if a bulk load cleared it.
+ *
+ * @param inv Pointer to the inventory.
+ * @param column ORDER_PRICE (bounds in cents) or ORDER_QUANTITY.
+ * @param low Smallest matching value.
+ * @param high Largest matching value.
+ * @param slots Receives the store slots of the matches.
+ * @param max Capacity of slots; further matches are not reported.
+ * @return Number of slots written, or NO_SLOT if memory allocation failed.
+ */
+size_t inventoryRange(Inventory *inv, int column, int low, int high, size_t *slots, size_t max) {
+    if (orderEnsure(inv, column) != INV_OK) {
+        return NO_SLOT;
+    }
+    size_t found = 0;
+    orderCollectRange(inv, inv->orders[column].nodes, inv->orders[column].root, low, high, slots, max, &found);
+    return found;
+}
+
+/**
+ * @brief Finds the k products with the highest or lowest price or quantity.
+ *
+ * Runs in O(log n + k). Products with equal values are ordered by product ID.
+ *
+ * @param inv Pointer to the inventory.
+ * @param column ORDER_PRICE or ORDER_QUANTITY.
+ * @param highest Non-zero for the highest values first, zero for the lowest first.
+ * @param k Number of products wanted; slots must hold this many.
+ * @param slots Receives the store slots of the products.
+ * @return Number of slots written, or NO_SLOT if memory allocation failed.
+ */
+size_t inventoryTop(Inventory *inv, int column, int highest, size_t k, size_t *slots) {
+    if (orderEnsure(inv, column) != INV_OK) {
+        return NO_SLOT;
+    }
+    size_t found = 0;
+    orderCollectTop(inv, inv->orders[column].nodes, inv->orders[column].root, highest, slots, k, &found);
+    return found;
+}
+
+/**
+ * @brief Builds the name index from scratch if it is unbuilt or mostly stale.
+ *
+ * @param inv Pointer to the inventory.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int nameEnsure(Inventory *inv) {
+    NameIndex *names = &inv->nameIndex;
+    if (names->valid && names->stale * 2 <= names->entries) {
+        return INV_OK;
+    }
+    if (names->postings == NULL) {
+        names->postings = (NamePosting *)calloc(NAME_TRIGRAMS, sizeof(NamePosting));
+        if (names->postings == NULL) {
+            return INV_ERR_NOMEM;
+        }
+        storeAllocations++;
+    }
+    nameReset(names);
+    names->valid = 1;
+    for (size_t i = 0; i < inv->count && names->valid; i++) {
+        if (inv->live[i]) {
+            nameAdd(names, i, inventoryName(inv, i));
+        }
+    }
+    return names->valid ? INV_OK : INV_ERR_NOMEM;
+}
+
+/**
+ * @brief Compares two store slots, for qsort.
+ */
+static int compareSlots(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Finds products by name, ignoring case.
+ *
+ * Queries of three or more characters only check the products in the shortest posting list
+ * among the query's trigrams; shorter queries scan the name column.
+ *
+ * @param inv Pointer to the inventory.
+ * @param query Text to look for.
+ * @param prefixOnly Non-zero to match only names starting with query, zero to match anywhere.
+ * @param slots Receives the store slots of the matches, oldest product first.
+ * @param max Capacity of slots. The search stops at the first match that does not fit.
+ * @return Number of matches found, at most max + 1 (meaning more than max products match),
+ *         or NO_SLOT if memory allocation failed.
+ */
+size_t inventorySearchName(Inventory *inv, const char *query, int prefixOnly, size_t *slots, size_t max) {
+    size_t length = strnlen(query, NAME_SIZE - 1);
+    if (length < 3) {
+        size_t found = 0;
+        for (size_t i = 0; i < inv->count; i++) {
+            if (inv->live[i] && nameMatches(inventoryName(inv, i), query, length, prefixOnly)) {
+                if (found == max) {
+                    return max + 1;
+                }
+                slots[found++] = i;
+            }
+        }
+        return found;
+    }
+
+    if (nameEnsure(inv) != INV_OK) {
+        return NO_SLOT;
+    }
+    const NameIndex *names = &inv->nameIndex;
+    uint32_t trigrams[NAME_MAX_TRIGRAMS];
+    size_t count = nameTrigrams(query, length, trigrams);
+    const NamePosting *shortest = &names->postings[trigrams[0]];
+    for (size_t i = 1; i < count; i++) {
+        if (names->postings[trigrams[i]].count < shortest->count) {
+            shortest = &names->postings[trigrams[i]];
+        }
+    }
+
+    // Lists are in slot order until a rename appends an old slot at the end; then the
+    // candidates are sorted so a product renamed away and back is reported once
+    const uint32_t *candidates = shortest->slots;
+    uint32_t *sorted = NULL;
+    if (names->renamed) {
+        sorted = (uint32_t *)malloc((shortest->count ? shortest->count : 1) * sizeof(uint32_t));
+        if (sorted == NULL) {
+            return NO_SLOT;
+        }
+        memcpy(sorted, shortest->slots, shortest->count * sizeof(uint32_t));
+        qsort(sorted, shortest->count, sizeof(uint32_t), compareSlots);
+        candidates = sorted;
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < shortest->count; i++) {
+        uint32_t slot = candidates[i];
+        if ((i > 0 && candidates[i - 1] == slot) || !inv->live[slot] ||
+            !nameMatches(inventoryName(inv, slot), query, length, prefixOnly)) {
+            continue;
+        }
+        if (found == max) {
+            found++;
+            break;
+        }
+        slots[found++] = slot;
+    }
+    free(sorted);
+    return found;
+}
+
+/**
+ * @brief Scans a decimal price such as "12", "12.5" or "12.50" into cents.
+ *
+ * Digits beyond the second decimal place round the result half up. Scanning stops at the
+ * first character that cannot be part of the price.
+ *
+ * @param p Start of the price text.
+ * @param end End of the available text.
+ * @param cents Receives the price in cents.
+ * @return Pointer just past the price, or NULL if there is no valid non-negative price.
+ */
+const char *scanCents(const char *p, const char *end, int *cents) {
+    long long whole = 0;
+    int fraction = 0;
+
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        whole = whole * 10 + (*p++ - '0');
+        if (whole > INT_MAX / 100) {
+            return NULL;
+        }
+    }
+    if (p < end && *p == '.') {
+        p++;
+        for (int digit = 0; p < end && *p >= '0' && *p <= '9'; digit++, p++) {
+            if (digit < 2) {
+                fraction = fraction * 10 + (*p - '0');
+            } else if (digit == 2 && *p >= '5') {
+                fraction++;
+            }
+            if (digit == 0 && (p + 1 == end || p[1] < '0' || p[1] > '9')) {
+                fraction *= 10; // a single decimal digit means tenths
+            }
+        }
+    }
+
+    long long total = whole * 100 + fraction;
+    if (total > INT_MAX) {
+        return NULL;
+    }
+    *cents = (int)total;
+    return p;
+}
+
+/**
+ * @brief Parses a decimal price string such as "12.50" into cents.
+ *
+ * @param text Price text.
+ * @param cents Receives the price in cents.
+ * @return INV_OK on success, INV_ERR_INVALID if the text is not a valid non-negative price.
+ */
+int parseCents(const char *text, int *cents) {
+    const char *end = text + strlen(text);
+    return scanCents(text, end, cents) == end ? INV_OK : INV_ERR_INVALID;
+}
+
+/**
+ * @brief Scans an optionally signed decimal integer.
+ *
+ * @param p Start of the text.
+ * @param end End of the available text.
+ * @param value Receives the integer.
+ * @return Pointer just past the integer, or NULL if there is no valid int.
+ */
+const char *scanInt(const char *p, const char *end, int *value) {
+    int negative = 0;
+    long long result = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p++ == '-';
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + (*p++ - '0');
+        if (result > (long long)INT_MAX + 1) {
+            return NULL;
+        }
+    }
+    if (negative) {
+        result = -result;
+    }
+    if (result > INT_MAX) {
+        return NULL;
+    }
+    *value = (int)result;
+    return p;
+}
+
+/**
+ * @brief Skips spaces and tabs.
+ *
+ * @param p Start of the text.
+ * @param end End of the available text.
+ * @return Pointer to the first other character, or end.
+ */
+const char *skipBlanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Parses one "id name price quantity" backup line without scanf.
+ *
+ * Names longer than NAME_SIZE - 1 bytes are truncated.
+ *
+ * @param p Start of the line.
+ * @param end End of the line, excluding the newline.
+ * @param product Receives the parsed product.
+ * @return INV_OK on success, INV_ERR_INVALID if the line is malformed.
+ */
+int parseRecordLine(const char *p, const char *end, Product *product) {
+    p = scanInt(skipBlanks(p, end), end, &product->id);
+    if (p == NULL || p == end || (*p != ' ' && *p != '\t')) {
+        return INV_ERR_INVALID;
+    }
+
+    p = skipBlanks(p, end);
+    const char *name = p;
+    while (p < end && *p != ' ' && *p != '\t') {
+        p++;
+    }
+    size_t length = (size_t)(p - name);
+    if (length == 0) {
+        return INV_ERR_INVALID;
+    }
+    if (length > NAME_SIZE - 1) {
+        length = NAME_SIZE - 1;
+    }
+    memcpy(product->name, name, length);
+    product->name[length] = '\0';
+
+    p = scanCents(skipBlanks(p, end), end, &product->priceCents);
+    if (p == NULL || p == end || (*p != ' ' && *p != '\t')) {
+        return INV_ERR_INVALID;
+    }
+    p = scanInt(skipBlanks(p, end), end, &product->quantity);
+    if (p == NULL) {
+        return INV_ERR_INVALID;
+    }
+    p = skipBlanks(p, end);
+    return (p == end || (p + 1 == end && *p == '\r')) ? INV_OK : INV_ERR_INVALID;
+}
+
+/**
+ * @brief Formats an amount in cents as a decimal string such as "12.50".
+ *
+ * @param cents Amount in cents.
+ * @param buf Output buffer of at least CENTS_BUF_SIZE bytes.
+ * @return buf, for use directly as a printf argument.
+ */
+char *formatCents(long long cents, char *buf) {
+    unsigned long long magnitude = cents < 0 ? 0ULL - (unsigned long long)cents : (unsigned long long)cents;
+    snprintf(buf, CENTS_BUF_SIZE, "%s%llu.%02llu", cents < 0 ? "-" : "", magnitude / 100, magnitude % 100);
+    return buf;
+}
+
+/**
+ * @brief Starts a report on a file descriptor.
+ *
+ * @param report Pointer to the report.
+ * @param fd Descriptor to write to; the report does not close it.
+ * @param format REPORT_TABLE, REPORT_CSV, REPORT_TSV or REPORT_RECORDS.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+int reportOpen(Report *report, int fd, int format) {
+    memset(report, 0, sizeof(*report));
+    report->fd = fd;
+    report->format = format;
+    report->buffer = (char *)malloc(REPORT_BUFFER_SIZE);
+    return report->buffer != NULL ? INV_OK : INV_ERR_NOMEM;
+}
+
+/**
+ * @brief Writes out everything rendered so far.
+ *
+ * @param report Pointer to the report.
+ * @return INV_OK on success, INV_ERR_IO if a write failed (now or earlier).
+ */
+int reportFlush(Report *report) {
+    size_t written = 0;
+    while (written < report->used && !report->failed) {
+        ssize_t n = write(report->fd, report->buffer + written, report->used - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            report->failed = 1;
+        } else {
+            written += (size_t)n;
+        }
+    }
+    report->used = 0;
+    return report->failed ? INV_ERR_IO : INV_OK;
+}
+
+/**
+ * @brief Appends one field to the current row: separator, padding and (in CSV) quoting.
+ *
+ * @param report Pointer to the report.
+ * @param text Field text.
+ * @param length Bytes in text, at most NAME_SIZE.
+ */
+static void reportField(Report *report, const char *text, size_t length) {
+    // Room for the longest field: a quoted CSV name doubles every byte, a table column pads
+    if (REPORT_BUFFER_SIZE - report->used < 2 * NAME_SIZE + 2 * 128) {
+        reportFlush(report);
+    }
+    char *out = report->buffer + report->used;
+    int column = report->column++;
+    if (column > 0) {
+        switch (report->format) {
+            case REPORT_TABLE:
+                *out++ = ' ';
+                *out++ = ' ';
+                break;
+            case REPORT_CSV:
+                *out++ = ',';
+                break;
+            case REPORT_TSV:
+                *out++ = '\t';
+                break;
+            default:
+                *out++ = ' ';
+        }
+    }
+
+    int quote = 0;
+    for (size_t i = 0; report->format == REPORT_CSV && i < length && !quote; i++) {
+        quote = text[i] == ',' || text[i] == '"' || text[i] == '\r' || text[i] == '\n';
+    }
+    if (quote) {
+        *out++ = '"';
+        for (size_t i = 0; i < length; i++) {
+            if (text[i] == '"') {
+                *out++ = '"';
+            }
+            *out++ = text[i];
+        }
+        *out++ = '"';
+    } else if (report->format == REPORT_TABLE && column < report->columns) {
+        int width = report->widths[column];
+        size_t pad = (size_t)(width < 0 ? -width : width);
+        pad = pad > length ? pad - length : 0;
+        if (pad > 128) {
+            pad = 128;
+        }
+        if (width > 0) {
+            memset(out, ' ', pad);
+            out += pad;
+        }
+        memcpy(out, text, length);
+        out += length;
+        if (width < 0 && column + 1 < report->columns) { // no trailing blanks at the end of a row
+            memset(out, ' ', pad);
+            out += pad;
+        }
+    } else {
+        memcpy(out, text, length);
+        out += length;
+    }
+    report->used = (size_t)(out - report->buffer);
+}
+
+/**
+ * @brief Sets up the report's columns and writes its header row.
+ *
+ * Table reports get the titles aligned to the widths and a rule beneath; CSV and TSV get a
+ * plain title row; REPORT_RECORDS gets no header.
+ *
+ * @param report Pointer to the report.
+ * @param count Number of columns, at most REPORT_MAX_COLUMNS.
+ * @param titles Column titles.
+ * @param widths Table column widths: characters, negative for left-aligned (text) columns.
+ */
+void reportColumns(Report *report, int count, const char *const *titles, const int *widths) {
+    report->columns = count < REPORT_MAX_COLUMNS ? count : REPORT_MAX_COLUMNS;
+    for (int i = 0; i < report->columns; i++) {
+        int width = widths[i];
+        int title = (int)strlen(titles[i]);
+        if ((width < 0 ? -width : width) < title) { // never narrower than the title
+            width = width < 0 ? -title : title;
+        }
+        report->widths[i] = width;
+    }
+    if (report->format == REPORT_RECORDS) {
+        return;
+    }
+    for (int i = 0; i < report->columns; i++) {
+        reportText(report, titles[i]);
+    }
+    report->column = 0;
+    report->buffer[report->used++] = '\n';
+    if (report->format == REPORT_TABLE) {
+        char rule[129];
+        for (int i = 0; i < report->columns; i++) {
+            size_t length = (size_t)(report->widths[i] < 0 ? -report->widths[i] : report->widths[i]);
+            length = length < sizeof(rule) - 1 ? length : sizeof(rule) - 1;
+            memset(rule, '-', length);
+            rule[length] = '\0';
+            reportField(report, rule, length);
+        }
+        report->column = 0;
+        report->buffer[report->used++] = '\n';
+    }
+}
+
+/**
+ * @brief Appends a text field to the current row.
+ *
+ * @param report Pointer to the report.
+ * @param text Field text, such as a product name.
+ */
+void reportText(Report *report, const char *text) {
+    size_t length = strlen(text);
+    reportField(report, text, length < NAME_SIZE ? length : NAME_SIZE);
+}
+
+/**
+ * @brief Writes the decimal digits of a number backwards from the end of a buffer.
+ *
+ * @param end One past the last byte to fill.
+ * @param value Number to format.
+ * @return First digit written.
+ */
+static char *reportDigits(char *end, unsigned long long value) {
+    do {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    return end;
+}
+
+/**
+ * @brief Appends an integer field to the current row, without printf.
+ *
+ * @param report Pointer to the report.
+ * @param value Field value.
+ */
+void reportInt(Report *report, long long value) {
+    char digits[CENTS_BUF_SIZE];
+    char *end = digits + sizeof(digits);
+    char *start = reportDigits(end, value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value);
+    if (value < 0) {
+        *--start = '-';
+    }
+    reportField(report, start, (size_t)(end - start));
+}
+
+/**
+ * @brief Appends an amount in cents as a "12.50" field to the current row, without printf.
+ *
+ * @param report Pointer to the report.
+ * @param cents Amount in cents.
+ */
+void reportCents(Report *report, long long cents) {
+    char digits[CENTS_BUF_SIZE];
+    char *end = digits + sizeof(digits);
+    unsigned long long magnitude = cents < 0 ? 0ULL - (unsigned long long)cents : (unsigned long long)cents;
+    char *start = end - 3;
+    start[0] = '.';
+    start[1] = (char)('0' + magnitude % 100 / 10);
+    start[2] = (char)('0' + magnitude % 10);
+    start = reportDigits(start, magnitude / 100);
+    if (cents < 0) {
+        *--start = '-';
+    }
+    reportField(report, start, (size_t)(end - start));
+}
+
+/**
+ * @brief Ends the current row.
+ *
+ * @param report Pointer to the report.
+ */
+void reportEndRow(Report *report) {
+    report->buffer[report->used++] = '\n';
+    report->column = 0;
+    report->rows++;
+}
+
+/**
+ * @brief Writes out the rest of a report and releases its buffer.
+ *
+ * @param report Pointer to the report.
+ * @return INV_OK on success, INV_ERR_IO if any write failed.
+ */
+int reportClose(Report *report) {
+    int status = report->buffer != NULL ? reportFlush(report) : INV_ERR_IO;
+    free(report->buffer);
+    report->buffer = NULL;
+    return status;
+}
+
+/**
+ * @brief Portable stock valuation kernel: sums priceCents[i] * quantities[i].
+ *
+ * Accumulates in wrapping 64-bit integers so the result is bit-identical to the SIMD kernels.
+ *
+ * @param priceCents Price column, in cents.
+ * @param quantities Quantity column.
+ * @param n Number of slots.
+ * @return Total value in cents.
+ */
+long long valuationScalar(const int *priceCents, const int *quantities, size_t n) {
+    unsigned long long total = 0;
+    for (size_t i = 0; i < n; i++) {
+        total += (unsigned long long)((long long)priceCents[i] * quantities[i]);
+    }
+    return (long long)total;
+}
+
+#ifdef HAVE_X86_SIMD
+/**
+ * @brief SSE4.1 stock valuation kernel, four slots per iteration.
+ *
+ * _mm_mul_epi32 multiplies the even 32-bit lanes into exact 64-bit products; the odd lanes
+ * are shifted down and multiplied separately.
+ *
+ * @param priceCents Price column, in cents.
+ * @param quantities Quantity column.
+ * @param n Number of slots.
+ * @return Total value in cents.
+ */
+__attribute__((target("sse4.1")))
+long long valuationSse41(const int *priceCents, const int *quantities, size_t n) {
+    __m128i evenSum = _mm_setzero_si128();
+    __m128i oddSum = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i *)(priceCents + i));
+        __m128i q = _mm_loadu_si128((const __m128i *)(quantities + i));
+        evenSum = _mm_add_epi64(evenSum, _mm_mul_epi32(p, q));
+        oddSum = _mm_add_epi64(oddSum, _mm_mul_epi32(_mm_srli_epi64(p, 32), _mm_srli_epi64(q, 32)));
+    }
+
+    unsigned long long lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(evenSum, oddSum));
+    unsigned long long total = lanes[0] + lanes[1];
+    total += (unsigned long long)valuationScalar(priceCents + i, quantities + i, n - i);
+    return (long long)total;
+}
+
+/**
+ * @brief AVX2 stock valuation kernel, eight slots per iteration.
+ *
+ * Same lane scheme as valuationSse41 on 256-bit registers.
+ *
+ * @param priceCents Price column, in cents.
+ * @param quantities Quantity column.
+ * @param n Number of slots.
+ * @return Total value in cents.
+ */
+__attribute__((target("avx2")))
+long long valuationAvx2(const int *priceCents, const int *quantities, size_t n) {
+    __m256i evenSum = _mm256_setzero_si256();
+    __m256i oddSum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(priceCents + i));
+        __m256i q = _mm256_loadu_si256((const __m256i *)(quantities + i));
+        evenSum = _mm256_add_epi64(evenSum, _mm256_mul_epi32(p, q));
+        oddSum = _mm256_add_epi64(oddSum, _mm256_mul_epi32(_mm256_srli_epi64(p, 32), _mm256_srli_epi64(q, 32)));
+    }
+
+    unsigned long long lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(evenSum, oddSum));
+    unsigned long long total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    total += (unsigned long long)valuationScalar(priceCents + i, quantities + i, n - i);
+    return (long long)total;
+}
+#endif
+
+/**
+ * @brief Picks the fastest stock valuation kernel the CPU supports.
+ *
+ * @return Valuation kernel.
+ */
+static ValuationKernel valuationKernel(void) {
+    static ValuationKernel kernel = NULL;
+    if (kernel == NULL) {
+        kernel = valuationScalar;
+#ifdef HAVE_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernel = valuationAvx2;
+        } else if (__builtin_cpu_supports("sse4.1")) {
+            kernel = valuationSse41;
+        }
+#endif
+    }
+    return kernel;
+}
+
+/**
+ * @brief Calculates the value of the stock on hand.
+ *
+ * This function returns the sum of price times quantity over every product. The inventory
+ * keeps this as a running total, so it takes constant time; the sum is exact to the cent.
+ *
+ * @param inv Pointer to the inventory.
+ * @return Stock value, in cents.
+ */
+long long calculateStockValue(const Inventory *inv) {
+    return inv->stockValueCents;
+}
+
+/**
+ * @brief Calculates the total sales amount of every bill made.
+ *
+ * The ledger keeps a running total, so this takes constant time.
+ *
+ * @param ledger Pointer to the sales ledger.
+ * @return Total sales amount, in cents.
+ */
+long long calculateTotalSales(const Ledger *ledger) {
+    return ledger->totalCents;
+}
+
+/**
+ * @brief Does the work of inventorySaveText, which times it.
+ *
+ * Arguments and result are those of inventorySaveText.
+ */
+static int saveText(const Inventory *inv, const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return INV_ERR_IO;
+    }
+    Report report;
+    if (reportOpen(&report, fd, REPORT_RECORDS) != INV_OK) {
+        close(fd);
+        return INV_ERR_IO;
+    }
+
+    for (size_t i = 0; i < inv->count; i++) {
+        if (inv->live[i]) {
+            reportInt(&report, inv->ids[i]);
+            reportText(&report, inventoryName(inv, i));
+            reportCents(&report, inv->priceCents[i]);
+            reportInt(&report, inv->quantities[i]);
+            reportEndRow(&report);
+        }
+    }
+
+    int status = reportClose(&report);
+    return close(fd) == 0 ? status : INV_ERR_IO;
+}
+
+/**
+ * @brief Writes every product to a text backup file, one "id name price quantity" line each.
+ *
+ * Products are written oldest first, so loading the file rebuilds them in the same order.
+ *
+ * @param inv Pointer to the inventory.
+ * @param path Backup file path.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be written.
+ */
+int inventorySaveText(const Inventory *inv, const char *path) {
+    STATS_START(start);
+    int status = saveText(inv, path);
+    STATS_STOP(STAT_BACKUP, start);
+    return status;
+}
+
+/**
+ * @brief Replaces an inventory with a fully loaded staging inventory, keeping its change log,
+ * low-stock threshold, reorder queue and snapshot epochs. Open snapshots of the old contents
+ * lose their view.
+ *
+ * @param inv Pointer to the inventory.
+ * @param staging Pointer to the staging inventory, which the inventory takes over.
+ */
+static void storeAdopt(Inventory *inv, Inventory *staging) {
+    staging->wal = inv->wal;
+    staging->lowStockThreshold = inv->lowStockThreshold;
+    totalsRebuild(staging);
+    staging->reorder = inv->reorder;
+    if (staging->reorder != NULL) {
+        reorderRebuild(staging->reorder, staging);
+    }
+    versionsInvalidate(inv);
+    staging->versions.epoch = inv->versions.epoch;
+    staging->versions.generation = inv->versions.generation;
+    inventoryFree(inv);
+    *inv = *staging;
+}
+
+/**
+ * @brief Does the work of inventoryLoadText, which times it.
+ *
+ * Arguments and result are those of inventoryLoadText.
+ */
+static int loadText(Inventory *inv, const char *path, size_t *loaded) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return INV_ERR_IO;
+    }
+    char *chunk = (char *)malloc(LOAD_CHUNK_SIZE);
+    if (chunk == NULL) {
+        close(fd);
+        return INV_ERR_NOMEM;
+    }
+
+    Inventory staging;
+    inventoryInit(&staging);
+    Product product;
+    size_t records = 0;
+    size_t pending = 0; // bytes of an incomplete line carried over from the previous chunk
+    int status = INV_OK;
+    int eof = 0;
+
+    while (status == INV_OK && !eof) {
+        ssize_t got = read(fd, chunk + pending, LOAD_CHUNK_SIZE - pending);
+        if (got < 0) {
+            status = INV_ERR_IO;
+            break;
+        }
+        eof = got == 0;
+        size_t filled = pending + (size_t)got;
+        if (eof && filled > 0 && chunk[filled - 1] != '\n') {
+            chunk[filled++] = '\n'; // treat a final unterminated line as complete
+        }
+
+        const char *line = chunk;
+        const char *end = chunk + filled;
+        const char *newline;
+        while (status == INV_OK && (newline = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+            if (parseRecordLine(line, newline, &product) == INV_OK) {
+                records++;
+                size_t slot = inventoryFind(&staging, product.id);
+                if (slot != NO_SLOT) {
+                    if (storeSet(&staging, slot, &product) != INV_OK) {
+                        status = INV_ERR_NOMEM;
+                    }
+                } else if (inventoryInsert(&staging, &product) == NO_SLOT) {
+                    status = INV_ERR_NOMEM;
+                }
+            }
+            line = newline + 1;
+        }
+
+        pending = (size_t)(end - line);
+        if (pending == LOAD_CHUNK_SIZE) {
+            status = INV_ERR_INVALID;
+        }
+        memmove(chunk, line, pending);
+    }
+
+    free(chunk);
+    close(fd);
+    if (status != INV_OK) {
+        inventoryFree(&staging);
+        return status;
+    }
+
+    storeAdopt(inv, &staging);
+    if (loaded != NULL) {
+        *loaded = records;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Replaces the inventory with the products in a text backup file.
+ *
+ * The file is streamed through a fixed LOAD_CHUNK_SIZE buffer and each chunk's complete lines
+ * are parsed as a batch into a separate staging inventory. Only when the whole file has loaded
+ * is the staging inventory swapped in, so a failure part-way (memory, I/O, an overlong line)
+ * leaves the current inventory untouched. Beyond the two inventories the load needs one chunk.
+ * Malformed lines are skipped. If the backup lists an ID more than once, the last entry wins.
+ *
+ * @param inv Pointer to the inventory.
+ * @param path Backup file path.
+ * @param loaded Receives the number of records loaded. May be NULL.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be opened or read, INV_ERR_NOMEM if
+ *         memory allocation failed, INV_ERR_INVALID if a line is longer than a chunk.
+ */
+int inventoryLoadText(Inventory *inv, const char *path, size_t *loaded) {
+    STATS_START(start);
+    int status = loadText(inv, path, loaded);
+    STATS_STOP(STAT_RESTORE, start);
+    STATS_PRODUCTS(inv);
+    return status;
+}
+
+// Work for one thread of a parallel text load: a run of whole lines of the mapped file
+typedef struct {
+    const char *begin;
+    const char *end;
+    size_t lines;     // filled in by the counting pass
+    size_t firstSlot; // staging slot of the first line, set before the parsing pass
+    Inventory *staging;
+    const char **names; // per staging slot: where the line's name starts in the mapped file
+} ParseTask;
+
+/**
+ * @brief Counts the lines in a parse task's range, including a final unterminated line.
+ *
+ * @param arg Pointer to the ParseTask.
+ * @return NULL.
+ */
+static void *countLinesWorker(void *arg) {
+    ParseTask *task = (ParseTask *)arg;
+    const char *p = task->begin;
+    size_t lines = 0;
+    const char *newline;
+    while (p < task->end && (newline = memchr(p, '\n', (size_t)(task->end - p))) != NULL) {
+        lines++;
+        p = newline + 1;
+    }
+    if (p < task->end) {
+        lines++;
+    }
+    task->lines = lines;
+    return NULL;
+}
+
+/**
+ * @brief Parses a parse task's lines straight into their slots of the staging store.
+ *
+ * Each line owns one slot, so threads never write the same memory. A malformed line leaves a
+ * tombstone in its slot. Names are not interned here, since the arena is shared; the worker
+ * records where each name starts and its length, for the calling thread to intern.
+ *
+ * @param arg Pointer to the ParseTask.
+ * @return NULL.
+ */
+static void *parseLinesWorker(void *arg) {
+    ParseTask *task = (ParseTask *)arg;
+    Inventory *staging = task->staging;
+    size_t slot = task->firstSlot;
+    const char *p = task->begin;
+    Product product;
+
+    while (p < task->end) {
+        const char *newline = memchr(p, '\n', (size_t)(task->end - p));
+        const char *lineEnd = newline != NULL ? newline : task->end;
+        if (parseRecordLine(p, lineEnd, &product) == INV_OK) {
+            // The line parsed, so the name is the token after the ID
+            const char *name = skipBlanks(p, lineEnd);
+            while (*name != ' ' && *name != '\t') {
+                name++;
+            }
+            task->names[slot] = skipBlanks(name, lineEnd);
+            staging->nameRefs[slot].length = (uint32_t)strlen(product.name);
+            staging->ids[slot] = product.id;
+            staging->priceCents[slot] = product.priceCents;
+            staging->quantities[slot] = product.quantity;
+            staging->live[slot] = 1;
+        } else {
+            task->names[slot] = NULL;
+            staging->ids[slot] = 0;
+            staging->priceCents[slot] = 0;
+            staging->quantities[slot] = 0;
+            staging->nameRefs[slot].length = 0;
+            staging->live[slot] = 0;
+        }
+        slot++;
+        p = lineEnd + 1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs one worker function over every load task, one thread per task.
+ *
+ * The first task runs on the calling thread. If a thread cannot be started its task also runs
+ * on the calling thread, so the pass always completes.
+ *
+ * @param tasks Load tasks (parse or decode tasks), in an array.
+ * @param taskSize Bytes per task.
+ * @param count Number of tasks.
+ * @param worker Worker function.
+ */
+static void runTasks(void *tasks, size_t taskSize, int count, void *(*worker)(void *)) {
+    pthread_t threads[MAX_LOAD_THREADS];
+    int started[MAX_LOAD_THREADS] = {0};
+    char *task = (char *)tasks;
+
+    for (int t = 1; t < count; t++) {
+        started[t] = pthread_create(&threads[t], NULL, worker, task + (size_t)t * taskSize) == 0;
+    }
+    worker(task);
+    for (int t = 1; t < count; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            worker(task + (size_t)t * taskSize);
+        }
+    }
+}
+
+/**
+ * @brief Does the work of inventoryLoadTextParallel, which times it.
+ *
+ * Arguments and result are those of inventoryLoadTextParallel.
+ */
+static int loadTextParallel(Inventory *inv, const char *path, int threads, size_t *loaded) {
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_LOAD_THREADS) {
+        threads = MAX_LOAD_THREADS;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return INV_ERR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return INV_ERR_IO;
+    }
+    size_t fileSize = (size_t)st.st_size;
+    const char *data = "";
+    void *map = NULL;
+    if (fileSize > 0) {
+        map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return INV_ERR_IO;
+        }
+        data = (const char *)map;
+    }
+    close(fd);
+
+    // Cut the file into ranges of whole lines
+    ParseTask tasks[MAX_LOAD_THREADS];
+    const char *cursor = data;
+    const char *fileEnd = data + fileSize;
+    for (int t = 0; t < threads; t++) {
+        const char *end = data + fileSize * (size_t)(t + 1) / (size_t)threads;
+        if (end < cursor) {
+            end = cursor;
+        }
+        if (end < fileEnd) {
+            const char *newline = memchr(end, '\n', (size_t)(fileEnd - end));
+            end = newline != NULL ? newline + 1 : fileEnd;
+        }
+        tasks[t].begin = cursor;
+        tasks[t].end = end;
+        cursor = end;
+    }
+    runTasks(tasks, sizeof(ParseTask), threads, countLinesWorker);
+
+    Inventory staging;
+    inventoryInit(&staging);
+    size_t total = 0;
+    for (int t = 0; t < threads; t++) {
+        tasks[t].firstSlot = total;
+        tasks[t].staging = &staging;
+        total += tasks[t].lines;
+    }
+
+    size_t indexCapacity = INDEX_MIN_CAPACITY;
+    while (indexCapacity < total * 2) {
+        indexCapacity *= 2;
+    }
+    int status = INV_OK;
+    const char **names = (const char **)malloc((total ? total : 1) * sizeof(const char *));
+    if (names == NULL || storeReserve(&staging, total) != INV_OK || indexResize(&staging.index, staging.ids, indexCapacity) != INV_OK) {
+        status = INV_ERR_NOMEM;
+    }
+    for (int t = 0; t < threads; t++) {
+        tasks[t].names = names;
+    }
+
+    size_t records = 0;
+    if (status == INV_OK) {
+        runTasks(tasks, sizeof(ParseTask), threads, parseLinesWorker);
+        staging.count = total;
+
+        for (size_t i = 0; i < total && status == INV_OK; i++) {
+            if (!staging.live[i]) {
+                continue;
+            }
+            records++;
+            if (arenaIntern(&staging.arena, names[i], staging.nameRefs[i].length, &staging.nameRefs[i]) != INV_OK) {
+                status = INV_ERR_NOMEM;
+                break;
+            }
+            size_t slot = indexFind(&staging.index, staging.ids, staging.ids[i]);
+            if (slot != NO_SLOT) {
+                // Repeated ID: the later line's values go to the first slot
+                staging.nameRefs[slot] = staging.nameRefs[i];
+                staging.priceCents[slot] = staging.priceCents[i];
+                staging.quantities[slot] = staging.quantities[i];
+                staging.live[i] = 0;
+                staging.priceCents[i] = 0;
+                staging.quantities[i] = 0;
+            } else {
+                indexInsert(&staging.index, staging.ids, i);
+                staging.liveCount++;
+            }
+        }
+        if (status == INV_OK && staging.liveCount < staging.count) {
+            storeCompact(&staging);
+        }
+    }
+
+    free(names);
+    if (map != NULL) {
+        munmap(map, fileSize);
+    }
+    if (status != INV_OK) {
+        inventoryFree(&staging);
+        return status;
+    }
+
+    storeAdopt(inv, &staging);
+    if (loaded != NULL) {
+        *loaded = records;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Replaces the inventory with a text backup, parsing it on several threads.
+ *
+ * The file is memory-mapped and split at newline boundaries into one range per thread. A first
+ * parallel pass counts each range's lines so every line gets a fixed slot in a presized staging
+ * store; a second parallel pass parses the lines straight into those slots. The ID index is then
+ * built on the calling thread, which also resolves repeated IDs (the last entry wins, as with
+ * inventoryLoadText). As with inventoryLoadText, the staging inventory is only swapped in once
+ * the whole load has succeeded.
+ *
+ * @param inv Pointer to the inventory.
+ * @param path Backup file path.
+ * @param threads Number of parser threads (1 to MAX_LOAD_THREADS).
+ * @param loaded Receives the number of records loaded. May be NULL.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be opened or mapped, INV_ERR_NOMEM if
+ *         memory allocation failed.
+ */
+int inventoryLoadTextParallel(Inventory *inv, const char *path, int threads, size_t *loaded) {
+    STATS_START(start);
+    int status = loadTextParallel(inv, path, threads, loaded);
+    STATS_STOP(STAT_RESTORE, start);
+    STATS_PRODUCTS(inv);
+    return status;
+}
+
+/**
+ * @brief Hashes a block of bytes for the snapshot checksum.
+ *
+ * FNV-1a applied to 64-bit words (with a byte-wise tail), so checksumming keeps up with
+ * reading the mapped file.
+ *
+ * @param hash Running hash value.
+ * @param data Bytes to hash.
+ * @param size Number of bytes.
+ * @return Updated hash value.
+ */
+static uint64_t checksumUpdate(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Writes a block to a snapshot file and folds it into the checksum.
+ *
+ * @param fp Snapshot file.
+ * @param data Bytes to write.
+ * @param size Number of bytes.
+ * @param hash Running checksum, updated in place.
+ * @return INV_OK on success, INV_ERR_IO on a write error.
+ */
+static int snapshotWriteSection(FILE *fp, const void *data, size_t size, uint64_t *hash) {
+    *hash = checksumUpdate(*hash, data, size);
+    return fwrite(data, 1, size, fp) == size ? INV_OK : INV_ERR_IO;
+}
+
+/**
+ * @brief Does the work of inventorySaveSnapshot, which times it.
+ *
+ * Arguments and result are those of inventorySaveSnapshot.
+ */
+static int saveSnapshot(const Inventory *inv, const char *path, uint64_t walLsn) {
+    size_t n = inv->liveCount;
+    int32_t *column = (int32_t *)malloc((n ? n : 1) * sizeof(int32_t));
+    if (column == NULL) {
+        return INV_ERR_NOMEM;
+    }
+
+    char tmpPath[256];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE *fp = fopen(tmpPath, "wb");
+    if (fp == NULL) {
+        free(column);
+        return INV_ERR_IO;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.count = n;
+    header.walLsn = walLsn;
+
+    int failed = fwrite(&header, sizeof(header), 1, fp) != 1;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    // Each column is gathered from the live slots, then written as one block
+    const int *sources[3] = {inv->ids, inv->priceCents, inv->quantities};
+    for (int c = 0; c < 3 && !failed; c++) {
+        size_t out = 0;
+        for (size_t i = 0; i < inv->count; i++) {
+            if (inv->live[i]) {
+                column[out++] = sources[c][i];
+            }
+        }
+        failed = snapshotWriteSection(fp, column, n * sizeof(int32_t), &hash) != INV_OK;
+    }
+
+    size_t poolSize = n > 0 ? inv->arena.used : 0;
+    if (!failed) {
+        size_t out = 0;
+        for (size_t i = 0; i < inv->count; i++) {
+            if (inv->live[i]) {
+                column[out++] = (int32_t)inv->nameRefs[i].offset;
+            }
+        }
+        failed = snapshotWriteSection(fp, column, n * sizeof(int32_t), &hash) != INV_OK ||
+                 snapshotWriteSection(fp, inv->arena.bytes, poolSize, &hash) != INV_OK;
+    }
+    free(column);
+
+    if (!failed) {
+        header.poolSize = poolSize;
+        header.checksum = hash;
+        failed = fseek(fp, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, fp) != 1 ||
+                 fflush(fp) != 0 || fsync(fileno(fp)) != 0;
+    }
+    if (fclose(fp) != 0 || failed || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return INV_ERR_IO;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Saves the inventory as a binary snapshot.
+ *
+ * The snapshot is a SnapshotHeader followed by the id, price and quantity columns, a column of
+ * name offsets and a pool of NUL-terminated names. The pool is the name arena as it stands, so
+ * interned names are written once. The file is written under a temporary name,
+ * synced and then renamed over the old snapshot, so a crash never leaves a torn snapshot.
+ *
+ * @param inv Pointer to the inventory.
+ * @param path Snapshot file path.
+ * @param walLsn Last change-log record the inventory includes, or 0 outside the log.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be written, INV_ERR_NOMEM if memory
+ *         allocation failed.
+ */
+int inventorySaveSnapshot(const Inventory *inv, const char *path, uint64_t walLsn) {
+    STATS_START(start);
+    int status = saveSnapshot(inv, path, walLsn);
+    STATS_STOP(STAT_BACKUP, start);
+    return status;
+}
+
+/**
+ * @brief Does the work of inventoryLoadSnapshot, which times it.
+ *
+ * Arguments and result are those of inventoryLoadSnapshot.
+ */
+static int loadSnapshot(Inventory *inv, const char *path, size_t *loaded, uint64_t *walLsn) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return INV_ERR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return INV_ERR_INVALID;
+    }
+    size_t fileSize = (size_t)st.st_size;
+    void *map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return INV_ERR_IO;
+    }
+
+    // Version 1 headers end before walLsn
+    const unsigned char *base = (const unsigned char *)map;
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(&header, base, fileSize < sizeof(header) ? fileSize : sizeof(header));
+    size_t headerSize = header.version == 1 ? offsetof(SnapshotHeader, walLsn) : sizeof(header);
+    if (header.version == 1) {
+        header.walLsn = 0;
+    }
+    size_t n = (size_t)header.count;
+    int status = INV_OK;
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version < 1 || header.version > SNAPSHOT_VERSION || header.byteOrder != SNAPSHOT_BYTE_ORDER ||
+        header.count > UINT32_MAX || header.poolSize > fileSize || fileSize < headerSize ||
+        fileSize != headerSize + n * 4 * sizeof(int32_t) + header.poolSize) {
+        status = INV_ERR_INVALID;
+    }
+
+    const int32_t *ids = (const int32_t *)(base + headerSize);
+    const int32_t *priceCents = ids + n;
+    const int32_t *quantities = priceCents + n;
+    const int32_t *nameOffsets = quantities + n;
+    const char *pool = (const char *)(nameOffsets + n);
+
+    if (status == INV_OK) {
+        // Hash section by section, exactly as inventorySaveSnapshot wrote them
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        hash = checksumUpdate(hash, ids, n * sizeof(int32_t));
+        hash = checksumUpdate(hash, priceCents, n * sizeof(int32_t));
+        hash = checksumUpdate(hash, quantities, n * sizeof(int32_t));
+        hash = checksumUpdate(hash, nameOffsets, n * sizeof(int32_t));
+        hash = checksumUpdate(hash, pool, header.poolSize);
+        if (hash != header.checksum) {
+            status = INV_ERR_INVALID;
+        }
+    }
+    if (status == INV_OK && n > 0 && (header.poolSize == 0 || pool[header.poolSize - 1] != '\0')) {
+        status = INV_ERR_INVALID;
+    }
+    for (size_t i = 0; status == INV_OK && i < n; i++) {
+        if (nameOffsets[i] < 0 || (uint64_t)nameOffsets[i] >= header.poolSize) {
+            status = INV_ERR_INVALID;
+        }
+    }
+
+    // Load into a staging inventory, swapped in only once every product has checked out
+    Inventory staging;
+    inventoryInit(&staging);
+    if (status == INV_OK) {
+        // Size the index up front so loading never rehashes
+        size_t indexCapacity = INDEX_MIN_CAPACITY;
+        while (indexCapacity < n * 2) {
+            indexCapacity *= 2;
+        }
+        if (storeReserve(&staging, n) != INV_OK ||
+            (indexCapacity > staging.index.capacity && indexResize(&staging.index, staging.ids, indexCapacity) != INV_OK)) {
+            status = INV_ERR_NOMEM;
+        }
+        if (status == INV_OK && header.poolSize > staging.arena.capacity) {
+            char *bytes = (char *)realloc(staging.arena.bytes, header.poolSize);
+            if (bytes == NULL) {
+                status = INV_ERR_NOMEM;
+            } else {
+                storeAllocations++;
+                staging.arena.bytes = bytes;
+                staging.arena.capacity = header.poolSize;
+            }
+        }
+    }
+    if (status == INV_OK) {
+        memcpy(staging.ids, ids, n * sizeof(int));
+        memcpy(staging.priceCents, priceCents, n * sizeof(int));
+        memcpy(staging.quantities, quantities, n * sizeof(int));
+        memset(staging.live, 1, n);
+        memcpy(staging.arena.bytes, pool, header.poolSize);
+        staging.arena.used = header.poolSize;
+        for (size_t i = 0; i < n && status == INV_OK; i++) {
+            size_t length = strnlen(pool + nameOffsets[i], NAME_SIZE);
+            if (length == NAME_SIZE) {
+                status = INV_ERR_INVALID; // names that long cannot come from inventorySaveSnapshot
+            }
+            staging.nameRefs[i].offset = (uint32_t)nameOffsets[i];
+            staging.nameRefs[i].length = (uint32_t)length;
+        }
+        staging.count = n;
+        staging.liveCount = n;
+        for (size_t i = 0; i < n && status == INV_OK; i++) {
+            if (indexFind(&staging.index, staging.ids, staging.ids[i]) != NO_SLOT) {
+                status = INV_ERR_INVALID; // duplicate IDs cannot come from inventorySaveSnapshot
+            } else {
+                indexInsert(&staging.index, staging.ids, i);
+            }
+        }
+    }
+    if (status == INV_OK) {
+        storeAdopt(inv, &staging);
+    } else {
+        inventoryFree(&staging);
+    }
+
+    munmap(map, fileSize);
+    if (loaded != NULL) {
+        *loaded = status == INV_OK ? n : 0;
+    }
+    if (walLsn != NULL) {
+        *walLsn = status == INV_OK ? header.walLsn : 0;
+    }
+    return status;
+}
+
+/**
+ * @brief Replaces the inventory with the products in a binary snapshot.
+ *
+ * The file is memory-mapped and validated (magic, version, byte order, sizes, checksum), and
+ * the id, price, quantity and name-offset columns and the name pool are bulk-copied straight
+ * from the mapping into a separate store; the pool becomes its name arena. That store replaces
+ * the inventory only once every name and ID has checked out, so on failure the inventory is
+ * left unchanged.
+ *
+ * @param inv Pointer to the inventory.
+ * @param path Snapshot file path.
+ * @param loaded Receives the number of records read. May be NULL.
+ * @param walLsn Receives the last change-log record the snapshot includes. May be NULL.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be opened, INV_ERR_NOMEM if memory
+ *         allocation failed, INV_ERR_INVALID if the file is not a valid snapshot.
+ */
+int inventoryLoadSnapshot(Inventory *inv, const char *path, size_t *loaded, uint64_t *walLsn) {
+    STATS_START(start);
+    int status = loadSnapshot(inv, path, loaded, walLsn);
+    STATS_STOP(STAT_RESTORE, start);
+    STATS_PRODUCTS(inv);
+    return status;
+}
+
+/**
+ * @brief Appends an unsigned LEB128 varint: seven bits a byte, low bits first.
+ *
+ * @param out Where to write; needs room for VARINT_MAX_BYTES.
+ * @param value Value to write.
+ * @return Bytes written.
+ */
+static size_t varintPut(unsigned char *out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+/**
+ * @brief Reads a varint written by varintPut.
+ *
+ * @param p Where to read.
+ * @param end End of the readable bytes.
+ * @param value Receives the value.
+ * @return Position after the varint, or NULL if it is truncated or longer than VARINT_MAX_BYTES.
+ */
+static const unsigned char *varintGet(const unsigned char *p, const unsigned char *end, uint64_t *value) {
+    if (p < end && *p < 0x80) { // one byte: the common case for deltas and quantities
+        *value = *p;
+        return p + 1;
+    }
+    uint64_t result = 0;
+    for (int shift = 0; p < end && shift < VARINT_MAX_BYTES * 7; shift += 7) {
+        unsigned char byte = *p++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            *value = result;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Maps a signed value to an unsigned one so small magnitudes of either sign stay small.
+ */
+static uint64_t zigzagEncode(int64_t value) {
+    return value < 0 ? ((uint64_t)~value << 1) | 1 : (uint64_t)value << 1;
+}
+
+/**
+ * @brief Inverts zigzagEncode.
+ */
+static int64_t zigzagDecode(uint64_t value) {
+    return value & 1 ? (int64_t)~(value >> 1) : (int64_t)(value >> 1);
+}
+
+/**
+ * @brief Encodes one block of products: the IDs as deltas, prices as deltas, quantities and
+ * dictionary indexes, each column as zigzag varints, one column after another.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slots Store slots of the block's products.
+ * @param nameIndexes Dictionary index of each product's name.
+ * @param rows Products in the block.
+ * @param out Receives the block; needs room for rows * PACK_ROW_MAX_BYTES.
+ * @return Bytes written.
+ */
+static size_t packEncodeBlock(const Inventory *inv, const size_t *slots, const uint32_t *nameIndexes, size_t rows, unsigned char *out) {
+    size_t n = 0;
+    int64_t previous = 0;
+    for (size_t r = 0; r < rows; r++) {
+        n += varintPut(out + n, zigzagEncode(inv->ids[slots[r]] - previous));
+        previous = inv->ids[slots[r]];
+    }
+    previous = 0;
+    for (size_t r = 0; r < rows; r++) {
+        n += varintPut(out + n, zigzagEncode(inv->priceCents[slots[r]] - previous));
+        previous = inv->priceCents[slots[r]];
+    }
+    for (size_t r = 0; r < rows; r++) {
+        n += varintPut(out + n, zigzagEncode(inv->quantities[slots[r]]));
+    }
+    for (size_t r = 0; r < rows; r++) {
+        n += varintPut(out + n, nameIndexes[r]);
+    }
+    return n;
+}
+
+/**
+ * @brief Does the work of inventorySaveCompressed, which times it.
+ *
+ * Arguments and result are those of inventorySaveCompressed.
+ */
+static int saveCompressed(const Inventory *inv, const char *path) {
+    size_t n = inv->liveCount;
+    size_t blocks = (n + PACK_BLOCK_ROWS - 1) / PACK_BLOCK_ROWS;
+    size_t tableCapacity = INDEX_MIN_CAPACITY;
+    while (tableCapacity < n * 2) {
+        tableCapacity *= 2;
+    }
+    // Name offset -> dictionary index, open addressing; interned names share their offset
+    uint32_t *offsets = (uint32_t *)malloc(tableCapacity * sizeof(uint32_t));
+    uint32_t *entries = (uint32_t *)malloc(tableCapacity * sizeof(uint32_t));
+    uint32_t *nameIndexes = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+    unsigned char *dictionary = (unsigned char *)malloc(inv->arena.used + 2 * n + 1);
+    PackBlock *directory = (PackBlock *)malloc((blocks ? blocks : 1) * sizeof(PackBlock));
+    size_t *slots = (size_t *)malloc(PACK_BLOCK_ROWS * sizeof(size_t));
+    unsigned char *payload = (unsigned char *)malloc(PACK_BLOCK_ROWS * PACK_ROW_MAX_BYTES);
+    int status = offsets == NULL || entries == NULL || nameIndexes == NULL || dictionary == NULL ||
+                 directory == NULL || slots == NULL || payload == NULL ? INV_ERR_NOMEM : INV_OK;
+
+    // Dictionary: distinct names in order of first use, each stored as the bytes it shares with
+    // the previous name and the rest
+    size_t names = 0, dictionarySize = 0, poolSize = 0, row = 0;
+    const char *previous = "";
+    size_t previousLength = 0;
+    if (status == INV_OK) {
+        memset(offsets, 0xff, tableCapacity * sizeof(uint32_t));
+    }
+    for (size_t slot = 0; slot < inv->count && status == INV_OK; slot++) {
+        if (!inv->live[slot]) {
+            continue;
+        }
+        NameRef ref = inv->nameRefs[slot];
+        size_t i = hashId((int)ref.offset) & (tableCapacity - 1);
+        while (offsets[i] != INDEX_EMPTY && offsets[i] != ref.offset) {
+            i = (i + 1) & (tableCapacity - 1);
+        }
+        if (offsets[i] == INDEX_EMPTY) {
+            const char *name = inv->arena.bytes + ref.offset;
+            size_t shared = 0;
+            while (shared < ref.length && shared < previousLength && name[shared] == previous[shared]) {
+                shared++;
+            }
+            dictionarySize += varintPut(dictionary + dictionarySize, shared);
+            dictionarySize += varintPut(dictionary + dictionarySize, ref.length - shared);
+            memcpy(dictionary + dictionarySize, name + shared, ref.length - shared);
+            dictionarySize += ref.length - shared;
+            poolSize += ref.length + 1;
+            previous = name;
+            previousLength = ref.length;
+            offsets[i] = ref.offset;
+            entries[i] = (uint32_t)names++;
+        }
+        nameIndexes[row++] = entries[i];
+    }
+    free(offsets);
+    free(entries);
+
+    char tmpPath[256];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE *fp = status == INV_OK ? fopen(tmpPath, "wb") : NULL;
+    if (status == INV_OK && fp == NULL) {
+        status = INV_ERR_IO;
+    }
+
+    PackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+    header.version = PACK_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.count = n;
+    header.names = names;
+    header.poolSize = poolSize;
+    header.dictionarySize = dictionarySize;
+    header.blocks = blocks;
+    if (status == INV_OK && (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+                        fwrite(dictionary, 1, dictionarySize, fp) != dictionarySize)) {
+        status = INV_ERR_IO;
+    }
+
+    size_t slot = 0;
+    for (size_t b = 0; b < blocks && status == INV_OK; b++) {
+        size_t rows = 0;
+        while (rows < PACK_BLOCK_ROWS && slot < inv->count) {
+            if (inv->live[slot]) {
+                slots[rows++] = slot;
+            }
+            slot++;
+        }
+        size_t size = packEncodeBlock(inv, slots, nameIndexes + b * PACK_BLOCK_ROWS, rows, payload);
+        directory[b].rows = (uint32_t)rows;
+        directory[b].size = (uint32_t)size;
+        directory[b].checksum = checksumUpdate(0xcbf29ce484222325ULL, payload, size);
+        if (fwrite(payload, 1, size, fp) != size) {
+            status = INV_ERR_IO;
+        }
+    }
+
+    if (status == INV_OK) {
+        header.checksum = checksumUpdate(checksumUpdate(0xcbf29ce484222325ULL, dictionary, dictionarySize),
+                                         directory, blocks * sizeof(PackBlock));
+        if (fwrite(directory, sizeof(PackBlock), blocks, fp) != blocks || fseek(fp, 0, SEEK_SET) != 0 ||
+            fwrite(&header, sizeof(header), 1, fp) != 1 || fflush(fp) != 0 || fsync(fileno(fp)) != 0) {
+            status = INV_ERR_IO;
+        }
+    }
+    if (fp != NULL && fclose(fp) != 0) {
+        status = INV_ERR_IO;
+    }
+    if (fp != NULL && (status != INV_OK || rename(tmpPath, path) != 0)) {
+        remove(tmpPath);
+        status = status != INV_OK ? status : INV_ERR_IO;
+    }
+    free(nameIndexes);
+    free(dictionary);
+    free(directory);
+    free(slots);
+    free(payload);
+    return status;
+}
+
+/**
+ * @brief Saves the inventory as a compressed backup.
+ *
+ * The file is a PackHeader, a dictionary of the distinct names (each front-coded against the
+ * one before it), the products in blocks of PACK_BLOCK_ROWS, and a directory with each block's
+ * row count, size and checksum. Within a block each column is stored on its own as zigzag
+ * varints: IDs and prices as differences from the previous product, quantities as they are,
+ * and names as dictionary indexes. Near-sequential IDs and small quantities take one byte
+ * each, and a repeated name costs its index. Like inventorySaveSnapshot, the file is written
+ * under a temporary name, synced and renamed into place.
+ *
+ * @param inv Pointer to the inventory.
+ * @param path Backup file path.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be written, INV_ERR_NOMEM if memory
+ *         allocation failed.
+ */
+int inventorySaveCompressed(const Inventory *inv, const char *path) {
+    STATS_START(start);
+    int status = saveCompressed(inv, path);
+    STATS_STOP(STAT_BACKUP, start);
+    return status;
+}
+
+// Work for one thread of a compressed load: a run of whole blocks
+typedef struct {
+    const unsigned char *file;    // mapped backup
+    const PackBlock *directory;
+    const uint64_t *starts;       // file offset of each block
+    size_t firstBlock;
+    size_t endBlock;
+    const NameRef *dictionary;    // name handle of each dictionary entry
+    size_t names;
+    Inventory *staging;
+    int status;                   // INV_ERR_INVALID if a block is corrupt
+} PackTask;
+
+/**
+ * @brief Decodes a run of blocks straight into their staging slots, checking each block's
+ * checksum and bounds first.
+ *
+ * @param arg Pointer to the PackTask.
+ * @return NULL.
+ */
+static void *packDecodeWorker(void *arg) {
+    PackTask *task = (PackTask *)arg;
+    Inventory *staging = task->staging;
+    for (size_t b = task->firstBlock; b < task->endBlock && task->status == INV_OK; b++) {
+        const PackBlock *block = &task->directory[b];
+        const unsigned char *p = task->file + task->starts[b];
+        const unsigned char *end = p + block->size;
+        if (checksumUpdate(0xcbf29ce484222325ULL, p, block->size) != block->checksum) {
+            task->status = INV_ERR_INVALID;
+            break;
+        }
+        size_t first = b * PACK_BLOCK_ROWS;
+        int64_t value = 0;
+        uint64_t raw;
+        for (size_t r = first; r < first + block->rows && p != NULL; r++) {
+            p = varintGet(p, end, &raw);
+            value += zigzagDecode(raw);
+            staging->ids[r] = (int)value;
+        }
+        value = 0;
+        for (size_t r = first; r < first + block->rows && p != NULL; r++) {
+            p = varintGet(p, end, &raw);
+            value += zigzagDecode(raw);
+            staging->priceCents[r] = (int)value;
+        }
+        for (size_t r = first; r < first + block->rows && p != NULL; r++) {
+            p = varintGet(p, end, &raw);
+            staging->quantities[r] = (int)zigzagDecode(raw);
+        }
+        for (size_t r = first; r < first + block->rows && p != NULL; r++) {
+            p = varintGet(p, end, &raw);
+            if (raw >= task->names) {
+                p = NULL;
+            } else {
+                staging->nameRefs[r] = task->dictionary[raw];
+            }
+        }
+        if (p != end) {
+            task->status = INV_ERR_INVALID;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Does the work of inventoryLoadCompressed, which times it.
+ *
+ * Arguments and result are those of inventoryLoadCompressed.
+ */
+static int loadCompressed(Inventory *inv, const char *path, int threads, size_t *loaded) {
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_LOAD_THREADS) {
+        threads = MAX_LOAD_THREADS;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return INV_ERR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PackHeader)) {
+        close(fd);
+        return INV_ERR_INVALID;
+    }
+    size_t fileSize = (size_t)st.st_size;
+    void *map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return INV_ERR_IO;
+    }
+
+    const unsigned char *base = (const unsigned char *)map;
+    PackHeader header;
+    memcpy(&header, base, sizeof(header));
+    uint64_t bodySize = fileSize - sizeof(header);
+    int status = INV_OK;
+    if (memcmp(header.magic, PACK_MAGIC, sizeof(header.magic)) != 0 || header.version != PACK_VERSION ||
+        header.byteOrder != SNAPSHOT_BYTE_ORDER || header.count > INT32_MAX || header.names > header.count ||
+        header.poolSize > UINT32_MAX || header.dictionarySize > bodySize ||
+        header.blocks != (header.count + PACK_BLOCK_ROWS - 1) / PACK_BLOCK_ROWS ||
+        header.blocks * sizeof(PackBlock) > bodySize - header.dictionarySize) {
+        status = INV_ERR_INVALID;
+    }
+
+    const unsigned char *dictionaryBytes = base + sizeof(header);
+    size_t blocks = (size_t)header.blocks;
+    size_t n = (size_t)header.count;
+    size_t payloadSize = status == INV_OK ? (size_t)(bodySize - header.dictionarySize - blocks * sizeof(PackBlock)) : 0;
+    const unsigned char *directoryBytes = dictionaryBytes + header.dictionarySize + payloadSize;
+    if (status == INV_OK && checksumUpdate(checksumUpdate(0xcbf29ce484222325ULL, dictionaryBytes, header.dictionarySize),
+                                      directoryBytes, blocks * sizeof(PackBlock)) != header.checksum) {
+        status = INV_ERR_INVALID;
+    }
+
+    // The directory follows the payload, so it is copied out to be aligned. Every block but the
+    // last is full, and the blocks exactly fill the payload.
+    PackBlock *directory = NULL;
+    uint64_t *starts = NULL;
+    if (status == INV_OK && ((directory = (PackBlock *)malloc((blocks ? blocks : 1) * sizeof(PackBlock))) == NULL ||
+                        (starts = (uint64_t *)malloc((blocks ? blocks : 1) * sizeof(uint64_t))) == NULL)) {
+        status = INV_ERR_NOMEM;
+    }
+    if (status == INV_OK) {
+        memcpy(directory, directoryBytes, blocks * sizeof(PackBlock));
+    }
+    uint64_t offset = sizeof(header) + header.dictionarySize;
+    for (size_t b = 0; b < blocks && status == INV_OK; b++) {
+        size_t rows = b + 1 < blocks ? PACK_BLOCK_ROWS : n - b * PACK_BLOCK_ROWS;
+        if (directory[b].rows != rows) {
+            status = INV_ERR_INVALID;
+        }
+        starts[b] = offset;
+        offset += directory[b].size;
+    }
+    if (status == INV_OK && offset != sizeof(header) + header.dictionarySize + payloadSize) {
+        status = INV_ERR_INVALID;
+    }
+
+    Inventory staging;
+    inventoryInit(&staging);
+    NameRef *dictionary = NULL;
+    size_t indexCapacity = INDEX_MIN_CAPACITY;
+    while (indexCapacity < n * 2) {
+        indexCapacity *= 2;
+    }
+    if (status == INV_OK && ((dictionary = (NameRef *)malloc((header.names ? header.names : 1) * sizeof(NameRef))) == NULL ||
+                        storeReserve(&staging, n) != INV_OK || indexResize(&staging.index, staging.ids, indexCapacity) != INV_OK ||
+                        (staging.arena.bytes = (char *)malloc(header.poolSize ? header.poolSize : 1)) == NULL)) {
+        status = INV_ERR_NOMEM;
+    }
+
+    // Names go straight into the arena in dictionary order; like a snapshot's pool, they are
+    // added to the intern table on the first rename after the load
+    if (status == INV_OK) {
+        staging.arena.capacity = header.poolSize ? header.poolSize : 1;
+        const unsigned char *p = dictionaryBytes;
+        const unsigned char *end = dictionaryBytes + header.dictionarySize;
+        size_t used = 0, previousLength = 0;
+        char *previous = staging.arena.bytes;
+        for (size_t i = 0; i < header.names && status == INV_OK; i++) {
+            uint64_t shared, rest;
+            p = varintGet(p, end, &shared);
+            p = p != NULL ? varintGet(p, end, &rest) : NULL;
+            if (p == NULL || shared > previousLength || rest > (uint64_t)(end - p) || shared + rest >= NAME_SIZE ||
+                used + shared + rest + 1 > header.poolSize || memchr(p, '\0', (size_t)rest) != NULL) {
+                status = INV_ERR_INVALID;
+                break;
+            }
+            char *name = staging.arena.bytes + used;
+            memmove(name, previous, (size_t)shared);
+            memcpy(name + shared, p, (size_t)rest);
+            name[shared + rest] = '\0';
+            p += rest;
+            dictionary[i].offset = (uint32_t)used;
+            dictionary[i].length = (uint32_t)(shared + rest);
+            previous = name;
+            previousLength = (size_t)(shared + rest);
+            used += previousLength + 1;
+        }
+        if (status == INV_OK && (p != end || used != header.poolSize)) {
+            status = INV_ERR_INVALID;
+        }
+        staging.arena.used = used;
+    }
+
+    if (status == INV_OK) {
+        PackTask tasks[MAX_LOAD_THREADS];
+        if ((size_t)threads > blocks) {
+            threads = blocks ? (int)blocks : 1;
+        }
+        for (int t = 0; t < threads; t++) {
+            tasks[t].file = base;
+            tasks[t].directory = directory;
+            tasks[t].starts = starts;
+            tasks[t].firstBlock = blocks * (size_t)t / (size_t)threads;
+            tasks[t].endBlock = blocks * (size_t)(t + 1) / (size_t)threads;
+            tasks[t].dictionary = dictionary;
+            tasks[t].names = (size_t)header.names;
+            tasks[t].staging = &staging;
+            tasks[t].status = INV_OK;
+        }
+        runTasks(tasks, sizeof(PackTask), threads, packDecodeWorker);
+        for (int t = 0; t < threads; t++) {
+            if (tasks[t].status != INV_OK) {
+                status = tasks[t].status;
+            }
+        }
+    }
+
+    if (status == INV_OK) {
+        if (n > 0) {
+            memset(staging.live, 1, n);
+        }
+        staging.count = n;
+        staging.liveCount = n;
+        for (size_t i = 0; i < n && status == INV_OK; i++) {
+            if (indexFind(&staging.index, staging.ids, staging.ids[i]) != NO_SLOT) {
+                status = INV_ERR_INVALID; // duplicate IDs cannot come from inventorySaveCompressed
+            } else {
+                indexInsert(&staging.index, staging.ids, i);
+            }
+        }
+    }
+
+    free(directory);
+    free(starts);
+    free(dictionary);
+    munmap(map, fileSize);
+    if (status != INV_OK) {
+        inventoryFree(&staging);
+        return status;
+    }
+    storeAdopt(inv, &staging);
+    if (loaded != NULL) {
+        *loaded = n;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Replaces the inventory with the products in a compressed backup.
+ *
+ * The file is memory-mapped and its header, dictionary and block directory are checked
+ * before anything is decoded. The dictionary is expanded straight into the name arena, then
+ * the blocks are decoded on several threads, each into its own run of staging slots and each
+ * checked against its checksum. As with inventoryLoadText, the staging inventory is only
+ * swapped in once the whole load has succeeded.
+ *
+ * @param inv Pointer to the inventory.
+ * @param path Backup file path.
+ * @param threads Number of decoder threads (1 to MAX_LOAD_THREADS).
+ * @param loaded Receives the number of records loaded. May be NULL.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be opened, INV_ERR_NOMEM if memory
+ *         allocation failed, INV_ERR_INVALID if the file is not a valid compressed backup.
+ */
+int inventoryLoadCompressed(Inventory *inv, const char *path, int threads, size_t *loaded) {
+    STATS_START(start);
+    int status = loadCompressed(inv, path, threads, loaded);
+    STATS_STOP(STAT_RESTORE, start);
+    STATS_PRODUCTS(inv);
+    return status;
+}
+
+/**
+ * @brief Opens (or creates) the write-ahead log for appending.
+ *
+ * Call inventoryRecover next to replay it; that also positions the log after its last
+ * valid record.
+ *
+ * @param wal Pointer to the log.
+ * @param walPath Log file path.
+ * @param checkpointPath Path of the snapshot that the log is compacted into.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be opened, INV_ERR_NOMEM if memory
+ *         allocation failed.
+ */
+int walOpen(Wal *wal, const char *walPath, const char *checkpointPath) {
+    memset(wal, 0, sizeof(*wal));
+    wal->buffer = (unsigned char *)malloc(WAL_BUFFER_SIZE);
+    if (wal->buffer == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    wal->fd = open(walPath, O_RDWR | O_CREAT, 0644);
+    if (wal->fd < 0) {
+        free(wal->buffer);
+        wal->buffer = NULL;
+        return INV_ERR_IO;
+    }
+    snprintf(wal->path, sizeof(wal->path), "%s", walPath);
+    snprintf(wal->checkpointPath, sizeof(wal->checkpointPath), "%s", checkpointPath);
+    wal->nextLsn = 1;
+    return INV_OK;
+}
+
+/**
+ * @brief Writes buffered log records to the file without syncing.
+ *
+ * After a failed write the bytes already written stay in the file and the rest stay
+ * buffered, so nothing is written twice.
+ *
+ * @param wal Pointer to the log.
+ * @return INV_OK on success, INV_ERR_IO on a write error.
+ */
+static int walFlush(Wal *wal) {
+    size_t written = 0;
+    int status = INV_OK;
+    while (written < wal->used) {
+        ssize_t n = write(wal->fd, wal->buffer + written, wal->used - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            wal->failed = 1;
+            status = INV_ERR_IO;
+            break;
+        }
+        written += (size_t)n;
+    }
+    memmove(wal->buffer, wal->buffer + written, wal->used - written);
+    wal->used -= written;
+    wal->size += (off_t)written;
+    return status;
+}
+
+/**
+ * @brief Makes every logged change durable: writes the buffer and syncs the file once.
+ *
+ * Changes logged since the last commit share this single sync (group commit).
+ *
+ * @param wal Pointer to the log.
+ * @return INV_OK on success, INV_ERR_IO on an I/O error.
+ */
+int walCommit(Wal *wal) {
+    if (wal->pendingRecords == 0) {
+        return wal->failed ? INV_ERR_IO : INV_OK;
+    }
+    if (walFlush(wal) != INV_OK || fdatasync(wal->fd) != 0) {
+        wal->failed = 1;
+        return INV_ERR_IO;
+    }
+    wal->pendingRecords = 0;
+    return wal->failed ? INV_ERR_IO : INV_OK;
+}
+
+/**
+ * @brief Appends one change record to the log buffer.
+ *
+ * Every WAL_GROUP_COMMIT records the buffer is committed automatically; otherwise records
+ * become durable at the next walCommit. Once a write has failed, records are dropped (the
+ * log is no longer usable and walCommit keeps reporting the error).
+ *
+ * @param wal Pointer to the log.
+ * @param type WAL_ADD, WAL_UPDATE or WAL_DELETE.
+ * @param id Product ID.
+ * @param product New product details, or NULL for a delete.
+ */
+static void walAppend(Wal *wal, int type, int id, const Product *product) {
+    WalRecord record;
+    memset(&record, 0, sizeof(record));
+    record.lsn = wal->nextLsn++;
+    record.id = id;
+    record.type = (uint8_t)type;
+    if (product != NULL) {
+        record.priceCents = product->priceCents;
+        record.quantity = product->quantity;
+        record.nameLength = (uint8_t)strnlen(product->name, NAME_SIZE - 1);
+    }
+
+    size_t size = sizeof(record) + record.nameLength;
+    if (wal->failed || (wal->used + size > WAL_BUFFER_SIZE && walFlush(wal) != INV_OK)) {
+        return;
+    }
+    unsigned char *out = wal->buffer + wal->used;
+    memcpy(out + sizeof(record), product != NULL ? product->name : "", record.nameLength);
+    memcpy(out, &record, sizeof(record));
+    record.checksum = (uint32_t)checksumUpdate(0xcbf29ce484222325ULL, out, size);
+    memcpy(out + offsetof(WalRecord, checksum), &record.checksum, sizeof(record.checksum));
+    wal->used += size;
+
+    if (++wal->pendingRecords >= WAL_GROUP_COMMIT) {
+        walCommit(wal);
+    }
+}
+
+/**
+ * @brief Closes the log after committing anything still buffered.
+ *
+ * @param wal Pointer to the log.
+ */
+void walClose(Wal *wal) {
+    if (wal->fd >= 0) {
+        walCommit(wal);
+        close(wal->fd);
+    }
+    free(wal->buffer);
+    wal->buffer = NULL;
+    wal->fd = -1;
+}
+
+/**
+ * @brief Compacts the log: saves the inventory as the checkpoint snapshot, then empties the log.
+ *
+ * The snapshot records the last log sequence number it includes. If the process dies after the
+ * snapshot is renamed into place but before the log is truncated, recovery skips those records.
+ *
+ * @param inv Pointer to the inventory.
+ * @return INV_OK on success, INV_ERR_IO on an I/O error, INV_ERR_NOMEM if memory allocation failed.
+ */
+int inventoryCheckpoint(Inventory *inv) {
+    Wal *wal = inv->wal;
+    if (wal == NULL) {
+        return INV_OK;
+    }
+    if (walCommit(wal) != INV_OK) {
+        return INV_ERR_IO;
+    }
+
+    int status = inventorySaveSnapshot(inv, wal->checkpointPath, wal->nextLsn - 1);
+    if (status != INV_OK) {
+        return status;
+    }
+    if (ftruncate(wal->fd, 0) != 0 || lseek(wal->fd, 0, SEEK_SET) != 0 || fdatasync(wal->fd) != 0) {
+        wal->failed = 1;
+        return INV_ERR_IO;
+    }
+    wal->size = 0;
+    return INV_OK;
+}
+
+/**
+ * @brief Commits pending log records and compacts the log once it grows past WAL_COMPACT_SIZE.
+ *
+ * @param inv Pointer to the inventory.
+ * @return INV_OK on success, INV_ERR_IO if the changes could not be made durable.
+ */
+int inventoryCommit(Inventory *inv) {
+    if (inv->wal == NULL) {
+        return INV_OK;
+    }
+    if (walCommit(inv->wal) != INV_OK) {
+        return INV_ERR_IO;
+    }
+    if (inv->wal->size >= WAL_COMPACT_SIZE) {
+        return inventoryCheckpoint(inv) == INV_OK ? INV_OK : INV_ERR_IO;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Rebuilds the inventory from the checkpoint snapshot plus the tail of the log.
+ *
+ * Log records already covered by the snapshot are skipped. Replay stops at the first torn or
+ * corrupt record (a crash mid-write), and the log is truncated there so new records follow
+ * the last good one. The inventory is attached to the log afterwards.
+ *
+ * @param inv Pointer to an empty inventory.
+ * @param wal Pointer to a log opened with walOpen.
+ * @param replayed Receives the number of log records applied. May be NULL.
+ * @return INV_OK on success, INV_ERR_IO on an I/O error, INV_ERR_NOMEM if memory allocation failed,
+ *         INV_ERR_INVALID if the checkpoint snapshot is corrupt.
+ */
+int inventoryRecover(Inventory *inv, Wal *wal, size_t *replayed) {
+    uint64_t checkpointLsn = 0;
+    int status = inventoryLoadSnapshot(inv, wal->checkpointPath, NULL, &checkpointLsn);
+    if (status != INV_OK && status != INV_ERR_IO) {
+        return status;
+    }
+
+    struct stat st;
+    if (fstat(wal->fd, &st) != 0) {
+        return INV_ERR_IO;
+    }
+    size_t fileSize = (size_t)st.st_size;
+    unsigned char *data = (unsigned char *)malloc(fileSize ? fileSize : 1);
+    if (data == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    size_t got = 0;
+    while (got < fileSize) {
+        ssize_t n = pread(wal->fd, data + got, fileSize - got, (off_t)got);
+        if (n <= 0) {
+            break;
+        }
+        got += (size_t)n;
+    }
+
+    size_t offset = 0;
+    size_t applied = 0;
+    uint64_t lastLsn = checkpointLsn;
+    Product product;
+    while (offset + sizeof(WalRecord) <= got) {
+        WalRecord record;
+        memcpy(&record, data + offset, sizeof(record));
+        size_t size = sizeof(record) + record.nameLength;
+        if (offset + size > got || record.nameLength >= NAME_SIZE) {
+            break;
+        }
+        uint32_t checksum = record.checksum;
+        memset(data + offset + offsetof(WalRecord, checksum), 0, sizeof(record.checksum));
+        if ((uint32_t)checksumUpdate(0xcbf29ce484222325ULL, data + offset, size) != checksum) {
+            break;
+        }
+
+        if (record.lsn > checkpointLsn) {
+            product.id = record.id;
+            memcpy(product.name, data + offset + sizeof(record), record.nameLength);
+            product.name[record.nameLength] = '\0';
+            product.priceCents = record.priceCents;
+            product.quantity = record.quantity;
+
+            size_t slot = inventoryFind(inv, record.id);
+            if (record.type == WAL_DELETE) {
+                if (slot != NO_SLOT) {
+                    inventoryRemove(inv, slot);
+                }
+            } else if (slot != NO_SLOT ? inventoryUpdate(inv, slot, &product) != INV_OK
+                                       : inventoryInsert(inv, &product) == NO_SLOT) {
+                free(data);
+                return INV_ERR_NOMEM;
+            }
+            applied++;
+        }
+        if (record.lsn > lastLsn) {
+            lastLsn = record.lsn;
+        }
+        offset += size;
+    }
+    free(data);
+
+    if (offset < (size_t)st.st_size && ftruncate(wal->fd, (off_t)offset) != 0) {
+        return INV_ERR_IO;
+    }
+    if (lseek(wal->fd, (off_t)offset, SEEK_SET) < 0) {
+        return INV_ERR_IO;
+    }
+    wal->size = (off_t)offset;
+    wal->nextLsn = lastLsn + 1;
+    inv->wal = wal;
+    if (replayed != NULL) {
+        *replayed = applied;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Initializes an empty, in-memory-only ledger.
+ *
+ * @param ledger Pointer to the ledger.
+ */
+void ledgerInit(Ledger *ledger) {
+    memset(ledger, 0, sizeof(*ledger));
+}
+
+/**
+ * @brief Grows the ledger's arrays so a bill of the given number of lines can always be recorded.
+ *
+ * @param ledger Pointer to the ledger.
+ * @param lines Lines in the next bill.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int ledgerReserve(Ledger *ledger, size_t lines) {
+    if (ledger->billCount == ledger->billCapacity) {
+        size_t capacity = ledger->billCapacity ? ledger->billCapacity * 2 : STORE_MIN_CAPACITY;
+        LedgerBill *bills = (LedgerBill *)realloc(ledger->bills, capacity * sizeof(LedgerBill));
+        if (bills == NULL) {
+            return INV_ERR_NOMEM;
+        }
+        ledger->bills = bills;
+        ledger->billCapacity = capacity;
+    }
+    if (ledger->lineCount + lines > ledger->lineCapacity) {
+        size_t capacity = ledger->lineCapacity ? ledger->lineCapacity : STORE_MIN_CAPACITY;
+        while (capacity < ledger->lineCount + lines) {
+            capacity *= 2;
+        }
+        SaleLine *saleLines = (SaleLine *)realloc(ledger->lines, capacity * sizeof(SaleLine));
+        if (saleLines == NULL) {
+            return INV_ERR_NOMEM;
+        }
+        ledger->lines = saleLines;
+        ledger->lineCapacity = capacity;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Adds a bill whose lines are already at the end of the ledger's lines, and updates the totals.
+ *
+ * @param ledger Pointer to the ledger; ledgerReserve must have made room.
+ * @param time Time of the bill.
+ * @param lineCount Number of lines the bill added.
+ * @return The recorded bill.
+ */
+static const LedgerBill *ledgerRecord(Ledger *ledger, int64_t time, size_t lineCount) {
+    LedgerBill *bill = &ledger->bills[ledger->billCount];
+    bill->number = ledger->billCount + 1;
+    bill->time = time;
+    bill->totalCents = 0;
+    bill->firstLine = ledger->lineCount;
+    bill->lineCount = lineCount;
+    for (size_t i = 0; i < lineCount; i++) {
+        const SaleLine *line = &ledger->lines[ledger->lineCount + i];
+        bill->totalCents += (long long)line->priceCents * line->quantity;
+        ledger->units += line->quantity;
+    }
+    ledger->lineCount += lineCount;
+    ledger->totalCents += bill->totalCents;
+    ledger->billCount++;
+    return bill;
+}
+
+/**
+ * @brief Opens the on-disk sales ledger, loading every bill it holds.
+ *
+ * Each bill is one line: "number time total lines" followed by "id quantity price" for each
+ * line. A torn last line, left by a crash during an append, is cut off.
+ *
+ * @param ledger Pointer to an empty ledger.
+ * @param path Ledger file path.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be opened, INV_ERR_NOMEM if memory
+ *         allocation failed.
+ */
+int ledgerOpen(Ledger *ledger, const char *path) {
+    FILE *fp = fopen(path, "a+");
+    if (fp == NULL) {
+        return INV_ERR_IO;
+    }
+    rewind(fp);
+
+    char *text = NULL;
+    size_t size = 0;
+    ssize_t length;
+    long good = 0;
+    int status = INV_OK;
+    while (status == INV_OK && (length = getline(&text, &size, fp)) > 0) {
+        if (text[length - 1] != '\n') {
+            break; // torn append
+        }
+        const char *end = text + length - 1;
+        char *after;
+        unsigned long long number = strtoull(text, &after, 10);
+        long long time = strtoll(after, &after, 10);
+        const char *p = skipBlanks(after, end);
+        while (p < end && *p != ' ' && *p != '\t') {
+            p++; // the bill total, which is recomputed from the lines
+        }
+        int lineCount;
+        if (number != ledger->billCount + 1 || (p = scanInt(skipBlanks(p, end), end, &lineCount)) == NULL ||
+            lineCount < 1 || lineCount > CART_MAX_LINES) {
+            break;
+        }
+        if (ledgerReserve(ledger, (size_t)lineCount) != INV_OK) {
+            status = INV_ERR_NOMEM;
+            break;
+        }
+        SaleLine *lines = &ledger->lines[ledger->lineCount];
+        int parsed = 0;
+        while (parsed < lineCount &&
+               (p = scanInt(skipBlanks(p, end), end, &lines[parsed].id)) != NULL &&
+               (p = scanInt(skipBlanks(p, end), end, &lines[parsed].quantity)) != NULL &&
+               (p = scanCents(skipBlanks(p, end), end, &lines[parsed].priceCents)) != NULL) {
+            parsed++;
+        }
+        if (parsed < lineCount || skipBlanks(p, end) != end) {
+            break;
+        }
+        ledgerRecord(ledger, time, (size_t)lineCount);
+        good = ftell(fp);
+    }
+    free(text);
+
+    if (status == INV_OK && fseek(fp, 0, SEEK_END) == 0 && ftell(fp) > good) {
+        fflush(fp);
+        status = ftruncate(fileno(fp), good) == 0 ? INV_OK : INV_ERR_IO;
+    }
+    if (status != INV_OK) {
+        fclose(fp);
+        return status;
+    }
+    ledger->fp = fp;
+    return INV_OK;
+}
+
+/**
+ * @brief Flushes appended bills to the ledger file and sales history and syncs them to disk.
+ *
+ * @param ledger Pointer to the ledger.
+ * @return INV_OK on success, INV_ERR_IO on an I/O error.
+ */
+int ledgerSync(Ledger *ledger) {
+    if (ledger->history != NULL && historySync(ledger->history) != INV_OK) {
+        return INV_ERR_IO;
+    }
+    if (ledger->fp == NULL) {
+        return INV_OK;
+    }
+    if (ledger->failed || fflush(ledger->fp) != 0 || fdatasync(fileno(ledger->fp)) != 0) {
+        ledger->failed = 1;
+        return INV_ERR_IO;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Syncs and closes the ledger file and frees the in-memory ledger.
+ *
+ * @param ledger Pointer to the ledger.
+ */
+void ledgerFree(Ledger *ledger) {
+    if (ledger->fp != NULL) {
+        ledgerSync(ledger);
+        fclose(ledger->fp);
+    }
+    free(ledger->bills);
+    free(ledger->lines);
+    ledgerInit(ledger);
+}
+
+/**
+ * @brief Appends a just-recorded bill to the ledger file and sales history, if the ledger has them.
+ *
+ * @param ledger Pointer to the ledger.
+ * @param bill The bill, whose lines are in the ledger.
+ */
+static void ledgerWrite(Ledger *ledger, const LedgerBill *bill) {
+    if (ledger->history != NULL) {
+        historyRecord(ledger->history, bill->number, bill->time, &ledger->lines[bill->firstLine], bill->lineCount);
+    }
+    if (ledger->fp == NULL) {
+        return;
+    }
+    char amount[CENTS_BUF_SIZE];
+    fprintf(ledger->fp, "%llu %lld %s %zu", (unsigned long long)bill->number, (long long)bill->time,
+            formatCents(bill->totalCents, amount), bill->lineCount);
+    for (size_t i = 0; i < bill->lineCount; i++) {
+        const SaleLine *line = &ledger->lines[bill->firstLine + i];
+        fprintf(ledger->fp, " %d %d %s", line->id, line->quantity, formatCents(line->priceCents, amount));
+    }
+    if (fputc('\n', ledger->fp) == EOF) {
+        ledger->failed = 1;
+    }
+}
+
+/**
+ * @brief Adds units of a product to a cart, merging with the product's existing line.
+ *
+ * @param cart Pointer to the cart.
+ * @param id Product ID.
+ * @param quantity Units to add; must be positive.
+ * @return INV_OK on success, INV_ERR_INVALID if the quantity is invalid or the cart is full.
+ */
+int cartAdd(Cart *cart, int id, int quantity) {
+    if (quantity <= 0) {
+        return INV_ERR_INVALID;
+    }
+    for (int i = 0; i < cart->count; i++) {
+        if (cart->lines[i].id == id) {
+            if (cart->lines[i].quantity > INT_MAX - quantity) {
+                return INV_ERR_INVALID;
+            }
+            cart->lines[i].quantity += quantity;
+            return INV_OK;
+        }
+    }
+    if (cart->count == CART_MAX_LINES) {
+        return INV_ERR_INVALID;
+    }
+    cart->lines[cart->count].id = id;
+    cart->lines[cart->count].quantity = quantity;
+    cart->count++;
+    return INV_OK;
+}
+
+/**
+ * @brief Converts a calendar date to a day number.
+ *
+ * @param year Year, such as 2024.
+ * @param month Month, 1 to 12.
+ * @param day Day of the month, 1 to 31.
+ * @return Days since 1970-01-01.
+ */
+int32_t historyDayFromDate(int year, int month, int day) {
+    // Civil-from-days arithmetic on years starting in March, so leap days fall at the end
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return (int32_t)(era * 146097 + dayOfEra - 719468);
+}
+
+/**
+ * @brief Converts a day number back to a calendar date.
+ *
+ * @param day Days since 1970-01-01.
+ * @param year Receives the year.
+ * @param month Receives the month, 1 to 12.
+ * @param dayOfMonth Receives the day of the month.
+ */
+void historyDate(int32_t day, int *year, int *month, int *dayOfMonth) {
+    int z = day + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int dayOfEra = z - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int shifted = (5 * dayOfYear + 2) / 153;
+    *dayOfMonth = dayOfYear - (153 * shifted + 2) / 5 + 1;
+    *month = shifted < 10 ? shifted + 3 : shifted - 9;
+    *year = yearOfEra + era * 400 + (*month <= 2);
+}
+
+/**
+ * @brief Finds the local calendar day of a time.
+ *
+ * @param time Seconds since the epoch.
+ * @return Days since 1970-01-01 by the local calendar.
+ */
+int32_t historyDay(int64_t time) {
+    time_t when = (time_t)time;
+    struct tm local;
+    localtime_r(&when, &local);
+    return historyDayFromDate(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+/**
+ * @brief Initializes an empty sales history with no directory.
+ *
+ * @param history Pointer to the history.
+ */
+void historyInit(SalesHistory *history) {
+    memset(history, 0, sizeof(*history));
+}
+
+/**
+ * @brief Makes sure an array can hold one more element, doubling its capacity when full.
+ *
+ * @param array Pointer to the array pointer.
+ * @param capacity Pointer to the capacity, in elements.
+ * @param count Elements in use.
+ * @param size Bytes per element.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int historyGrow(void **array, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity) {
+        return INV_OK;
+    }
+    size_t grown = *capacity ? *capacity * 2 : 16;
+    void *resized = realloc(*array, grown * size);
+    if (resized == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    *array = resized;
+    *capacity = grown;
+    return INV_OK;
+}
+
+/**
+ * @brief Finds the first day at or after a day number.
+ *
+ * @param history Pointer to the history.
+ * @param day Day number.
+ * @return Position in history->days, dayCount if every day is earlier.
+ */
+static size_t historyLowerDay(const SalesHistory *history, int32_t day) {
+    size_t low = 0, high = history->dayCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (history->days[mid].day < day) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Finds the first entry of a series at or after a day number.
+ *
+ * @param series Pointer to the series.
+ * @param day Day number.
+ * @return Position in the series, count if every entry is earlier.
+ */
+static size_t seriesLowerDay(const SalesSeries *series, int32_t day) {
+    size_t low = 0, high = series->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (series->days[mid] < day) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Finds a product's series, creating an empty one if it has none.
+ *
+ * @param history Pointer to the history.
+ * @param id Product ID.
+ * @return The series, or NULL if memory allocation failed.
+ */
+static SalesSeries *historySeries(SalesHistory *history, int id) {
+    if (history->seriesCount * 2 >= history->indexCapacity) {
+        size_t capacity = history->indexCapacity ? history->indexCapacity * 2 : INDEX_MIN_CAPACITY;
+        uint32_t *index = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+        if (index == NULL) {
+            return NULL;
+        }
+        for (size_t i = 0; i < capacity; i++) {
+            index[i] = INDEX_EMPTY;
+        }
+        for (size_t s = 0; s < history->seriesCount; s++) {
+            size_t i = hashId(history->series[s].id) & (capacity - 1);
+            while (index[i] != INDEX_EMPTY) {
+                i = (i + 1) & (capacity - 1);
+            }
+            index[i] = (uint32_t)s;
+        }
+        free(history->seriesIndex);
+        history->seriesIndex = index;
+        history->indexCapacity = capacity;
+    }
+
+    size_t mask = history->indexCapacity - 1;
+    size_t i = hashId(id) & mask;
+    while (history->seriesIndex[i] != INDEX_EMPTY) {
+        SalesSeries *series = &history->series[history->seriesIndex[i]];
+        if (series->id == id) {
+            return series;
+        }
+        i = (i + 1) & mask;
+    }
+    if (historyGrow((void **)&history->series, &history->seriesCapacity, history->seriesCount, sizeof(SalesSeries)) != INV_OK) {
+        return NULL;
+    }
+    SalesSeries *series = &history->series[history->seriesCount];
+    memset(series, 0, sizeof(*series));
+    series->id = id;
+    history->seriesIndex[i] = (uint32_t)history->seriesCount++;
+    return series;
+}
+
+/**
+ * @brief Looks up a product's series without creating one.
+ *
+ * @param history Pointer to the history.
+ * @param id Product ID.
+ * @return The series, or NULL if the product never sold.
+ */
+static const SalesSeries *historyFindSeries(const SalesHistory *history, int id) {
+    if (history->indexCapacity == 0) {
+        return NULL;
+    }
+    size_t mask = history->indexCapacity - 1;
+    for (size_t i = hashId(id) & mask; history->seriesIndex[i] != INDEX_EMPTY; i = (i + 1) & mask) {
+        const SalesSeries *series = &history->series[history->seriesIndex[i]];
+        if (series->id == id) {
+            return series;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finds a day's sales, inserting an empty day in order if it has none.
+ *
+ * Sales arrive in day order, so this is almost always the last day or a new one after it.
+ *
+ * @param history Pointer to the history.
+ * @param day Day number.
+ * @return The day, or NULL if memory allocation failed.
+ */
+static SalesDay *historySalesDay(SalesHistory *history, int32_t day) {
+    size_t at = history->dayCount > 0 && history->days[history->dayCount - 1].day < day ? history->dayCount
+                                                                                          : historyLowerDay(history, day);
+    if (at < history->dayCount && history->days[at].day == day) {
+        return &history->days[at];
+    }
+    if (historyGrow((void **)&history->days, &history->dayCapacity, history->dayCount, sizeof(SalesDay)) != INV_OK) {
+        return NULL;
+    }
+    memmove(&history->days[at + 1], &history->days[at], (history->dayCount - at) * sizeof(SalesDay));
+    memset(&history->days[at], 0, sizeof(SalesDay));
+    history->days[at].day = day;
+    history->dayCount++;
+    return &history->days[at];
+}
+
+/**
+ * @brief Folds units and revenue of one product on one day into the rollups.
+ *
+ * @param history Pointer to the history.
+ * @param day Day number.
+ * @param id Product ID.
+ * @param units Units sold.
+ * @param revenueCents Revenue, in cents.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int historyAdd(SalesHistory *history, int32_t day, int id, int64_t units, int64_t revenueCents) {
+    SalesSeries *series = historySeries(history, id);
+    SalesDay *salesDay = series != NULL ? historySalesDay(history, day) : NULL;
+    if (salesDay == NULL) {
+        return INV_ERR_NOMEM;
+    }
+
+    size_t at = series->count > 0 && series->days[series->count - 1] < day ? series->count : seriesLowerDay(series, day);
+    if (at == series->count || series->days[at] != day) {
+        if (historyGrow((void **)&salesDay->sales, &salesDay->capacity, salesDay->count, sizeof(DaySales)) != INV_OK) {
+            return INV_ERR_NOMEM;
+        }
+        if (series->count == series->capacity) {
+            size_t capacity = series->capacity ? series->capacity * 2 : 4;
+            int32_t *days = (int32_t *)realloc(series->days, capacity * sizeof(int32_t));
+            series->days = days != NULL ? days : series->days;
+            int64_t *unitSums = days != NULL ? (int64_t *)realloc(series->units, capacity * sizeof(int64_t)) : NULL;
+            series->units = unitSums != NULL ? unitSums : series->units;
+            int64_t *revenueSums = unitSums != NULL ? (int64_t *)realloc(series->revenueCents, capacity * sizeof(int64_t)) : NULL;
+            series->revenueCents = revenueSums != NULL ? revenueSums : series->revenueCents;
+            uint32_t *sales = revenueSums != NULL ? (uint32_t *)realloc(series->sales, capacity * sizeof(uint32_t)) : NULL;
+            if (sales == NULL) {
+                return INV_ERR_NOMEM;
+            }
+            series->sales = sales;
+            series->capacity = capacity;
+        }
+        size_t after = series->count - at;
+        memmove(&series->days[at + 1], &series->days[at], after * sizeof(int32_t));
+        memmove(&series->units[at + 1], &series->units[at], after * sizeof(int64_t));
+        memmove(&series->revenueCents[at + 1], &series->revenueCents[at], after * sizeof(int64_t));
+        memmove(&series->sales[at + 1], &series->sales[at], after * sizeof(uint32_t));
+        series->days[at] = day;
+        series->units[at] = at > 0 ? series->units[at - 1] : 0;
+        series->revenueCents[at] = at > 0 ? series->revenueCents[at - 1] : 0;
+        series->sales[at] = (uint32_t)salesDay->count;
+        series->count++;
+        DaySales *sale = &salesDay->sales[salesDay->count++];
+        memset(sale, 0, sizeof(*sale));
+        sale->id = id;
+    }
+
+    DaySales *sale = &salesDay->sales[series->sales[at]];
+    sale->units += units;
+    sale->revenueCents += revenueCents;
+    salesDay->units += units;
+    salesDay->revenueCents += revenueCents;
+    for (size_t i = at; i < series->count; i++) { // only the last entry, unless a day is backdated
+        series->units[i] += units;
+        series->revenueCents[i] += revenueCents;
+    }
+    return INV_OK;
+}
+
+#define HISTORY_BLOCK_MAGIC 0x31424853U // "SHB1"
+#define HISTORY_ROLLUP_MAGIC "SMSALRUP"
+#define HISTORY_ROLLUP_VERSION 1
+#define HISTORY_LINE_BYTES (sizeof(uint64_t) + 4 * sizeof(int32_t))
+
+// Header of each block appended to a month's partition file. The block's lines follow as
+// columns: count bill numbers (uint64), then count days, IDs, quantities and prices (int32).
+typedef struct {
+    uint32_t magic;    // HISTORY_BLOCK_MAGIC
+    uint32_t count;    // lines in the block
+    uint64_t checksum; // checksumUpdate over the columns
+} HistoryBlock;
+
+// Header of a month's rollup file, followed by count RollupRecords
+typedef struct {
+    char magic[8];     // HISTORY_ROLLUP_MAGIC, without the terminator
+    uint32_t version;  // HISTORY_ROLLUP_VERSION
+    uint32_t reserved;
+    uint64_t rawBytes; // size of the partition file the rollups were made from
+    uint64_t lastBill; // highest bill number in that partition
+    uint64_t count;
+    uint64_t checksum; // checksumUpdate over the records
+} RollupHeader;
+
+// One product's sales on one day, as stored in a rollup file
+typedef struct {
+    int32_t day;
+    int32_t id;
+    int64_t units;
+    int64_t revenueCents;
+} RollupRecord;
+
+/**
+ * @brief Builds the path of one month's partition or rollup file.
+ *
+ * @param history Pointer to the history.
+ * @param year Year of the month.
+ * @param month Month, 1 to 12.
+ * @param suffix "sales" or "rollup".
+ * @param path Buffer of at least sizeof(history->dir) + 32 bytes.
+ */
+static void historyPath(const SalesHistory *history, int year, int month, const char *suffix, char *path) {
+    snprintf(path, sizeof(history->dir) + 32, "%s/%04d-%02d.%s", history->dir, year, month, suffix);
+}
+
+/**
+ * @brief Loads a month's rollup file if it was made from the partition as it is now.
+ *
+ * @param history Pointer to the history.
+ * @param path Rollup file path.
+ * @param rawBytes Current size of the month's partition file.
+ * @return INV_OK if loaded, INV_ERR_IO if missing or out of date, INV_ERR_NOMEM if memory
+ *         allocation failed.
+ */
+static int historyLoadRollup(SalesHistory *history, const char *path, uint64_t rawBytes) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return INV_ERR_IO;
+    }
+    RollupHeader header;
+    RollupRecord *records = NULL;
+    int status = INV_ERR_IO;
+    if (fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, HISTORY_ROLLUP_MAGIC, 8) == 0 &&
+        header.version == HISTORY_ROLLUP_VERSION && header.rawBytes == rawBytes && header.count < ((uint64_t)1 << 32)) {
+        records = (RollupRecord *)malloc(header.count * sizeof(RollupRecord) + 1);
+        status = records == NULL ? INV_ERR_NOMEM : INV_ERR_IO;
+        if (records != NULL && fread(records, sizeof(RollupRecord), header.count, fp) == header.count &&
+            checksumUpdate(0xcbf29ce484222325ULL, records, header.count * sizeof(RollupRecord)) == header.checksum) {
+            status = INV_OK;
+        }
+    }
+    fclose(fp);
+    for (uint64_t i = 0; status == INV_OK && i < header.count; i++) {
+        status = historyAdd(history, records[i].day, records[i].id, records[i].units, records[i].revenueCents);
+    }
+    if (status == INV_OK && header.lastBill > history->lastBill) {
+        history->lastBill = header.lastBill;
+    }
+    free(records);
+    return status;
+}
+
+/**
+ * @brief Writes the rollups of one month to its rollup file, replacing it atomically.
+ *
+ * @param history Pointer to the history.
+ * @param year Year of the month.
+ * @param month Month, 1 to 12.
+ * @param rawBytes Size of the month's partition file.
+ * @param lastBill Highest bill number in the partition.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be written, INV_ERR_NOMEM if memory
+ *         allocation failed.
+ */
+static int historySaveRollup(const SalesHistory *history, int year, int month, uint64_t rawBytes, uint64_t lastBill) {
+    int32_t first = historyDayFromDate(year, month, 1);
+    int32_t next = month == 12 ? historyDayFromDate(year + 1, 1, 1) : historyDayFromDate(year, month + 1, 1);
+    size_t from = historyLowerDay(history, first), to = historyLowerDay(history, next);
+    size_t count = 0;
+    for (size_t d = from; d < to; d++) {
+        count += history->days[d].count;
+    }
+    RollupRecord *records = (RollupRecord *)malloc(count * sizeof(RollupRecord) + 1);
+    if (records == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    size_t n = 0;
+    for (size_t d = from; d < to; d++) {
+        for (size_t i = 0; i < history->days[d].count; i++) {
+            const DaySales *sale = &history->days[d].sales[i];
+            records[n++] = (RollupRecord){history->days[d].day, sale->id, sale->units, sale->revenueCents};
+        }
+    }
+
+    RollupHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HISTORY_ROLLUP_MAGIC, 8);
+    header.version = HISTORY_ROLLUP_VERSION;
+    header.rawBytes = rawBytes;
+    header.lastBill = lastBill;
+    header.count = count;
+    header.checksum = checksumUpdate(0xcbf29ce484222325ULL, records, count * sizeof(RollupRecord));
+
+    char path[sizeof(history->dir) + 32], temp[sizeof(history->dir) + 40];
+    historyPath(history, year, month, "rollup", path);
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *fp = fopen(temp, "wb");
+    int ok = fp != NULL && fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(records, sizeof(RollupRecord), count, fp) == count;
+    ok = fp != NULL && fclose(fp) == 0 && ok && rename(temp, path) == 0;
+    free(records);
+    return ok ? INV_OK : INV_ERR_IO;
+}
+
+/**
+ * @brief Reads a month's partition file into the rollups, cutting off a torn last block.
+ *
+ * @param history Pointer to the history.
+ * @param path Partition file path.
+ * @param rawBytes Receives the size of the valid part of the file.
+ * @param lastBill Receives the highest bill number in the file.
+ * @return INV_OK on success, INV_ERR_IO on an I/O error, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int historyScanPartition(SalesHistory *history, const char *path, uint64_t *rawBytes, uint64_t *lastBill) {
+    int fd = open(path, O_RDWR);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return INV_ERR_IO;
+    }
+    size_t size = (size_t)st.st_size;
+    unsigned char *data = (unsigned char *)malloc(size + 1);
+    if (data == NULL) {
+        close(fd);
+        return INV_ERR_NOMEM;
+    }
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = read(fd, data + got, size - got);
+        if (n <= 0) {
+            break;
+        }
+        got += (size_t)n;
+    }
+
+    size_t offset = 0;
+    int status = INV_OK;
+    *lastBill = 0;
+    while (status == INV_OK && got - offset >= sizeof(HistoryBlock)) {
+        HistoryBlock block;
+        memcpy(&block, data + offset, sizeof(block));
+        size_t bytes = (size_t)block.count * HISTORY_LINE_BYTES;
+        const unsigned char *columns = data + offset + sizeof(block);
+        if (block.magic != HISTORY_BLOCK_MAGIC || block.count == 0 || bytes > got - offset - sizeof(block) ||
+            checksumUpdate(0xcbf29ce484222325ULL, columns, bytes) != block.checksum) {
+            break; // torn append
+        }
+        const unsigned char *days = columns + block.count * sizeof(uint64_t);
+        for (uint32_t i = 0; status == INV_OK && i < block.count; i++) {
+            uint64_t bill;
+            int32_t day, id, quantity, priceCents;
+            memcpy(&bill, columns + i * sizeof(uint64_t), sizeof(bill));
+            memcpy(&day, days + i * sizeof(int32_t), sizeof(day));
+            memcpy(&id, days + (block.count + i) * sizeof(int32_t), sizeof(id));
+            memcpy(&quantity, days + (2 * (size_t)block.count + i) * sizeof(int32_t), sizeof(quantity));
+            memcpy(&priceCents, days + (3 * (size_t)block.count + i) * sizeof(int32_t), sizeof(priceCents));
+            status = historyAdd(history, day, id, quantity, (int64_t)quantity * priceCents);
+            *lastBill = bill > *lastBill ? bill : *lastBill;
+        }
+        offset += sizeof(block) + bytes;
+    }
+    free(data);
+
+    if (status == INV_OK && offset < size && ftruncate(fd, (off_t)offset) != 0) {
+        status = INV_ERR_IO;
+    }
+    close(fd);
+    *rawBytes = offset;
+    if (*lastBill > history->lastBill) {
+        history->lastBill = *lastBill;
+    }
+    return status;
+}
+
+/**
+ * @brief Orders partition file names, which sort by month.
+ */
+static int comparePartitions(const void *a, const void *b) {
+    return strcmp((const char *)a, (const char *)b);
+}
+
+/**
+ * @brief Opens a sales history directory, creating it if needed, and loads its rollups.
+ *
+ * Months before the current one are read from their rollup files when those match the
+ * partition; other months are read line by line, and finished months get a rollup file
+ * written for next time.
+ *
+ * @param history Pointer to an empty history.
+ * @param dir Directory holding the partition files.
+ * @return INV_OK on success, INV_ERR_IO on an I/O error, INV_ERR_NOMEM if memory allocation failed.
+ */
+int historyOpen(SalesHistory *history, const char *dir) {
+    if (strlen(dir) >= sizeof(history->dir) || (mkdir(dir, 0755) != 0 && errno != EEXIST)) {
+        return INV_ERR_IO;
+    }
+    strcpy(history->dir, dir);
+    DIR *listing = opendir(dir);
+    if (listing == NULL) {
+        return INV_ERR_IO;
+    }
+    char (*names)[16] = NULL;
+    size_t count = 0, capacity = 0;
+    int status = INV_OK;
+    struct dirent *entry;
+    while (status == INV_OK && (entry = readdir(listing)) != NULL) {
+        int year, month, used = 0;
+        if (strlen(entry->d_name) == 13 && sscanf(entry->d_name, "%4d-%2d.sales%n", &year, &month, &used) == 2 && used == 13) {
+            status = historyGrow((void **)&names, &capacity, count, sizeof(*names));
+            if (status == INV_OK) {
+                memcpy(names[count++], entry->d_name, 14);
+            }
+        }
+    }
+    closedir(listing);
+    if (count > 0) {
+        qsort(names, count, sizeof(*names), comparePartitions);
+    }
+
+    int thisYear, thisMonth, today;
+    historyDate(historyDay((int64_t)time(NULL)), &thisYear, &thisMonth, &today);
+    for (size_t i = 0; status == INV_OK && i < count; i++) {
+        int year, month;
+        sscanf(names[i], "%4d-%2d", &year, &month);
+        char path[sizeof(history->dir) + 32], rollup[sizeof(history->dir) + 32];
+        historyPath(history, year, month, "sales", path);
+        historyPath(history, year, month, "rollup", rollup);
+        struct stat st;
+        if (stat(path, &st) != 0) {
+            status = INV_ERR_IO;
+            break;
+        }
+        status = historyLoadRollup(history, rollup, (uint64_t)st.st_size);
+        if (status == INV_ERR_IO) {
+            uint64_t rawBytes, lastBill;
+            status = historyScanPartition(history, path, &rawBytes, &lastBill);
+            if (status == INV_OK && (year < thisYear || (year == thisYear && month < thisMonth))) {
+                historySaveRollup(history, year, month, rawBytes, lastBill); // only speeds up the next open
+            }
+        }
+    }
+    free(names);
+    return status;
+}
+
+/**
+ * @brief Records the lines of one bill: folds them into the rollups and queues them for
+ * historySync to append to their month's partition.
+ *
+ * @param history Pointer to the history.
+ * @param bill Bill number.
+ * @param time Time of the bill, seconds since the epoch.
+ * @param lines The bill's lines.
+ * @param count Number of lines.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed (the history is marked
+ *         failed).
+ */
+int historyRecord(SalesHistory *history, uint64_t bill, int64_t time, const SaleLine *lines, size_t count) {
+    int32_t day = historyDay(time);
+    for (size_t i = 0; i < count; i++) {
+        if (historyAdd(history, day, lines[i].id, lines[i].quantity, (int64_t)lines[i].quantity * lines[i].priceCents) != INV_OK ||
+            historyGrow((void **)&history->pending, &history->pendingCapacity, history->pendingCount, sizeof(HistoryLine)) != INV_OK) {
+            history->failed = 1;
+            return INV_ERR_NOMEM;
+        }
+        history->pending[history->pendingCount++] = (HistoryLine){bill, day, lines[i].id, lines[i].quantity, lines[i].priceCents};
+    }
+    if (bill > history->lastBill) {
+        history->lastBill = bill;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Appends one block of queued lines, all from the same month, to that month's partition.
+ *
+ * @param history Pointer to the history.
+ * @param lines First line of the block.
+ * @param count Lines in the block.
+ * @return INV_OK on success, INV_ERR_IO on an I/O error, INV_ERR_NOMEM if memory allocation failed.
+ */
+static int historyWriteBlock(SalesHistory *history, const HistoryLine *lines, size_t count) {
+    size_t bytes = count * HISTORY_LINE_BYTES;
+    unsigned char *block = (unsigned char *)malloc(sizeof(HistoryBlock) + bytes);
+    if (block == NULL) {
+        return INV_ERR_NOMEM;
+    }
+    unsigned char *columns = block + sizeof(HistoryBlock);
+    unsigned char *days = columns + count * sizeof(uint64_t);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(columns + i * sizeof(uint64_t), &lines[i].bill, sizeof(uint64_t));
+        memcpy(days + i * sizeof(int32_t), &lines[i].day, sizeof(int32_t));
+        memcpy(days + (count + i) * sizeof(int32_t), &lines[i].id, sizeof(int32_t));
+        memcpy(days + (2 * count + i) * sizeof(int32_t), &lines[i].quantity, sizeof(int32_t));
+        memcpy(days + (3 * count + i) * sizeof(int32_t), &lines[i].priceCents, sizeof(int32_t));
+    }
+    HistoryBlock header = {HISTORY_BLOCK_MAGIC, (uint32_t)count, checksumUpdate(0xcbf29ce484222325ULL, columns, bytes)};
+    memcpy(block, &header, sizeof(header));
+
+    int year, month, day;
+    char path[sizeof(history->dir) + 32];
+    historyDate(lines[0].day, &year, &month, &day);
+    historyPath(history, year, month, "sales", path);
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    int status = fd >= 0 ? INV_OK : INV_ERR_IO;
+    size_t written = 0;
+    while (status == INV_OK && written < sizeof(HistoryBlock) + bytes) {
+        ssize_t n = write(fd, block + written, sizeof(HistoryBlock) + bytes - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            status = INV_ERR_IO;
+            break;
+        }
+        written += (size_t)n;
+    }
+    if (status == INV_OK && fdatasync(fd) != 0) {
+        status = INV_ERR_IO;
+    }
+    if (fd >= 0 && close(fd) != 0) {
+        status = INV_ERR_IO;
+    }
+    free(block);
+    return status;
+}
+
+/**
+ * @brief Appends every queued line to its month's partition file and syncs it to disk.
+ *
+ * @param history Pointer to the history.
+ * @return INV_OK on success (or if the history has no directory), INV_ERR_IO on an error.
+ */
+int historySync(SalesHistory *history) {
+    if (history->failed) {
+        return INV_ERR_IO;
+    }
+    if (history->dir[0] == '\0') {
+        history->pendingCount = 0;
+        return INV_OK;
+    }
+    size_t start = 0;
+    while (start < history->pendingCount) {
+        int year, month, day, nextYear, nextMonth;
+        historyDate(history->pending[start].day, &year, &month, &day);
+        size_t end = start + 1;
+        while (end < history->pendingCount && end - start < UINT32_MAX) {
+            historyDate(history->pending[end].day, &nextYear, &nextMonth, &day);
+            if (nextYear != year || nextMonth != month) {
+                break;
+            }
+            end++;
+        }
+        if (historyWriteBlock(history, &history->pending[start], end - start) != INV_OK) {
+            history->failed = 1;
+            return INV_ERR_IO;
+        }
+        start = end;
+    }
+    history->pendingCount = 0;
+    return INV_OK;
+}
+
+/**
+ * @brief Syncs the history and frees it.
+ *
+ * @param history Pointer to the history.
+ */
+void historyFree(SalesHistory *history) {
+    historySync(history);
+    for (size_t d = 0; d < history->dayCount; d++) {
+        free(history->days[d].sales);
+    }
+    for (size_t s = 0; s < history->seriesCount; s++) {
+        free(history->series[s].days);
+        free(history->series[s].units);
+        free(history->series[s].revenueCents);
+        free(history->series[s].sales);
+    }
+    free(history->days);
+    free(history->series);
+    free(history->seriesIndex);
+    free(history->pending);
+    historyInit(history);
+}
+
+/**
+ * @brief Makes a ledger record every new bill in a sales history as well, first recording the
+ * ledger's bills the history does not have yet (left behind by a crash between the two writes,
+ * or made before the history existed).
+ *
+ * @param ledger Pointer to the ledger.
+ * @param history Pointer to an opened history.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed.
+ */
+int ledgerAttachHistory(Ledger *ledger, SalesHistory *history) {
+    for (size_t b = 0; b < ledger->billCount; b++) {
+        const LedgerBill *bill = &ledger->bills[b];
+        if (bill->number > history->lastBill &&
+            historyRecord(history, bill->number, bill->time, &ledger->lines[bill->firstLine], bill->lineCount) != INV_OK) {
+            return INV_ERR_NOMEM;
+        }
+    }
+    ledger->history = history;
+    return INV_OK;
+}
+
+/**
+ * @brief Sums one product's sales over a range of days with two binary searches.
+ *
+ * @param history Pointer to the history.
+ * @param id Product ID.
+ * @param from First day of the range.
+ * @param to Last day of the range (inclusive).
+ * @param sales Receives the product's units and revenue; zero if it did not sell.
+ */
+void historyProductSales(const SalesHistory *history, int id, int32_t from, int32_t to, ProductSales *sales) {
+    const SalesSeries *series = historyFindSeries(history, id);
+    memset(sales, 0, sizeof(*sales));
+    sales->id = id;
+    if (series == NULL || from > to) {
+        return;
+    }
+    size_t first = seriesLowerDay(series, from);
+    size_t end = seriesLowerDay(series, to + 1);
+    if (end > first) {
+        sales->units = series->units[end - 1] - (first > 0 ? series->units[first - 1] : 0);
+        sales->revenueCents = series->revenueCents[end - 1] - (first > 0 ? series->revenueCents[first - 1] : 0);
+    }
+}
+
+/**
+ * @brief Sums every sale over a range of days from the per-day totals.
+ *
+ * @param history Pointer to the history.
+ * @param from First day of the range.
+ * @param to Last day of the range (inclusive).
+ * @param sales Receives the units and revenue, with id 0.
+ */
+void historyTotals(const SalesHistory *history, int32_t from, int32_t to, ProductSales *sales) {
+    memset(sales, 0, sizeof(*sales));
+    for (size_t d = historyLowerDay(history, from); d < history->dayCount && history->days[d].day <= to; d++) {
+        sales->units += history->days[d].units;
+        sales->revenueCents += history->days[d].revenueCents;
+    }
+}
+
+/**
+ * @brief Tells whether one product outsold another, by units or by revenue, ties to the lower ID.
+ */
+static int sellsMore(const ProductSales *a, const ProductSales *b, int byRevenue) {
+    int64_t x = byRevenue ? a->revenueCents : a->units;
+    int64_t y = byRevenue ? b->revenueCents : b->units;
+    return x != y ? x > y : a->id < b->id;
+}
+
+/**
+ * @brief Finds the best-selling products over a range of days.
+ *
+ * Adds up the day rollups in the range in a scratch hash table, then keeps the top k with a
+ * min-heap, so the cost depends on the products sold in the range, not on the bill lines.
+ *
+ * @param history Pointer to the history.
+ * @param from First day of the range.
+ * @param to Last day of the range (inclusive).
+ * @param byRevenue Non-zero to rank by revenue, zero to rank by units.
+ * @param k Products wanted.
+ * @param top Receives up to k products, best first.
+ * @return Products written to top.
+ */
+size_t historyTopSellers(const SalesHistory *history, int32_t from, int32_t to, int byRevenue, size_t k, ProductSales *top) {
+    size_t first = historyLowerDay(history, from), end = first, entries = 0;
+    for (; end < history->dayCount && history->days[end].day <= to; end++) {
+        entries += history->days[end].count;
+    }
+    if (entries == 0 || k == 0) {
+        return 0;
+    }
+    size_t capacity = INDEX_MIN_CAPACITY;
+    while (capacity < entries * 2) {
+        capacity *= 2;
+    }
+    ProductSales *table = (ProductSales *)malloc(capacity * sizeof(ProductSales));
+    unsigned char *used = (unsigned char *)calloc(capacity, 1);
+    if (table == NULL || used == NULL) {
+        free(table);
+        free(used);
+        return 0;
+    }
+    for (size_t d = first; d < end; d++) {
+        for (size_t i = 0; i < history->days[d].count; i++) {
+            const DaySales *sale = &history->days[d].sales[i];
+            size_t slot = hashId(sale->id) & (capacity - 1);
+            while (used[slot] && table[slot].id != sale->id) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            if (!used[slot]) {
+                used[slot] = 1;
+                table[slot] = (ProductSales){sale->id, 0, 0};
+            }
+            table[slot].units += sale->units;
+            table[slot].revenueCents += sale->revenueCents;
+        }
+    }
+
+    // Min-heap of the best k so far: top[0] is the weakest of them
+    size_t count = 0;
+    for (size_t slot = 0; slot < capacity; slot++) {
+        if (!used[slot]) {
+            continue;
+        }
+        size_t i;
+        if (count < k) {
+            i = count++;
+            while (i > 0 && sellsMore(&top[(i - 1) / 2], &table[slot], byRevenue)) {
+                top[i] = top[(i - 1) / 2];
+                i = (i - 1) / 2;
+            }
+        } else if (sellsMore(&table[slot], &top[0], byRevenue)) {
+            i = 0;
+            for (;;) {
+                size_t child = 2 * i + 1;
+                if (child >= count) {
+                    break;
+                }
+                if (child + 1 < count && sellsMore(&top[child], &top[child + 1], byRevenue)) {
+                    child++;
+                }
+                if (!sellsMore(&table[slot], &top[child], byRevenue)) {
+                    break;
+                }
+                top[i] = top[child];
+                i = child;
+            }
+        } else {
+            continue;
+        }
+        top[i] = table[slot];
+    }
+    free(table);
+    free(used);
+
+    // Pop the heap from the back so the best ends up first
+    for (size_t n = count; n > 1; n--) {
+        ProductSales weakest = top[0];
+        ProductSales last = top[n - 1];
+        size_t i = 0;
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= n - 1) {
+                break;
+            }
+            if (child + 1 < n - 1 && sellsMore(&top[child], &top[child + 1], byRevenue)) {
+                child++;
+            }
+            if (!sellsMore(&last, &top[child], byRevenue)) {
+                break;
+            }
+            top[i] = top[child];
+            i = child;
+        }
+        top[i] = last;
+        top[n - 1] = weakest;
+    }
+    return count;
+}
+
+/**
+ * @brief Does the work of inventoryCheckout, which times it.
+ *
+ * Arguments and result are those of inventoryCheckout.
+ */
+static int checkout(Inventory *inv, Ledger *ledger, const Cart *cart, const LedgerBill **bill, int *failedLine) {
+    size_t slots[CART_MAX_LINES];
+    for (int i = 0; i < cart->count; i++) {
+        slots[i] = inventoryFind(inv, cart->lines[i].id);
+        int status = slots[i] == NO_SLOT ? INV_ERR_NOT_FOUND : inv->quantities[slots[i]] < cart->lines[i].quantity ? INV_ERR_STOCK : INV_OK;
+        if (status != INV_OK) {
+            if (failedLine != NULL) {
+                *failedLine = i;
+            }
+            return status;
+        }
+    }
+    if (ledgerReserve(ledger, (size_t)cart->count) != INV_OK) {
+        return INV_ERR_NOMEM;
+    }
+
+    int64_t now = (int64_t)time(NULL);
+    SaleLine *lines = &ledger->lines[ledger->lineCount];
+    for (int i = 0; i < cart->count; i++) {
+        lines[i].id = cart->lines[i].id;
+        lines[i].quantity = cart->lines[i].quantity;
+        lines[i].priceCents = inv->priceCents[slots[i]];
+        if (inv->reorder != NULL) {
+            reorderSold(inv->reorder, cart->lines[i].id, cart->lines[i].quantity, now);
+        }
+        inventorySetQuantity(inv, slots[i], inv->quantities[slots[i]] - cart->lines[i].quantity);
+    }
+    const LedgerBill *recorded = ledgerRecord(ledger, now, (size_t)cart->count);
+    ledgerWrite(ledger, recorded);
+    if (bill != NULL) {
+        *bill = recorded;
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Sells a cart: prices it, takes the units out of stock and records the bill.
+ *
+ * Every line is checked (known product, enough stock) before anything changes, and the ledger
+ * is grown up front, so either the whole cart is sold or nothing is.
+ *
+ * @param inv Pointer to the inventory.
+ * @param ledger Pointer to the sales ledger.
+ * @param cart Cart to sell; must not be empty.
+ * @param bill Receives the recorded bill. May be NULL.
+ * @param failedLine Receives the cart line that stopped the sale. May be NULL.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed, INV_ERR_NOT_FOUND if a
+ *         product is unknown, INV_ERR_STOCK if a product has too little stock.
+ */
+int inventoryCheckout(Inventory *inv, Ledger *ledger, const Cart *cart, const LedgerBill **bill, int *failedLine) {
+    STATS_START(start);
+    int status = checkout(inv, ledger, cart, bill, failedLine);
+    STATS_STOP(STAT_BILL, start);
+    return status;
+}
+
+/**
+ * @brief Sets up an inventory and ledger to be shared by checkout threads.
+ *
+ * While shared, the inventory and ledger must only be used through sharedCheckout, or
+ * between sharedLock and sharedUnlock.
+ *
+ * @param shared Pointer to the shared inventory to set up.
+ * @param inv Pointer to the inventory.
+ * @param ledger Pointer to the sales ledger.
+ * @return INV_OK on success, INV_ERR_NOMEM if the locks could not be created.
+ */
+int sharedInit(SharedInventory *shared, Inventory *inv, Ledger *ledger) {
+    shared->inv = inv;
+    shared->ledger = ledger;
+    if (pthread_rwlock_init(&shared->storeLock, NULL) != 0) {
+        return INV_ERR_NOMEM;
+    }
+    if (pthread_mutex_init(&shared->bookLock, NULL) != 0) {
+        pthread_rwlock_destroy(&shared->storeLock);
+        return INV_ERR_NOMEM;
+    }
+    for (int i = 0; i < STOCK_STRIPES; i++) {
+        if (pthread_mutex_init(&shared->stripes[i].lock, NULL) != 0) {
+            while (i-- > 0) {
+                pthread_mutex_destroy(&shared->stripes[i].lock);
+            }
+            pthread_mutex_destroy(&shared->bookLock);
+            pthread_rwlock_destroy(&shared->storeLock);
+            return INV_ERR_NOMEM;
+        }
+    }
+    return INV_OK;
+}
+
+/**
+ * @brief Releases the locks of a shared inventory; the inventory and ledger are left as they are.
+ *
+ * @param shared Pointer to the shared inventory, with no thread still using it.
+ */
+void sharedDestroy(SharedInventory *shared) {
+    for (int i = 0; i < STOCK_STRIPES; i++) {
+        pthread_mutex_destroy(&shared->stripes[i].lock);
+    }
+    pthread_mutex_destroy(&shared->bookLock);
+    pthread_rwlock_destroy(&shared->storeLock);
+}
+
+/**
+ * @brief Waits for running checkouts to finish and keeps new ones out, so the calling thread
+ * may use any inventory or ledger function (add, update, delete, queries, commits).
+ *
+ * @param shared Pointer to the shared inventory.
+ */
+void sharedLock(SharedInventory *shared) {
+    pthread_rwlock_wrlock(&shared->storeLock);
+}
+
+/**
+ * @brief Lets checkouts run again after sharedLock.
+ *
+ * @param shared Pointer to the shared inventory.
+ */
+void sharedUnlock(SharedInventory *shared) {
+    pthread_rwlock_unlock(&shared->storeLock);
+}
+
+/**
+ * @brief Does the work of sharedCheckout, which times it.
+ *
+ * Arguments and result are those of sharedCheckout.
+ */
+static int stripedCheckout(SharedInventory *shared, const Cart *cart, LedgerBill *bill, int *failedLine) {
+    Inventory *inv = shared->inv;
+    Ledger *ledger = shared->ledger;
+    size_t slots[CART_MAX_LINES];
+    int stripes[CART_MAX_LINES];
+    int oldQuantities[CART_MAX_LINES];
+    int stripeCount = 0;
+    int status = INV_OK;
+
+    pthread_rwlock_rdlock(&shared->storeLock);
+    for (int i = 0; i < cart->count && status == INV_OK; i++) {
+        slots[i] = inventoryFind(inv, cart->lines[i].id);
+        if (slots[i] == NO_SLOT) {
+            status = INV_ERR_NOT_FOUND;
+            if (failedLine != NULL) {
+                *failedLine = i;
+            }
+            break;
+        }
+        // Insert the stripe into the sorted, duplicate-free lock list
+        int stripe = (int)(slots[i] % STOCK_STRIPES);
+        int at = stripeCount;
+        while (at > 0 && stripes[at - 1] > stripe) {
+            at--;
+        }
+        if (at == 0 || stripes[at - 1] != stripe) {
+            memmove(&stripes[at + 1], &stripes[at], (size_t)(stripeCount - at) * sizeof(int));
+            stripes[at] = stripe;
+            stripeCount++;
+        }
+    }
+    if (status != INV_OK) {
+        pthread_rwlock_unlock(&shared->storeLock);
+        return status;
+    }
+
+    for (int i = 0; i < stripeCount; i++) {
+        pthread_mutex_lock(&shared->stripes[stripes[i]].lock);
+    }
+    for (int i = 0; i < cart->count; i++) {
+        if (inv->quantities[slots[i]] < cart->lines[i].quantity) {
+            status = INV_ERR_STOCK;
+            if (failedLine != NULL) {
+                *failedLine = i;
+            }
+            break;
+        }
+    }
+    if (status == INV_OK) {
+        for (int i = 0; i < cart->count; i++) {
+            oldQuantities[i] = inv->quantities[slots[i]];
+            inv->quantities[slots[i]] = oldQuantities[i] - cart->lines[i].quantity;
+        }
+
+        // Still holding the stripes, so bills and logged quantities of a product stay in order
+        pthread_mutex_lock(&shared->bookLock);
+        if (ledgerReserve(ledger, (size_t)cart->count) != INV_OK) {
+            for (int i = 0; i < cart->count; i++) {
+                inv->quantities[slots[i]] = oldQuantities[i];
+            }
+            status = INV_ERR_NOMEM;
+        } else {
+            int64_t now = (int64_t)time(NULL);
+            SaleLine *lines = &ledger->lines[ledger->lineCount];
+            for (int i = 0; i < cart->count; i++) {
+                lines[i].id = cart->lines[i].id;
+                lines[i].quantity = cart->lines[i].quantity;
+                lines[i].priceCents = inv->priceCents[slots[i]];
+                versionSave(inv, slots[i], oldQuantities[i]);
+                if (inv->reorder != NULL) {
+                    reorderSold(inv->reorder, cart->lines[i].id, cart->lines[i].quantity, now);
+                }
+                stockChanged(inv, slots[i], oldQuantities[i]);
+            }
+            const LedgerBill *recorded = ledgerRecord(ledger, now, (size_t)cart->count);
+            ledgerWrite(ledger, recorded);
+            if (bill != NULL) {
+                *bill = *recorded;
+            }
+        }
+        pthread_mutex_unlock(&shared->bookLock);
+    }
+    for (int i = stripeCount; i-- > 0;) {
+        pthread_mutex_unlock(&shared->stripes[stripes[i]].lock);
+    }
+    pthread_rwlock_unlock(&shared->storeLock);
+    return status;
+}
+
+/**
+ * @brief Sells a cart from any thread; carts with no stripe in common are checked and
+ * decremented in parallel.
+ *
+ * Like inventoryCheckout, either the whole cart is sold or nothing is, and stock never goes
+ * below zero: each product's stock is checked and taken under its stripe lock.
+ *
+ * @param shared Pointer to the shared inventory.
+ * @param cart Cart to sell; must not be empty.
+ * @param bill Receives a copy of the recorded bill. May be NULL.
+ * @param failedLine Receives the cart line that stopped the sale. May be NULL.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory allocation failed, INV_ERR_NOT_FOUND if a
+ *         product is unknown, INV_ERR_STOCK if a product has too little stock.
+ */
+int sharedCheckout(SharedInventory *shared, const Cart *cart, LedgerBill *bill, int *failedLine) {
+    STATS_START(start);
+    int status = stripedCheckout(shared, cart, bill, failedLine);
+    STATS_STOP(STAT_BILL, start);
+    return status;
+}
+
+#define SNAPSHOT_BATCH 4096 // products read per lock hold by sharedSaveText
+
+/**
+ * @brief Does the work of sharedSaveText, which times it.
+ *
+ * Arguments and result are those of sharedSaveText.
+ */
+static int snapshotSaveText(SharedInventory *shared, const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return INV_ERR_IO;
+    }
+    Report report;
+    Product *products = (Product *)malloc(SNAPSHOT_BATCH * sizeof(Product));
+    if (products == NULL || reportOpen(&report, fd, REPORT_RECORDS) != INV_OK) {
+        free(products);
+        close(fd);
+        return products == NULL ? INV_ERR_NOMEM : INV_ERR_IO;
+    }
+
+    InventorySnapshot snapshot;
+    sharedLock(shared);
+    inventorySnapshot(shared->inv, &snapshot);
+    sharedUnlock(shared);
+    int status;
+    size_t read;
+    do {
+        sharedLock(shared);
+        status = inventorySnapshotRead(shared->inv, &snapshot, products, SNAPSHOT_BATCH, &read);
+        sharedUnlock(shared);
+        for (size_t i = 0; i < read; i++) { // formatted and written with no lock held
+            reportInt(&report, products[i].id);
+            reportText(&report, products[i].name);
+            reportCents(&report, products[i].priceCents);
+            reportInt(&report, products[i].quantity);
+            reportEndRow(&report);
+        }
+    } while (status == INV_OK && read > 0);
+    sharedLock(shared);
+    inventorySnapshotRelease(shared->inv, &snapshot);
+    sharedUnlock(shared);
+
+    free(products);
+    int written = reportClose(&report);
+    if (close(fd) != 0) {
+        written = INV_ERR_IO;
+    }
+    return status != INV_OK ? status : written;
+}
+
+/**
+ * @brief Writes a text backup of a shared inventory while checkouts and changes go on.
+ *
+ * The backup is of one snapshot, so it holds every product exactly as it was when the backup
+ * started. The store lock is only held to take the snapshot and to copy out each batch of
+ * SNAPSHOT_BATCH products, never while formatting or writing, so tills and the thread making
+ * changes wait for at most one batch instead of the whole backup.
+ *
+ * @param shared Pointer to the shared inventory. The calling thread must not hold sharedLock.
+ * @param path Backup file path.
+ * @return INV_OK on success, INV_ERR_IO if the file could not be written, INV_ERR_NOMEM if memory
+ *         allocation failed, INV_ERR_INVALID if the inventory was restored during the backup.
+ */
+int sharedSaveText(SharedInventory *shared, const char *path) {
+    STATS_START(start);
+    int status = snapshotSaveText(shared, path);
+    STATS_STOP(STAT_BACKUP, start);
+    return status;
+}
+
+/**
+ * @brief Tells whether a name can be stored: one word of 1 to NAME_SIZE - 1 bytes with no
+ * blanks or control characters, so it survives the space-separated text formats.
+ *
+ * @param name Product name.
+ * @return Non-zero if the name is valid.
+ */
+static int nameValid(const char *name) {
+    size_t length = 0;
+    if (name == NULL) {
+        return 0;
+    }
+    for (; name[length] != '\0'; length++) {
+        unsigned char c = (unsigned char)name[length];
+        if (length == NAME_SIZE - 1 || c <= ' ' || c == 0x7f) {
+            return 0;
+        }
+    }
+    return length > 0;
+}
+
+/**
+ * @brief Fills a product from its separate fields, checking the name.
+ *
+ * @param product Receives the product.
+ * @param id Product ID.
+ * @param name Product name.
+ * @param priceCents Price, in cents.
+ * @param quantity Stock quantity.
+ * @return INV_OK on success, INV_ERR_INVALID if the name is not valid.
+ */
+static int productSet(Product *product, int id, const char *name, int priceCents, int quantity) {
+    if (!nameValid(name)) {
+        return INV_ERR_INVALID;
+    }
+    product->id = id;
+    strcpy(product->name, name);
+    product->priceCents = priceCents;
+    product->quantity = quantity;
+    return INV_OK;
+}
+
+/**
+ * @brief Adds a product.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id Product ID.
+ * @param name Product name, one word of at most NAME_SIZE - 1 characters.
+ * @param priceCents Price, in cents.
+ * @param quantity Stock quantity.
+ * @return INV_OK, INV_ERR_INVALID for a bad name, INV_ERR_EXISTS if the ID is taken, or
+ *         INV_ERR_NOMEM.
+ */
+int inv_add(Inventory *inv, int id, const char *name, int priceCents, int quantity) {
+    Product product;
+    if (productSet(&product, id, name, priceCents, quantity) != INV_OK) {
+        return INV_ERR_INVALID;
+    }
+    STATS_START(start);
+    int status = inventoryFind(inv, id) != NO_SLOT ? INV_ERR_EXISTS
+               : inventoryInsert(inv, &product) == NO_SLOT ? INV_ERR_NOMEM : INV_OK;
+    STATS_STOP(STAT_ADD, start);
+    STATS_PRODUCTS(inv);
+    return status;
+}
+
+/**
+ * @brief Looks up a product by ID.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id Product ID.
+ * @param product Receives the product details; may be NULL to test for presence only.
+ * @return INV_OK or INV_ERR_NOT_FOUND.
+ */
+int inv_find(const Inventory *inv, int id, Product *product) {
+    STATS_START(start);
+    size_t slot = inventoryFind(inv, id);
+    if (slot != NO_SLOT && product != NULL) {
+        inventoryGet(inv, slot, product);
+    }
+    STATS_STOP(STAT_SEARCH, start);
+    return slot == NO_SLOT ? INV_ERR_NOT_FOUND : INV_OK;
+}
+
+/**
+ * @brief Replaces the name, price and quantity of a product.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id Product ID.
+ * @param name New name, one word of at most NAME_SIZE - 1 characters.
+ * @param priceCents New price, in cents.
+ * @param quantity New stock quantity.
+ * @return INV_OK, INV_ERR_INVALID for a bad name, INV_ERR_NOT_FOUND, or INV_ERR_NOMEM (the
+ *         product is left unchanged).
+ */
+int inv_update(Inventory *inv, int id, const char *name, int priceCents, int quantity) {
+    Product product;
+    if (productSet(&product, id, name, priceCents, quantity) != INV_OK) {
+        return INV_ERR_INVALID;
+    }
+    STATS_START(start);
+    size_t slot = inventoryFind(inv, id);
+    int status = slot == NO_SLOT ? INV_ERR_NOT_FOUND
+               : inventoryUpdate(inv, slot, &product) != INV_OK ? INV_ERR_NOMEM : INV_OK;
+    STATS_STOP(STAT_UPDATE, start);
+    return status;
+}
+
+/**
+ * @brief Sets the stock quantity of a product, leaving its name and price alone.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id Product ID.
+ * @param quantity New stock quantity.
+ * @return INV_OK or INV_ERR_NOT_FOUND.
+ */
+int inv_set_quantity(Inventory *inv, int id, int quantity) {
+    size_t slot = inventoryFind(inv, id);
+    if (slot == NO_SLOT) {
+        return INV_ERR_NOT_FOUND;
+    }
+    inventorySetQuantity(inv, slot, quantity);
+    return INV_OK;
+}
+
+/**
+ * @brief Deletes a product.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id Product ID.
+ * @return INV_OK or INV_ERR_NOT_FOUND.
+ */
+int inv_delete(Inventory *inv, int id) {
+    STATS_START(start);
+    size_t slot = inventoryFind(inv, id);
+    if (slot != NO_SLOT) {
+        inventoryRemove(inv, slot);
+    }
+    STATS_STOP(STAT_DELETE, start);
+    STATS_PRODUCTS(inv);
+    return slot == NO_SLOT ? INV_ERR_NOT_FOUND : INV_OK;
+}
+
+/**
+ * @brief Steps a walk over every product, most recently added first, as the menus list them.
+ *
+ * Start with *cursor set to 0 and call until it returns 0. The inventory must not change
+ * during the walk.
+ *
+ * @param inv Pointer to the inventory.
+ * @param cursor Walk position, moved past the product returned.
+ * @param product Receives the next product.
+ * @return 1 if a product was returned, 0 once every product has been.
+ */
+int inv_next(const Inventory *inv, size_t *cursor, Product *product) {
+    while (*cursor < inv->count) {
+        size_t slot = inv->count - 1 - (*cursor)++;
+        if (inv->live[slot]) {
+            inventoryGet(inv, slot, product);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Sells a cart: every line is priced and taken out of stock, or none is.
+ *
+ * Same as inventoryCheckout, which documents the arguments.
+ *
+ * @return INV_OK, INV_ERR_NOMEM, INV_ERR_NOT_FOUND or INV_ERR_STOCK.
+ */
+int inv_sell(Inventory *inv, Ledger *ledger, const Cart *cart, const LedgerBill **bill, int *failedLine) {
+    return inventoryCheckout(inv, ledger, cart, bill, failedLine);
+}
+
+/**
+ * @brief Claims stores of the current job one at a time and runs the job on each, until none
+ * are left.
+ *
+ * @param chain Pointer to the chain.
+ */
+static void chainRunStores(StoreChain *chain) {
+    ChainPool *pool = &chain->pool;
+    int store;
+    while ((store = __atomic_fetch_add(&pool->nextStore, 1, __ATOMIC_RELAXED)) < chain->count) {
+        pool->job(chain, store, pool->arg);
+    }
+}
+
+/**
+ * @brief Body of a pool worker: waits for each job, helps run it, and reports when done.
+ *
+ * @param arg Pointer to the StoreChain.
+ * @return NULL.
+ */
+static void *chainWorker(void *arg) {
+    StoreChain *chain = (StoreChain *)arg;
+    ChainPool *pool = &chain->pool;
+    pthread_mutex_lock(&pool->lock);
+    uint64_t seen = pool->generation;
+    if (--pool->busy == 0) {
+        pthread_cond_signal(&pool->done); // chainSetThreads waits for every worker to check in
+    }
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        chainRunStores(chain);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * @brief Runs a job once for every store of a chain, spread over the pool and the calling
+ * thread, and returns when every store is done.
+ *
+ * @param chain Pointer to the chain.
+ * @param job Function to run for each store; calls for different stores run concurrently.
+ * @param arg Passed to every call.
+ */
+static void chainFanOut(StoreChain *chain, void (*job)(StoreChain *, int, void *), void *arg) {
+    ChainPool *pool = &chain->pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->arg = arg;
+    pool->nextStore = 0;
+    pool->busy = pool->threadCount;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    chainRunStores(chain);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Stops and joins every pool worker, leaving the calling thread to run jobs alone.
+ *
+ * @param chain Pointer to the chain.
+ */
+static void chainStopWorkers(StoreChain *chain) {
+    ChainPool *pool = &chain->pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 0; t < pool->threadCount; t++) {
+        pthread_join(pool->threads[t], NULL);
+    }
+    pool->threadCount = 0;
+    pool->stop = 0;
+}
+
+/**
+ * @brief Sets up a chain of empty stores, each with its own in-memory sales ledger, and a
+ * pool that runs queries on the calling thread alone until chainSetThreads.
+ *
+ * @param chain Pointer to the chain to set up.
+ * @param stores Number of stores, at least 1.
+ * @param partitioned Non-zero to spread one catalogue over the stores by ID hash, zero for
+ *        independent branches.
+ * @return INV_OK on success, INV_ERR_NOMEM if memory or the pool's locks could not be allocated,
+ *         INV_ERR_INVALID if stores is not positive.
+ */
+int chainInit(StoreChain *chain, int stores, int partitioned) {
+    memset(chain, 0, sizeof(*chain));
+    if (stores <= 0) {
+        return INV_ERR_INVALID;
+    }
+    chain->stores = (Inventory *)malloc((size_t)stores * sizeof(Inventory));
+    chain->ledgers = (Ledger *)malloc((size_t)stores * sizeof(Ledger));
+    int locks = 0; // pool locks set up so far
+    if (chain->stores != NULL && chain->ledgers != NULL && pthread_mutex_init(&chain->pool.lock, NULL) == 0) {
+        locks++;
+        if (pthread_cond_init(&chain->pool.work, NULL) == 0) {
+            locks++;
+            locks += pthread_cond_init(&chain->pool.done, NULL) == 0;
+        }
+    }
+    if (locks < 3) {
+        if (locks > 1) {
+            pthread_cond_destroy(&chain->pool.work);
+        }
+        if (locks > 0) {
+            pthread_mutex_destroy(&chain->pool.lock);
+        }
+        free(chain->stores);
+        free(chain->ledgers);
+        memset(chain, 0, sizeof(*chain));
+        return INV_ERR_NOMEM;
+    }
+    for (int s = 0; s < stores; s++) {
+        inventoryInit(&chain->stores[s]);
+        ledgerInit(&chain->ledgers[s]);
+    }
+    chain->count = stores;
+    chain->partitioned = partitioned != 0;
+    return INV_OK;
+}
+
+/**
+ * @brief Sets how many threads run the chain's queries, the calling thread included.
+ *
+ * @param chain Pointer to the chain, with no query running.
+ * @param threads Threads, 1 to MAX_LOAD_THREADS; more are clamped.
+ * @return Threads actually running: fewer than asked if some could not be started.
+ */
+int chainSetThreads(StoreChain *chain, int threads) {
+    ChainPool *pool = &chain->pool;
+    chainStopWorkers(chain);
+    if (threads > MAX_LOAD_THREADS) {
+        threads = MAX_LOAD_THREADS;
+    }
+    // Workers read the job generation when they start, so none may start after a job is posted
+    pthread_mutex_lock(&pool->lock);
+    while (pool->threadCount < threads - 1 &&
+           pthread_create(&pool->threads[pool->threadCount], NULL, chainWorker, chain) == 0) {
+        pool->threadCount++;
+        pool->busy++;
+    }
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return pool->threadCount + 1;
+}
+
+/**
+ * @brief Stops the pool and frees every store and ledger of a chain.
+ *
+ * @param chain Pointer to the chain.
+ */
+void chainFree(StoreChain *chain) {
+    if (chain->stores == NULL) {
+        return;
+    }
+    chainStopWorkers(chain);
+    for (int s = 0; s < chain->count; s++) {
+        inventoryFree(&chain->stores[s]);
+        ledgerFree(&chain->ledgers[s]);
+    }
+    pthread_cond_destroy(&chain->pool.work);
+    pthread_cond_destroy(&chain->pool.done);
+    pthread_mutex_destroy(&chain->pool.lock);
+    free(chain->stores);
+    free(chain->ledgers);
+    memset(chain, 0, sizeof(*chain));
+}
+
+/**
+ * @brief Finds the store that holds a product ID in a partitioned chain.
+ *
+ * @param chain Pointer to the chain.
+ * @param id Product ID.
+ * @return Store number.
+ */
+int chainStoreOf(const StoreChain *chain, int id) {
+    return (int)(hashId(id) % (size_t)chain->count);
+}
+
+/**
+ * @brief Adds a product to one store of a chain.
+ *
+ * @param chain Pointer to the chain.
+ * @param store Branch to add it to; ignored in a partitioned chain, which picks the store
+ *        from the ID.
+ * @param id Product ID.
+ * @param name Product name, one word of at most NAME_SIZE - 1 characters.
+ * @param priceCents Price, in cents.
+ * @param quantity Stock quantity.
+ * @return As inv_add, or INV_ERR_INVALID if store is out of range.
+ */
+int chainAdd(StoreChain *chain, int store, int id, const char *name, int priceCents, int quantity) {
+    if (chain->partitioned) {
+        store = chainStoreOf(chain, id);
+    }
+    if (store < 0 || store >= chain->count) {
+        return INV_ERR_INVALID;
+    }
+    return inv_add(&chain->stores[store], id, name, priceCents, quantity);
+}
+
+/**
+ * @brief Sells a cart at one branch of a chain, into that branch's ledger.
+ *
+ * @param chain Pointer to the chain.
+ * @param store Branch number.
+ * @param cart Products and quantities to sell.
+ * @param bill Receives the bill, as with inventoryCheckout. May be NULL.
+ * @param failedLine Receives the failing cart line, as with inventoryCheckout. May be NULL.
+ * @return As inv_sell, or INV_ERR_INVALID if store is out of range.
+ */
+int chainSell(StoreChain *chain, int store, const Cart *cart, const LedgerBill **bill, int *failedLine) {
+    if (store < 0 || store >= chain->count) {
+        return INV_ERR_INVALID;
+    }
+    return inv_sell(&chain->stores[store], &chain->ledgers[store], cart, bill, failedLine);
+}
+
+/**
+ * @brief Recounts one store's totals into its entry of the per-store results.
+ */
+static void chainRecountJob(StoreChain *chain, int store, void *arg) {
+    inventoryRecount(&chain->stores[store], &((InventoryTotals *)arg)[store]);
+}
+
+/**
+ * @brief Adds up stock value, units, products, low-stock products and sales over every store.
+ *
+ * Stores keep running totals, so by default this only sums them. With recount, every store is
+ * scanned in full, the stores shared out over the pool, which is how the chain's totals are
+ * audited; if memory for the per-store results runs out, the running totals are summed instead.
+ *
+ * @param chain Pointer to the chain.
+ * @param recount Non-zero to recount every store rather than trust its running totals.
+ * @param totals Receives the chain's totals.
+ * @param salesCents Receives the sales of every branch's ledger. May be NULL.
+ */
+void chainTotals(StoreChain *chain, int recount, InventoryTotals *totals, long long *salesCents) {
+    InventoryTotals *perStore = recount ? (InventoryTotals *)malloc((size_t)chain->count * sizeof(InventoryTotals)) : NULL;
+    if (perStore != NULL) {
+        chainFanOut(chain, chainRecountJob, perStore);
+    }
+    memset(totals, 0, sizeof(*totals));
+    long long sales = 0;
+    for (int s = 0; s < chain->count; s++) {
+        InventoryTotals store;
+        if (perStore != NULL) {
+            store = perStore[s];
+        } else {
+            inventoryTotals(&chain->stores[s], &store);
+        }
+        totals->stockValueCents += store.stockValueCents;
+        totals->units += store.units;
+        totals->skus += store.skus;
+        totals->lowStock += store.lowStock;
+        sales += calculateTotalSales(&chain->ledgers[s]);
+    }
+    free(perStore);
+    if (salesCents != NULL) {
+        *salesCents = sales;
+    }
+}
+
+// Per-store results of a chain-wide ID search
+typedef struct {
+    int id;
+    size_t *slots; // per store: slot of the product, or NO_SLOT
+} ChainFindQuery;
+
+/**
+ * @brief Looks the query's ID up in one store.
+ */
+static void chainFindJob(StoreChain *chain, int store, void *arg) {
+    ChainFindQuery *query = (ChainFindQuery *)arg;
+    query->slots[store] = inventoryFind(&chain->stores[store], query->id);
+}
+
+/**
+ * @brief Finds a product ID in every branch that stocks it.
+ *
+ * In a partitioned chain only the store the ID hashes to is asked; otherwise every branch is
+ * asked, the branches shared out over the pool.
+ *
+ * @param chain Pointer to the chain.
+ * @param id Product ID.
+ * @param hits Receives each store's product, lowest store number first.
+ * @param max Capacity of hits.
+ * @return Hits written, or NO_SLOT if memory allocation failed.
+ */
+size_t chainFind(StoreChain *chain, int id, ChainHit *hits, size_t max) {
+    if (chain->partitioned) {
+        int store = chainStoreOf(chain, id);
+        size_t slot = inventoryFind(&chain->stores[store], id);
+        if (slot == NO_SLOT || max == 0) {
+            return 0;
+        }
+        hits[0].store = store;
+        inventoryGet(&chain->stores[store], slot, &hits[0].product);
+        return 1;
+    }
+    ChainFindQuery query;
+    query.id = id;
+    query.slots = (size_t *)malloc((size_t)chain->count * sizeof(size_t));
+    if (query.slots == NULL) {
+        return NO_SLOT;
+    }
+    chainFanOut(chain, chainFindJob, &query);
+    size_t found = 0;
+    for (int s = 0; s < chain->count && found < max; s++) {
+        if (query.slots[s] != NO_SLOT) {
+            hits[found].store = s;
+            inventoryGet(&chain->stores[s], query.slots[s], &hits[found].product);
+            found++;
+        }
+    }
+    free(query.slots);
+    return found;
+}
+
+// Per-store results of a chain-wide low-stock query
+typedef struct {
+    int threshold;
+    size_t **slots;  // per store: its low-stock slots, lowest quantity first
+    size_t *counts;  // per store: entries in slots, or NO_SLOT if memory ran out
+} ChainLowQuery;
+
+/**
+ * @brief Lists one store's products below the query's threshold from its quantity index.
+ */
+static void chainLowStockJob(StoreChain *chain, int store, void *arg) {
+    ChainLowQuery *query = (ChainLowQuery *)arg;
+    Inventory *inv = &chain->stores[store];
+    query->slots[store] = (size_t *)malloc((inv->liveCount ? inv->liveCount : 1) * sizeof(size_t));
+    query->counts[store] = query->slots[store] == NULL ? NO_SLOT
+                         : inventoryRange(inv, ORDER_QUANTITY, INT_MIN, query->threshold - 1, query->slots[store], inv->liveCount);
+}
+
+/**
+ * @brief Orders low-stock products by quantity, then store, then ID.
+ */
+static int chainItemCompare(const void *a, const void *b) {
+    const ChainItem *x = (const ChainItem *)a;
+    const ChainItem *y = (const ChainItem *)b;
+    if (x->quantity != y->quantity) {
+        return x->quantity < y->quantity ? -1 : 1;
+    }
+    if (x->store != y->store) {
+        return x->store < y->store ? -1 : 1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/**
+ * @brief Lists the products below a stock level across every store, lowest stock first.
+ *
+ * Each store answers from its own quantity index, the stores shared out over the pool, and
+ * the lists are merged.
+ *
+ * @param chain Pointer to the chain.
+ * @param threshold Products with fewer units than this are listed.
+ * @param items Receives the products.
+ * @param max Capacity of items; further products are not reported.
+ * @return Products written, or NO_SLOT if memory allocation failed.
+ */
+size_t chainLowStock(StoreChain *chain, int threshold, ChainItem *items, size_t max) {
+    if (threshold == INT_MIN) {
+        return 0;
+    }
+    ChainLowQuery query;
+    query.threshold = threshold;
+    query.slots = (size_t **)calloc((size_t)chain->count, sizeof(size_t *));
+    query.counts = (size_t *)malloc((size_t)chain->count * sizeof(size_t));
+    size_t total = 0;
+    int failed = query.slots == NULL || query.counts == NULL;
+    if (!failed) {
+        chainFanOut(chain, chainLowStockJob, &query);
+        for (int s = 0; s < chain->count; s++) {
+            failed |= query.counts[s] == NO_SLOT;
+            total += failed ? 0 : query.counts[s];
+        }
+    }
+
+    ChainItem *all = failed ? NULL : (ChainItem *)malloc((total ? total : 1) * sizeof(ChainItem));
+    size_t found = 0;
+    if (all != NULL) {
+        for (int s = 0; s < chain->count; s++) {
+            const Inventory *inv = &chain->stores[s];
+            for (size_t i = 0; i < query.counts[s]; i++) {
+                size_t slot = query.slots[s][i];
+                all[found].store = s;
+                all[found].id = inv->ids[slot];
+                all[found].quantity = inv->quantities[slot];
+                all[found].priceCents = inv->priceCents[slot];
+                found++;
+            }
+        }
+        qsort(all, found, sizeof(ChainItem), chainItemCompare);
+        found = found < max ? found : max;
+        if (found > 0) {
+            memcpy(items, all, found * sizeof(ChainItem));
+        }
+        free(all);
+    }
+    for (int s = 0; query.slots != NULL && s < chain->count; s++) {
+        free(query.slots[s]);
+    }
+    free(query.slots);
+    free(query.counts);
+    return all == NULL ? NO_SLOT : found;
+}
+
+#ifdef INVENTORY_STATS
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds for the operation statistics.
+ *
+ * @return Current monotonic time in nanoseconds.
+ */
+static uint64_t statsNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Finds the histogram bucket of a latency.
+ *
+ * Values below 2 * STAT_SUB_BUCKETS get a bucket each; above that, every power of two is split
+ * into STAT_SUB_BUCKETS equal buckets.
+ *
+ * @param ns Latency in nanoseconds.
+ * @return Bucket index, below STAT_BUCKETS.
+ */
+static size_t statsBucket(uint64_t ns) {
+    if (ns < 2 * STAT_SUB_BUCKETS) {
+        return (size_t)ns;
+    }
+    int shift = 63 - __builtin_clzll(ns) - 3; // keeps the top four bits
+    return (size_t)(shift + 1) * STAT_SUB_BUCKETS + (size_t)((ns >> shift) - STAT_SUB_BUCKETS);
+}
+
+/**
+ * @brief Raises a statistics maximum to a value if it is larger.
+ *
+ * @param max Pointer to the maximum.
+ * @param value Candidate value.
+ */
+static void statsRaise(uint64_t *max, uint64_t value) {
+    uint64_t seen = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > seen && !__atomic_compare_exchange_n(max, &seen, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // seen now holds the current maximum; try again
+    }
+}
+
+/**
+ * @brief Records one timed operation. Safe to call from several threads at once.
+ *
+ * @param op Operation, STAT_ADD...
+ * @param start Timestamp from statsNow taken when the operation began.
+ */
+static void statsRecord(int op, uint64_t start) {
+    uint64_t ns = statsNow() - start;
+    OpStats *opStats = &stats.ops[op];
+    __atomic_fetch_add(&opStats->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&opStats->totalNs, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&opStats->buckets[statsBucket(ns)], 1, __ATOMIC_RELAXED);
+    statsRaise(&opStats->maxNs, ns);
+}
+
+/**
+ * @brief Records the product count after an operation that changes it.
+ *
+ * @param products Products in the inventory.
+ */
+static void statsProducts(size_t products) {
+    __atomic_store_n(&stats.products, (uint64_t)products, __ATOMIC_RELAXED);
+    statsRaise(&stats.peakProducts, (uint64_t)products);
+}
+#endif
+
+/**
+ * @brief Copies out the operation statistics.
+ *
+ * Only reads memory, so it is safe in a signal handler and while other threads are recording.
+ *
+ * @param out Receives the statistics.
+ * @return INV_OK on success, INV_ERR_UNSUPPORTED if the library was built without INVENTORY_STATS
+ *         (out is zeroed).
+ */
+int inventoryStatsRead(InventoryStats *out) {
+#ifdef INVENTORY_STATS
+    for (int op = 0; op < STAT_COUNT; op++) {
+        const OpStats *from = &stats.ops[op];
+        OpStats *to = &out->ops[op];
+        to->count = __atomic_load_n(&from->count, __ATOMIC_RELAXED);
+        to->totalNs = __atomic_load_n(&from->totalNs, __ATOMIC_RELAXED);
+        to->maxNs = __atomic_load_n(&from->maxNs, __ATOMIC_RELAXED);
+        for (size_t i = 0; i < STAT_BUCKETS; i++) {
+            to->buckets[i] = __atomic_load_n(&from->buckets[i], __ATOMIC_RELAXED);
+        }
+    }
+    out->products = __atomic_load_n(&stats.products, __ATOMIC_RELAXED);
+    out->peakProducts = __atomic_load_n(&stats.peakProducts, __ATOMIC_RELAXED);
+    return INV_OK;
+#else
+    memset(out, 0, sizeof(*out));
+    return INV_ERR_UNSUPPORTED;
+#endif
+}
+
+/**
+ * @brief Clears the operation statistics. Not safe while other threads are recording.
+ */
+void inventoryStatsReset(void) {
+#ifdef INVENTORY_STATS
+    memset(&stats, 0, sizeof(stats));
+#endif
+}
+
+/**
+ * @brief Estimates a latency percentile from an operation's histogram.
+ *
+ * The result is the upper edge of the bucket holding the percentile, capped at the maximum, so
+ * it overstates the true value by at most one bucket width (12.5%).
+ *
+ * @param op Statistics of one operation.
+ * @param perMille Percentile in thousandths: 500 for the median, 999 for p99.9.
+ * @return Latency in nanoseconds, or 0 if nothing was recorded.
+ */
+uint64_t inventoryStatsPercentile(const OpStats *op, unsigned perMille) {
+    if (op->count == 0) {
+        return 0;
+    }
+    uint64_t rank = (op->count * perMille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < STAT_BUCKETS; i++) {
+        seen += op->buckets[i];
+        if (seen >= rank) {
+            if (i < 2 * STAT_SUB_BUCKETS) {
+                return i;
+            }
+            int shift = (int)(i / STAT_SUB_BUCKETS) - 1;
+            uint64_t high = ((uint64_t)(STAT_SUB_BUCKETS + i % STAT_SUB_BUCKETS + 1) << shift) - 1;
+            return high < op->maxNs ? high : op->maxNs;
+        }
+    }
+    return op->maxNs;
+}
+
+/**
+ * @brief Names a timed operation, for reports.
+ *
+ * @param op Operation, STAT_ADD...
+ * @return Lower-case name, such as "search".
+ */
+const char *inventoryStatName(int op) {
+    static const char *const names[STAT_COUNT] = {"add", "search", "update", "delete", "bill", "backup", "restore"};
+    return op >= 0 && op < STAT_COUNT ? names[op] : "unknown";
+}
@@ -0,0 +1,598 @@
+/**
+ * @file inventory.h
+ * @brief Inventory engine: the product store, its indexes, persistence and billing.
+ *
+ * Nothing in the engine reads the terminal or prints. Every function works on caller-owned
+ * structures and reports failure through its return value, so the menu programs, batch mode,
+ * the socket server and the benchmarks are all thin front ends over the same code.
+ * Compile users with _POSIX_C_SOURCE 200809L defined (for pthread_rwlock_t) and link them
+ * with libinventory.a, -pthread and -lm.
+ */
+
+#ifndef INVENTORY_H
+#define INVENTORY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_SIMD 1
+#endif
+
+// Status codes. Functions that report success or failure return INV_OK or one of these.
+#define INV_OK 0
+#define INV_ERR_IO -1          // a file could not be read or written
+#define INV_ERR_NOMEM -2       // memory allocation failed
+#define INV_ERR_INVALID -3     // malformed file or argument
+#define INV_ERR_NOT_FOUND -4   // no product with that ID
+#define INV_ERR_STOCK -5       // too little stock for a sale
+#define INV_ERR_EXISTS -6      // a product with that ID already exists
+#define INV_ERR_UNSUPPORTED -7 // not built into this library
+
+#define NAME_SIZE 100
+#define CENTS_BUF_SIZE 24
+
+typedef struct {
+    int id;
+    char name[NAME_SIZE];
+    int priceCents; // price in cents, so money arithmetic is exact
+    int quantity;
+} Product;
+
+// Open-addressing (linear probing) hash table mapping product IDs to store slots
+typedef struct {
+    uint32_t *slots; // INDEX_EMPTY marks an unused slot
+    size_t capacity; // always a power of two
+    size_t count;
+} IdIndex;
+
+#define ORDER_PRICE 0
+#define ORDER_QUANTITY 1
+#define ORDER_COUNT 2
+#define ORDER_NIL UINT32_MAX
+
+// Node of an ordered index, kept in a growable array and linked by position
+typedef struct {
+    int key;           // price in cents or quantity
+    int id;            // product ID, which orders products with equal keys
+    uint32_t left;     // ORDER_NIL when absent
+    uint32_t right;
+    uint32_t priority; // random; every node outranks its children
+} OrderNode;
+
+// Treap of (key, product ID) pairs sorted by key, for range and top-K queries in O(log n + k).
+// Nodes hold product IDs rather than slots, so compacting the store leaves them valid.
+typedef struct {
+    OrderNode *nodes;
+    size_t capacity;   // nodes allocated
+    size_t used;       // nodes handed out, including freed ones
+    uint32_t root;
+    uint32_t freeList; // freed nodes, linked through left
+    uint32_t seed;     // priority generator state
+    int valid;         // 0 until built; bulk loads clear it and the next query rebuilds
+} OrderIndex;
+
+#define NAME_ALPHABET 37 // a-z, 0-9, and one symbol for everything else
+#define NAME_TRIGRAMS (NAME_ALPHABET * NAME_ALPHABET * NAME_ALPHABET)
+#define NAME_MAX_TRIGRAMS (NAME_SIZE - 3)
+#define ARENA_MIN_COMPACT (1 << 16)
+
+// Posting list of one trigram: store slots of products whose name contains it
+typedef struct {
+    uint32_t *slots;
+    uint32_t count;
+    uint32_t capacity;
+} NamePosting;
+
+// Case-insensitive trigram inverted index over product names, for substring and prefix search.
+// Deletes and renames leave stale entries behind instead of searching the lists; every hit is
+// checked against the current name, and the index is rebuilt once stale entries dominate.
+// Entries are store slots, so compacting the store also sends the index back for a rebuild.
+typedef struct {
+    NamePosting *postings; // NAME_TRIGRAMS lists, allocated on first build
+    size_t entries;        // entries across all lists
+    size_t stale;          // entries whose product was deleted or renamed
+    int renamed;           // set once a rename appends out of slot order
+    int valid;             // 0 until built; bulk loads clear it and the next search rebuilds
+} NameIndex;
+
+// Handle to an interned product name: its bytes start at offset in the name arena
+typedef struct {
+    uint32_t offset;
+    uint32_t length; // bytes, excluding the terminator
+} NameRef;
+
+// Arena of interned product names. Each distinct name is stored once, NUL-terminated, and
+// products keep only a NameRef, so equal names share their bytes.
+typedef struct {
+    char *bytes;
+    size_t used;
+    size_t capacity;
+    uint32_t *table;      // offsets of distinct names, open addressing; INDEX_EMPTY when unused
+    size_t tableCapacity; // always a power of two once allocated
+    size_t distinct;      // names in table
+    size_t indexed;       // bytes of the arena whose names are in table
+    size_t dropped;       // bytes of names no longer referenced (an upper bound)
+} NameArena;
+
+// Write-ahead log of inventory changes, appended to between checkpoint snapshots
+typedef struct {
+    int fd;
+    char path[256];
+    char checkpointPath[256];
+    uint64_t nextLsn;       // sequence number of the next record
+    unsigned char *buffer;  // records not yet written to the file
+    size_t used;            // bytes in buffer
+    size_t pendingRecords;  // records written since the last sync
+    off_t size;             // bytes in the file
+    int failed;             // set after an I/O error
+} Wal;
+
+// A store row as it was before a change, kept while an open snapshot may still need it
+typedef struct {
+    uint32_t slot;
+    uint32_t next;       // older saved row of the same slot, or UINT32_MAX
+    uint32_t until;      // epoch of the change that replaced this row
+    int id;
+    int priceCents;
+    int quantity;
+    NameRef name;        // still in the arena: names are not compacted while snapshots are open
+    unsigned char live;
+} RowVersion;
+
+// Copy-on-write state behind snapshots. Taking a snapshot only ends an epoch; the first change
+// to a row that an open snapshot may see saves the old row here, and a snapshot reads the row
+// as of its epoch by following the slot's saved rows from newest to oldest.
+typedef struct {
+    RowVersion *rows;
+    size_t count;
+    size_t capacity;
+    uint32_t *heads;     // per store slot: newest saved row, UINT32_MAX if none; NULL until needed
+    uint32_t epoch;      // epoch of changes made now
+    uint32_t newest;     // epoch of the newest open snapshot
+    uint32_t open;       // snapshots not yet released
+    uint32_t generation; // bumped when open snapshots lose their view (restore, out of memory)
+} RowVersions;
+
+// A point-in-time view of an inventory, taken in constant time
+typedef struct {
+    uint32_t epoch;      // sees changes made up to and including this epoch
+    uint32_t generation; // RowVersions generation it was taken in
+    size_t count;        // store slots when taken; later inserts land beyond them
+    size_t next;         // next slot to read
+    int open;            // cleared by inventorySnapshotRelease
+} InventorySnapshot;
+
+#define REORDER_DEMAND_DAYS 14.0 // time constant of the demand average, in days
+#define REORDER_COVER_DAYS 14     // orders sized from demand bring stock this many days above the point
+
+// Reorder state of one product
+typedef struct {
+    int id;
+    int quantity;       // stock, kept in step with the store
+    int point;          // due for reordering at or below this many units
+    int orderUnits;     // units to order; 0 sizes the order from demand
+    int custom;         // point and orderUnits were set for this product
+    uint32_t heapPos;   // position in the due heap, UINT32_MAX when not due
+    double logDemand;   // log of units sold, each weighted by e^(days since 1970 / REORDER_DEMAND_DAYS)
+    double key;         // log of days of cover, less a time term every product shares
+} ReorderEntry;
+
+// Reorder queue: every product's reorder point and recent demand, and a min-heap by days of
+// cover of those at or below their point. Stock changes and sales update one entry and move it
+// in the heap in O(log n). Demand decays exponentially with time, and is kept referenced to a
+// fixed date, so the passing of time never reorders the heap.
+typedef struct {
+    ReorderEntry *entries;
+    int *ids;           // entry IDs, the column the ID index hashes
+    size_t count;
+    size_t capacity;
+    IdIndex index;      // product ID -> entry
+    uint32_t *heap;     // entries due for reordering, most urgent at the top
+    size_t heapCount;
+    int defaultPoint;   // reorder point of products without one of their own
+    int failed;         // set when memory ran out and a change was missed; reorderAttach rebuilds
+} ReorderQueue;
+
+// One product of the reorder list or a purchase order
+typedef struct {
+    int id;
+    int quantity;
+    int point;
+    int orderUnits;     // units to order
+    double dailyDemand; // units a day
+    double daysOfCover; // INFINITY when nothing sold lately
+} ReorderItem;
+
+// The inventory, stored as a structure of arrays. Each product occupies one slot in every
+// column, in insertion order. Deleted slots become tombstones with zero price and quantity,
+// so aggregates can stream the hot columns without checking liveness.
+typedef struct {
+    int *ids;
+    int *priceCents;
+    int *quantities;
+    NameRef *nameRefs;        // cold: handles into arena, only touched when printing or searching
+    unsigned char *live;      // 1 for a product, 0 for a tombstone
+    size_t count;             // slots in use, including tombstones
+    size_t liveCount;         // products in the inventory
+    size_t capacity;          // slots allocated in every column
+    IdIndex index;            // product ID -> slot
+    OrderIndex orders[ORDER_COUNT]; // products sorted by price and by quantity
+    NameArena arena;          // interned names
+    NameIndex nameIndex;      // name trigrams -> store slots
+    Wal *wal;                 // change log, or NULL when changes are not logged
+    long long stockValueCents; // running totals over the products, kept up to date on every change
+    long long units;
+    size_t lowStock;          // products with quantity below lowStockThreshold
+    int lowStockThreshold;
+    RowVersions versions;     // rows saved for open snapshots
+    ReorderQueue *reorder;    // told of every stock change, or NULL
+} Inventory;
+
+#define LOW_STOCK_DEFAULT 10
+
+// Stock report figures, either read from an inventory's running totals or recounted
+typedef struct {
+    long long stockValueCents; // sum of price times quantity
+    long long units;           // sum of quantities
+    size_t skus;               // products
+    size_t lowStock;           // products with quantity below the threshold
+} InventoryTotals;
+
+// Signature shared by the stock valuation kernels
+typedef long long (*ValuationKernel)(const int *priceCents, const int *quantities, size_t n);
+
+#define NO_SLOT ((size_t)-1)
+#define MAX_LOAD_THREADS 64
+#define CART_MAX_LINES 64
+
+// One line of a cart: a product and how many units the customer takes
+typedef struct {
+    int id;
+    int quantity;
+} CartLine;
+
+// Products being bought in one checkout; each product appears on at most one line
+typedef struct {
+    CartLine lines[CART_MAX_LINES];
+    int count;
+} Cart;
+
+// One line of a completed bill, priced when the bill was made
+typedef struct {
+    int id;
+    int quantity;
+    int priceCents;
+} SaleLine;
+
+// One completed bill in the sales ledger
+typedef struct {
+    uint64_t number;      // bill number, from 1
+    int64_t time;         // seconds since the epoch
+    long long totalCents;
+    size_t firstLine;     // position of its first line in the ledger's lines
+    size_t lineCount;
+} LedgerBill;
+
+// One product's sales on one day, summed over every bill line
+typedef struct {
+    int32_t id;
+    int32_t reserved;
+    int64_t units;
+    int64_t revenueCents;
+} DaySales;
+
+// Sales of one day: a DaySales per product sold, plus the day's totals
+typedef struct {
+    int32_t day;          // days since 1970-01-01, by the local calendar
+    DaySales *sales;
+    size_t count;
+    size_t capacity;
+    int64_t units;
+    int64_t revenueCents;
+} SalesDay;
+
+// Days on which one product sold, with running totals, so any date range sums with two
+// binary searches
+typedef struct {
+    int32_t id;
+    size_t count;
+    size_t capacity;
+    int32_t *days;         // ascending
+    int64_t *units;        // units sold on days[0] through days[i]
+    int64_t *revenueCents; // revenue on days[0] through days[i]
+    uint32_t *sales;       // position of each day's DaySales in its SalesDay
+} SalesSeries;
+
+// A bill line not yet written to its month's partition file
+typedef struct {
+    uint64_t bill;
+    int32_t day;
+    int32_t id;
+    int32_t quantity;
+    int32_t priceCents;
+} HistoryLine;
+
+// Sales history: bill lines appended to one columnar file per month in a directory, held in
+// memory as per-day, per-product rollups. Months before the current one also keep their
+// rollups in a file, so opening reads those instead of every line.
+typedef struct {
+    char dir[256];
+    SalesDay *days;           // ascending by day
+    size_t dayCount;
+    size_t dayCapacity;
+    SalesSeries *series;
+    size_t seriesCount;
+    size_t seriesCapacity;
+    uint32_t *seriesIndex;    // product ID -> series, open addressing
+    size_t indexCapacity;     // always a power of two once allocated
+    HistoryLine *pending;     // lines waiting for historySync
+    size_t pendingCount;
+    size_t pendingCapacity;
+    uint64_t lastBill;        // highest bill number recorded
+    int failed;               // set after a write or allocation error
+} SalesHistory;
+
+// Sales of one product (or of everything, with id 0) over a range of days
+typedef struct {
+    int32_t id;
+    int64_t units;
+    int64_t revenueCents;
+} ProductSales;
+
+// Every bill made so far, in memory and appended to a text file, with running totals so
+// sales figures never need a scan
+typedef struct {
+    LedgerBill *bills;
+    size_t billCount;
+    size_t billCapacity;
+    SaleLine *lines;
+    size_t lineCount;
+    size_t lineCapacity;
+    long long totalCents; // sum of every bill
+    long long units;      // units sold across every bill
+    FILE *fp;             // ledger file opened for appending, or NULL when not persisted
+    int failed;           // set after a write error
+    SalesHistory *history; // also records every new bill's lines, or NULL
+} Ledger;
+
+#define STOCK_STRIPES 256
+
+// A stock lock on its own cache line, so tills working on different stripes do not contend
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+} StockStripe;
+
+// An inventory and ledger shared by many checkout threads. Checkouts hold storeLock shared,
+// lock the stripes of their products' slots (slot % STOCK_STRIPES, in ascending order) to
+// check and take stock, then take bookLock to record the bill; anything else holds storeLock
+// exclusively. Lock order: storeLock, stripes, bookLock.
+typedef struct {
+    Inventory *inv;
+    Ledger *ledger;
+    pthread_rwlock_t storeLock;
+    StockStripe stripes[STOCK_STRIPES];
+    pthread_mutex_t bookLock; // ledger, change log and quantity index
+} SharedInventory;
+
+struct StoreChain;
+
+// Worker threads that run one job over every store of a StoreChain. The calling thread takes
+// part too, so a pool of n threads starts n - 1 workers.
+typedef struct {
+    pthread_t threads[MAX_LOAD_THREADS];
+    int threadCount;     // workers started, besides the calling thread
+    pthread_mutex_t lock;
+    pthread_cond_t work; // a job was posted, or the pool is stopping
+    pthread_cond_t done; // the last worker finished the job
+    void (*job)(struct StoreChain *chain, int store, void *arg);
+    void *arg;
+    uint64_t generation; // bumped for every job
+    int nextStore;       // next store to claim, taken with an atomic add
+    int busy;            // workers still on the job
+    int stop;
+} ChainPool;
+
+// A chain of stores, each an independent inventory with its own sales ledger. Either every
+// store is a branch with its own products, or the stores are partitions of one catalogue and
+// each product lives in the store its ID hashes to. Cross-store queries fan out over the
+// pool, one store at a time per thread, and merge the results; stores must not change while
+// a query runs.
+typedef struct StoreChain {
+    Inventory *stores;
+    Ledger *ledgers;
+    int count;
+    int partitioned; // products are placed by ID hash rather than by branch
+    ChainPool pool;
+} StoreChain;
+
+// A product found in one store of a chain
+typedef struct {
+    int store;
+    Product product;
+} ChainHit;
+
+// A low-stock product of a chain
+typedef struct {
+    int store;
+    int id;
+    int quantity;
+    int priceCents;
+} ChainItem;
+
+#define REPORT_TABLE 0   // aligned columns, for people
+#define REPORT_CSV 1     // comma-separated, names quoted when needed
+#define REPORT_TSV 2     // tab-separated
+#define REPORT_RECORDS 3 // space-separated with no header: the text backup format
+#define REPORT_BUFFER_SIZE (1 << 18)
+#define REPORT_MAX_COLUMNS 8
+
+// Renders rows of a listing into one large buffer with hand-written number formatting, and
+// writes it to a file descriptor in a few large writes
+typedef struct {
+    int fd;
+    int format;                     // REPORT_TABLE...
+    char *buffer;
+    size_t used;
+    int widths[REPORT_MAX_COLUMNS]; // table columns: characters, negative to left-align
+    int columns;
+    int column;                     // next field of the current row
+    size_t rows;                    // rows ended, excluding the header
+    int failed;                     // set after a write error
+} Report;
+
+// Operations timed by the built-in statistics
+#define STAT_ADD 0
+#define STAT_SEARCH 1
+#define STAT_UPDATE 2
+#define STAT_DELETE 3
+#define STAT_BILL 4
+#define STAT_BACKUP 5
+#define STAT_RESTORE 6
+#define STAT_COUNT 7
+
+#define STAT_SUB_BUCKETS 8 // histogram buckets per power of two, so each spans at most 12.5%
+#define STAT_BUCKETS 496   // enough for any 64-bit nanosecond count
+
+// Latencies of one kind of operation, in a log-linear (HDR-style) histogram of nanoseconds
+typedef struct {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint64_t buckets[STAT_BUCKETS];
+} OpStats;
+
+// Operation statistics since start-up. They are only recorded when the library is built with
+// INVENTORY_STATS defined; otherwise the timing code is compiled out and they stay zero.
+typedef struct {
+    OpStats ops[STAT_COUNT];
+    uint64_t products;     // products after the latest timed add, delete or restore
+    uint64_t peakProducts;
+} InventoryStats;
+
+// Allocator calls made by the store and the ID index, reported by benchmarks
+extern size_t storeAllocations;
+
+// Products by ID, returning status codes
+int inv_add(Inventory *inv, int id, const char *name, int priceCents, int quantity);
+int inv_find(const Inventory *inv, int id, Product *product);
+int inv_update(Inventory *inv, int id, const char *name, int priceCents, int quantity);
+int inv_set_quantity(Inventory *inv, int id, int quantity);
+int inv_delete(Inventory *inv, int id);
+int inv_next(const Inventory *inv, size_t *cursor, Product *product);
+int inv_sell(Inventory *inv, Ledger *ledger, const Cart *cart, const LedgerBill **bill, int *failedLine);
+
+// Store slots, indexes and queries
+void inventoryInit(Inventory *inv);
+void inventoryClear(Inventory *inv);
+void inventoryFree(Inventory *inv);
+size_t inventoryFind(const Inventory *inv, int id);
+size_t inventoryInsert(Inventory *inv, const Product *product);
+int inventoryUpdate(Inventory *inv, size_t slot, const Product *product);
+void inventoryRemove(Inventory *inv, size_t slot);
+void inventoryGet(const Inventory *inv, size_t slot, Product *product);
+void inventorySnapshot(Inventory *inv, InventorySnapshot *snapshot);
+int inventorySnapshotRead(const Inventory *inv, InventorySnapshot *snapshot, Product *products, size_t max, size_t *read);
+void inventorySnapshotRelease(Inventory *inv, InventorySnapshot *snapshot);
+void inventorySetQuantity(Inventory *inv, size_t slot, int quantity);
+const char *inventoryName(const Inventory *inv, size_t slot);
+void inventoryTotals(const Inventory *inv, InventoryTotals *totals);
+void inventoryRecount(const Inventory *inv, InventoryTotals *totals);
+void inventorySetLowStock(Inventory *inv, int threshold);
+size_t inventoryRange(Inventory *inv, int column, int low, int high, size_t *slots, size_t max);
+size_t inventoryTop(Inventory *inv, int column, int highest, size_t k, size_t *slots);
+size_t inventorySearchName(Inventory *inv, const char *query, int prefixOnly, size_t *slots, size_t max);
+long long calculateStockValue(const Inventory *inv);
+long long calculateTotalSales(const Ledger *ledger);
+int inventorySaveText(const Inventory *inv, const char *path);
+int inventoryLoadText(Inventory *inv, const char *path, size_t *loaded);
+int inventoryLoadTextParallel(Inventory *inv, const char *path, int threads, size_t *loaded);
+int inventorySaveSnapshot(const Inventory *inv, const char *path, uint64_t walLsn);
+int inventoryLoadSnapshot(Inventory *inv, const char *path, size_t *loaded, uint64_t *walLsn);
+int inventorySaveCompressed(const Inventory *inv, const char *path);
+int inventoryLoadCompressed(Inventory *inv, const char *path, int threads, size_t *loaded);
+int walOpen(Wal *wal, const char *walPath, const char *checkpointPath);
+int walCommit(Wal *wal);
+void walClose(Wal *wal);
+int inventoryCheckpoint(Inventory *inv);
+int inventoryCommit(Inventory *inv);
+int inventoryRecover(Inventory *inv, Wal *wal, size_t *replayed);
+void ledgerInit(Ledger *ledger);
+int ledgerOpen(Ledger *ledger, const char *path);
+int ledgerSync(Ledger *ledger);
+void ledgerFree(Ledger *ledger);
+int cartAdd(Cart *cart, int id, int quantity);
+int32_t historyDay(int64_t time);
+int32_t historyDayFromDate(int year, int month, int day);
+void historyDate(int32_t day, int *year, int *month, int *dayOfMonth);
+void historyInit(SalesHistory *history);
+int historyOpen(SalesHistory *history, const char *dir);
+int historyRecord(SalesHistory *history, uint64_t bill, int64_t time, const SaleLine *lines, size_t count);
+int historySync(SalesHistory *history);
+void historyFree(SalesHistory *history);
+int ledgerAttachHistory(Ledger *ledger, SalesHistory *history);
+void historyProductSales(const SalesHistory *history, int id, int32_t from, int32_t to, ProductSales *sales);
+void historyTotals(const SalesHistory *history, int32_t from, int32_t to, ProductSales *sales);
+size_t historyTopSellers(const SalesHistory *history, int32_t from, int32_t to, int byRevenue, size_t k, ProductSales *top);
+void reorderInit(ReorderQueue *queue, int defaultPoint);
+int reorderAttach(ReorderQueue *queue, Inventory *inv);
+void reorderFree(ReorderQueue *queue);
+int reorderSetRule(Inventory *inv, int id, int point, int orderUnits);
+int reorderLoadRules(Inventory *inv, const char *path);
+int reorderSaveRules(const ReorderQueue *queue, const char *path);
+void reorderReplay(ReorderQueue *queue, const Ledger *ledger);
+size_t reorderDue(const ReorderQueue *queue, int64_t now, ReorderItem *items, size_t max);
+int reorderWritePurchaseOrder(const Inventory *inv, const char *path, int64_t now, size_t *lines, long long *totalCents);
+int inventoryCheckout(Inventory *inv, Ledger *ledger, const Cart *cart, const LedgerBill **bill, int *failedLine);
+int sharedInit(SharedInventory *shared, Inventory *inv, Ledger *ledger);
+void sharedDestroy(SharedInventory *shared);
+void sharedLock(SharedInventory *shared);
+void sharedUnlock(SharedInventory *shared);
+int sharedCheckout(SharedInventory *shared, const Cart *cart, LedgerBill *bill, int *failedLine);
+int sharedSaveText(SharedInventory *shared, const char *path);
+int chainInit(StoreChain *chain, int stores, int partitioned);
+int chainSetThreads(StoreChain *chain, int threads);
+void chainFree(StoreChain *chain);
+int chainStoreOf(const StoreChain *chain, int id);
+int chainAdd(StoreChain *chain, int store, int id, const char *name, int priceCents, int quantity);
+int chainSell(StoreChain *chain, int store, const Cart *cart, const LedgerBill **bill, int *failedLine);
+void chainTotals(StoreChain *chain, int recount, InventoryTotals *totals, long long *salesCents);
+size_t chainFind(StoreChain *chain, int id, ChainHit *hits, size_t max);
+size_t chainLowStock(StoreChain *chain, int threshold, ChainItem *items, size_t max);
+
+// Report rendering
+int reportOpen(Report *report, int fd, int format);
+void reportColumns(Report *report, int count, const char *const *titles, const int *widths);
+void reportText(Report *report, const char *text);
+void reportInt(Report *report, long long value);
+void reportCents(Report *report, long long cents);
+void reportEndRow(Report *report);
+int reportFlush(Report *report);
+int reportClose(Report *report);
+
+// Operation statistics
+int inventoryStatsRead(InventoryStats *stats);
+void inventoryStatsReset(void);
+uint64_t inventoryStatsPercentile(const OpStats *op, unsigned perMille);
+const char *inventoryStatName(int op);
+
+// Text parsing, name matching and money formatting
+const char *skipBlanks(const char *p, const char *end);
+const char *scanInt(const char *p, const char *end, int *value);
+const char *scanCents(const char *p, const char *end, int *cents);
+int parseCents(const char *text, int *cents);
+int parseRecordLine(const char *p, const char *end, Product *product);
+char *formatCents(long long cents, char *buf);
+int nameMatches(const char *name, const char *query, size_t length, int prefixOnly);
+
+// Stock valuation kernels, exposed for benchmarks
+long long valuationScalar(const int *priceCents, const int *quantities, size_t n);
+#ifdef HAVE_X86_SIMD
+long long valuationSse41(const int *priceCents, const int *quantities, size_t n);
+long long valuationAvx2(const int *priceCents, const int *quantities, size_t n);
+#endif
+
+#endif
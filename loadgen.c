@@ -0,0 +1,286 @@
+/**
+ * @file loadgen.c
+ * @brief Load generator: drives pipelined requests against a running socket server and
+ * reports throughput and latency.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "frontend.h"
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define LOADGEN_MAX_DEPTH 256
+#define LOADGEN_PRODUCTS 10000
+#define LOADGEN_FIRST_ID 900000001
+
+// One load generator connection and the send times of its requests still in flight
+typedef struct {
+    int fd;
+    unsigned char in[1 << 16];
+    size_t inUsed;
+    double sent[LOADGEN_MAX_DEPTH]; // ring of send times, oldest at head
+    int head;
+    int inFlight;
+    uint32_t nextTag;
+    uint32_t seed;
+} LoadgenConnection;
+
+/**
+ * @brief Connects to a server address, blocking.
+ *
+ * @param address A TCP port on 127.0.0.1 if it is all digits, otherwise a Unix socket path.
+ * @return Connected socket, or -1 on error.
+ */
+static int netConnect(const char *address) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    int family = netAddress(address, &storage, &length);
+    int fd = family < 0 ? -1 : socket(family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int on = 1;
+    if (family == AF_INET) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    if (connect(fd, (struct sockaddr *)&storage, length) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Writes a whole buffer to a blocking socket.
+ *
+ * @param fd Socket.
+ * @param data Bytes to write.
+ * @param length Number of bytes.
+ * @return 0 on success, -1 on error.
+ */
+static int netWriteAll(int fd, const unsigned char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return -1;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return 0;
+}
+
+/**
+ * @brief Appends the next load generator request for a connection to a buffer.
+ *
+ * While preparing, request n adds product LOADGEN_FIRST_ID + n. Otherwise requests are 60%
+ * searches, 20% updates, 15% bills of one to three products and 5% sales totals, over the
+ * products added while preparing.
+ *
+ * @param conn Pointer to the connection.
+ * @param buffer Output buffer with room for one request.
+ * @param n Request number, counted across connections.
+ * @param preparing Non-zero while adding the products.
+ * @return Request length.
+ */
+static size_t loadgenRequest(LoadgenConnection *conn, unsigned char *buffer, size_t n, int preparing) {
+    NetHeader header = {0, conn->nextTag++, 0, 0, 0};
+    unsigned char *body = buffer + sizeof(header);
+    Product product;
+    uint32_t roll = benchRandom(&conn->seed) % 100;
+    int32_t id = LOADGEN_FIRST_ID + (int32_t)(benchRandom(&conn->seed) % LOADGEN_PRODUCTS);
+
+    if (preparing || (roll >= 60 && roll < 80)) {
+        product.id = preparing ? LOADGEN_FIRST_ID + (int32_t)n : id;
+        snprintf(product.name, NAME_SIZE, "load%d", product.id - LOADGEN_FIRST_ID);
+        product.priceCents = 100 + product.id % 10000;
+        product.quantity = 1000000000;
+        header.op = preparing ? NET_ADD : NET_UPDATE;
+        header.length = (uint32_t)netPutProduct(body, &product);
+    } else if (roll < 60) {
+        header.op = NET_SEARCH;
+        memcpy(body, &id, sizeof(id));
+        header.length = sizeof(id);
+    } else if (roll < 95) {
+        int lines = 1 + (int)(benchRandom(&conn->seed) % 3);
+        header.op = NET_BILL;
+        for (int i = 0; i < lines; i++) {
+            int32_t line[2] = {LOADGEN_FIRST_ID + (int32_t)((id - LOADGEN_FIRST_ID + i) % LOADGEN_PRODUCTS), 1};
+            memcpy(body + 8 * i, line, sizeof(line));
+        }
+        header.length = (uint32_t)(8 * lines);
+    } else {
+        header.op = NET_TOTAL;
+    }
+    memcpy(buffer, &header, sizeof(header));
+    conn->sent[(conn->head + conn->inFlight) % LOADGEN_MAX_DEPTH] = nowSeconds();
+    conn->inFlight++;
+    return sizeof(header) + header.length;
+}
+
+/**
+ * @brief Drives a number of requests through the connections, keeping each one's pipeline full.
+ *
+ * @param conns Connections.
+ * @param connCount Number of connections.
+ * @param total Requests to make.
+ * @param depth Requests kept in flight per connection.
+ * @param preparing Non-zero to add the products instead of the measured mix.
+ * @param latencies Receives each request's latency in microseconds. May be NULL.
+ * @param errors Receives the number of replies that were not NET_OK.
+ * @return 0 on success, -1 on a connection error.
+ */
+static int loadgenRun(LoadgenConnection *conns, int connCount, size_t total, int depth, int preparing,
+                      double *latencies, size_t *errors) {
+    static unsigned char out[LOADGEN_MAX_DEPTH * (sizeof(NetHeader) + NET_MAX_BODY)];
+    struct pollfd fds[LOADGEN_MAX_DEPTH];
+    size_t issued = 0;
+    size_t done = 0;
+    *errors = 0;
+
+    for (int c = 0; c < connCount; c++) {
+        size_t length = 0;
+        while (conns[c].inFlight < depth && issued < total) {
+            length += loadgenRequest(&conns[c], out + length, issued++, preparing);
+        }
+        if (netWriteAll(conns[c].fd, out, length) != 0) {
+            return -1;
+        }
+        fds[c].fd = conns[c].fd;
+        fds[c].events = POLLIN;
+    }
+
+    while (done < total) {
+        if (poll(fds, (nfds_t)connCount, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        for (int c = 0; c < connCount; c++) {
+            LoadgenConnection *conn = &conns[c];
+            if (fds[c].revents == 0) {
+                continue;
+            }
+            ssize_t got = read(conn->fd, conn->in + conn->inUsed, sizeof(conn->in) - conn->inUsed);
+            if (got <= 0) {
+                return -1;
+            }
+            conn->inUsed += (size_t)got;
+
+            double now = nowSeconds();
+            size_t at = 0;
+            size_t length = 0;
+            NetHeader header;
+            while (conn->inUsed - at >= sizeof(header)) {
+                memcpy(&header, conn->in + at, sizeof(header));
+                if (conn->inUsed - at < sizeof(header) + header.length) {
+                    break;
+                }
+                at += sizeof(header) + header.length;
+                if (latencies != NULL) {
+                    latencies[done] = (now - conn->sent[conn->head]) * 1e6;
+                }
+                conn->head = (conn->head + 1) % LOADGEN_MAX_DEPTH;
+                conn->inFlight--;
+                done++;
+                if (header.status != NET_OK) {
+                    (*errors)++;
+                }
+                if (issued < total) {
+                    length += loadgenRequest(conn, out + length, issued++, preparing);
+                }
+            }
+            memmove(conn->in, conn->in + at, conn->inUsed - at);
+            conn->inUsed -= at;
+            if (length > 0 && netWriteAll(conn->fd, out, length) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Load generator for the socket server: reports throughput and latency percentiles.
+ *
+ * Usage: supermarket --loadgen <port|socket path> [connections] [requests] [depth]
+ * Adds LOADGEN_PRODUCTS products (already present ones are kept), then runs the request mix
+ * of loadgenRequest over the given number of connections, each keeping depth requests in flight.
+ *
+ * @param argc Number of load generator arguments.
+ * @param argv Load generator arguments.
+ * @return Process exit status.
+ */
+int runLoadgen(int argc, char *argv[]) {
+    if (argc < 1) {
+        printf("Usage: supermarket --loadgen <port|socket path> [connections] [requests] [depth]\n");
+        return 1;
+    }
+    int connCount = argc >= 2 ? atoi(argv[1]) : 8;
+    long requests = argc >= 3 ? atol(argv[2]) : 200000;
+    int depth = argc >= 4 ? atoi(argv[3]) : 16;
+    if (connCount < 1 || connCount > LOADGEN_MAX_DEPTH || requests < 1 || depth < 1 || depth > LOADGEN_MAX_DEPTH) {
+        printf("Connections and depth must be between 1 and %d, and requests at least 1.\n", LOADGEN_MAX_DEPTH);
+        return 1;
+    }
+
+    LoadgenConnection *conns = (LoadgenConnection *)calloc((size_t)connCount, sizeof(LoadgenConnection));
+    double *latencies = (double *)malloc((size_t)requests * sizeof(double));
+    int status = 1;
+    int opened = 0;
+    size_t errors = 0;
+    if (conns == NULL || latencies == NULL) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+    } else {
+        while (opened < connCount && (conns[opened].fd = netConnect(argv[0])) >= 0) {
+            conns[opened].seed = 0x9e3779b9u * (uint32_t)(opened + 1);
+            opened++;
+        }
+    }
+
+    if (conns != NULL && latencies != NULL && opened < connCount) {
+        printf(ANSI_COLOR_RED"Could not connect to %s.\n"ANSI_COLOR_RESET, argv[0]);
+    } else if (opened == connCount) {
+        double start = nowSeconds();
+        int lost = loadgenRun(conns, 1, LOADGEN_PRODUCTS, depth, 1, NULL, &errors) != 0;
+        if (!lost) {
+            start = nowSeconds();
+            lost = loadgenRun(conns, connCount, (size_t)requests, depth, 0, latencies, &errors) != 0;
+        }
+        if (lost) {
+            printf(ANSI_COLOR_RED"Connection lost.\n"ANSI_COLOR_RESET);
+        } else {
+            double seconds = nowSeconds() - start;
+            qsort(latencies, (size_t)requests, sizeof(double), compareDoubles);
+            printf("%ld requests over %d connections, %d in flight each (60%% search, 20%% update, 15%% bill, 5%% total)\n",
+                   requests, connCount, depth);
+            printf("%12s %12s %10s %10s %10s %8s\n", "seconds", "requests/s", "p50 us", "p99 us", "max us", "errors");
+            printf("%12.3f %12.0f %10.1f %10.1f %10.1f %8zu\n", seconds, requests / seconds, latencies[requests / 2],
+                   latencies[requests * 99 / 100], latencies[requests - 1], errors);
+            status = errors == 0 ? 0 : 1;
+        }
+    }
+
+    for (int i = 0; i < opened; i++) {
+        close(conns[i].fd);
+    }
+    free(conns);
+    free(latencies);
+    return status;
+}
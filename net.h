@@ -0,0 +1,48 @@
+/**
+ * @file net.h
+ * @brief Binary protocol of the socket server, shared by the server and the load generator.
+ */
+
+#ifndef NET_H
+#define NET_H
+
+#include "inventory.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+// Ops of the server's binary protocol
+#define NET_ADD    1 // body: product              -> empty
+#define NET_SEARCH 2 // body: int32 id             -> product
+#define NET_UPDATE 3 // body: product              -> empty
+#define NET_DELETE 4 // body: int32 id             -> empty
+#define NET_BILL   5 // body: (int32 id, int32 quantity) per line -> uint64 bill number, int64 total cents
+#define NET_TOTAL  6 // body: empty                -> int64 total sales cents
+
+// Response statuses; failed bills whose cause is a cart line reply with its int32 index
+#define NET_OK        0
+#define NET_NOT_FOUND 1
+#define NET_EXISTS    2
+#define NET_STOCK     3
+#define NET_INVALID   4
+#define NET_MEMORY    5
+
+#define NET_MAX_BODY 4096 // larger frames close the connection
+
+// Header of every request and response frame. Integers here and in bodies are in host byte
+// order, as client and server share the machine. A product body is int32 id, int32 price in
+// cents, int32 quantity, uint8 name length, then the name bytes.
+typedef struct {
+    uint32_t length;   // body bytes after the header
+    uint32_t tag;      // chosen by the client and echoed back, to match pipelined replies
+    uint8_t op;        // NET_ADD...; replies carry the request's op
+    uint8_t status;    // replies only
+    uint16_t reserved;
+} NetHeader;
+
+// Protocol helpers (server.c)
+int netAddress(const char *address, struct sockaddr_storage *storage, socklen_t *length);
+size_t netPutProduct(unsigned char *body, const Product *product);
+
+#endif
@@ -0,0 +1,556 @@
+/**
+ * @file server.c
+ * @brief Socket server: serves the inventory to POS clients over the binary protocol in net.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "frontend.h"
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define NET_MAX_PENDING (1 << 20)  // unsent reply bytes past which a connection's requests wait
+#define NET_MAX_EVENTS 64
+
+// One client connection of the server, with its unparsed requests and unsent replies
+typedef struct netConnection {
+    struct netConnection *prev; // list of open connections
+    struct netConnection *next;
+    int fd;
+    unsigned char *in;
+    size_t inUsed;
+    size_t inCapacity;
+    unsigned char *out;
+    size_t outUsed;
+    size_t outSent;
+    size_t outCapacity;
+    uint32_t events;   // epoll interest currently registered
+    int closing;       // peer hung up or broke the protocol; close once replies are sent
+} NetConnection;
+
+// Set by SIGINT or SIGTERM to stop the server loop
+static volatile sig_atomic_t serverStop = 0;
+
+/**
+ * @brief Signal handler that asks the server loop to stop.
+ *
+ * @param signal Signal number (unused).
+ */
+static void serverSignal(int signal) {
+    (void)signal;
+    serverStop = 1;
+}
+
+/**
+ * @brief Makes sure a byte buffer can hold at least a given number of bytes.
+ *
+ * @param buffer Pointer to the buffer pointer.
+ * @param capacity Pointer to the buffer capacity.
+ * @param needed Bytes the buffer must hold.
+ * @return 0 on success, -2 if memory allocation failed.
+ */
+static int netReserve(unsigned char **buffer, size_t *capacity, size_t needed) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    size_t grown = *capacity ? *capacity : 4096;
+    while (grown < needed) {
+        grown *= 2;
+    }
+    unsigned char *resized = (unsigned char *)realloc(*buffer, grown);
+    if (resized == NULL) {
+        return -2;
+    }
+    *buffer = resized;
+    *capacity = grown;
+    return 0;
+}
+
+/**
+ * @brief Encodes a product as a protocol product body.
+ *
+ * @param body Output buffer of at least 13 + NAME_SIZE bytes.
+ * @param product Product to encode.
+ * @return Body length.
+ */
+size_t netPutProduct(unsigned char *body, const Product *product) {
+    int32_t fields[3] = {product->id, product->priceCents, product->quantity};
+    size_t length = strlen(product->name);
+    memcpy(body, fields, sizeof(fields));
+    body[12] = (unsigned char)length;
+    memcpy(body + 13, product->name, length);
+    return 13 + length;
+}
+
+/**
+ * @brief Decodes a protocol product body; the name must be one word of printable characters.
+ *
+ * @param body Body bytes.
+ * @param length Body length.
+ * @param product Receives the product.
+ * @return 0 on success, -1 if the body is malformed.
+ */
+static int netGetProduct(const unsigned char *body, size_t length, Product *product) {
+    int32_t fields[3];
+    if (length < 14 || length != 13 + (size_t)body[12] || body[12] >= NAME_SIZE) {
+        return -1;
+    }
+    memcpy(fields, body, sizeof(fields));
+    for (size_t i = 13; i < length; i++) {
+        if (!isgraph(body[i])) {
+            return -1;
+        }
+    }
+    product->id = fields[0];
+    product->priceCents = fields[1];
+    product->quantity = fields[2];
+    memcpy(product->name, body + 13, body[12]);
+    product->name[body[12]] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Maps a library status code to a reply status.
+ *
+ * @param status INV_OK or an INV_ERR_* code.
+ * @return Reply status.
+ */
+static int netStatus(int status) {
+    switch (status) {
+        case INV_OK:
+            return NET_OK;
+        case INV_ERR_NOT_FOUND:
+            return NET_NOT_FOUND;
+        case INV_ERR_EXISTS:
+            return NET_EXISTS;
+        case INV_ERR_STOCK:
+            return NET_STOCK;
+        case INV_ERR_NOMEM:
+            return NET_MEMORY;
+        default:
+            return NET_INVALID;
+    }
+}
+
+/**
+ * @brief Runs one protocol request against the inventory.
+ *
+ * @param inv Pointer to the inventory.
+ * @param ledger Pointer to the sales ledger.
+ * @param op Request op.
+ * @param body Request body.
+ * @param length Request body length.
+ * @param reply Receives the reply body; at least 16 + NAME_SIZE bytes.
+ * @param replyLength Receives the reply body length.
+ * @param changed Set to 1 if the request changed the inventory or ledger.
+ * @return Reply status.
+ */
+static int netHandle(Inventory *inv, Ledger *ledger, int op, const unsigned char *body, size_t length,
+                     unsigned char *reply, size_t *replyLength, int *changed) {
+    Product product;
+    int32_t id;
+    int status;
+    *replyLength = 0;
+
+    switch (op) {
+        case NET_ADD:
+        case NET_UPDATE:
+            if (netGetProduct(body, length, &product) != 0) {
+                return NET_INVALID;
+            }
+            status = op == NET_ADD ? inv_add(inv, product.id, product.name, product.priceCents, product.quantity)
+                                   : inv_update(inv, product.id, product.name, product.priceCents, product.quantity);
+            if (status == INV_OK) {
+                *changed = 1;
+            }
+            return netStatus(status);
+        case NET_SEARCH:
+        case NET_DELETE:
+            if (length != sizeof(id)) {
+                return NET_INVALID;
+            }
+            memcpy(&id, body, sizeof(id));
+            status = op == NET_DELETE ? inv_delete(inv, id) : inv_find(inv, id, &product);
+            if (status == INV_OK && op == NET_DELETE) {
+                *changed = 1;
+            } else if (status == INV_OK) {
+                *replyLength = netPutProduct(reply, &product);
+            }
+            return netStatus(status);
+        case NET_BILL: {
+            Cart cart;
+            cart.count = 0;
+            if (length == 0 || length % 8 != 0 || length / 8 > CART_MAX_LINES) {
+                return NET_INVALID;
+            }
+            for (size_t i = 0; i < length; i += 8) {
+                int32_t line[2];
+                memcpy(line, body + i, sizeof(line));
+                if (cartAdd(&cart, line[0], line[1]) != INV_OK) {
+                    return NET_INVALID;
+                }
+            }
+            const LedgerBill *bill;
+            int32_t failedLine = 0;
+            status = inv_sell(inv, ledger, &cart, &bill, &failedLine);
+            if (status == INV_OK) {
+                int64_t total = bill->totalCents;
+                memcpy(reply, &bill->number, sizeof(bill->number));
+                memcpy(reply + 8, &total, sizeof(total));
+                *replyLength = 16;
+                *changed = 1;
+                return NET_OK;
+            }
+            if (status == INV_ERR_NOMEM) {
+                return NET_MEMORY;
+            }
+            memcpy(reply, &failedLine, sizeof(failedLine));
+            *replyLength = sizeof(failedLine);
+            return netStatus(status);
+        }
+        case NET_TOTAL: {
+            if (length != 0) {
+                return NET_INVALID;
+            }
+            int64_t total = calculateTotalSales(ledger);
+            memcpy(reply, &total, sizeof(total));
+            *replyLength = sizeof(total);
+            return NET_OK;
+        }
+        default:
+            return NET_INVALID;
+    }
+}
+
+/**
+ * @brief Answers every complete request in a connection's input, in order, until its unsent
+ * replies pass NET_MAX_PENDING.
+ *
+ * @param inv Pointer to the inventory.
+ * @param ledger Pointer to the sales ledger.
+ * @param conn Pointer to the connection.
+ * @param changed Set to 1 if a request changed the inventory or ledger.
+ */
+static void netProcess(Inventory *inv, Ledger *ledger, NetConnection *conn, int *changed) {
+    size_t at = 0;
+    unsigned char reply[16 + NAME_SIZE];
+    while (!conn->closing && conn->outUsed - conn->outSent < NET_MAX_PENDING && conn->inUsed - at >= sizeof(NetHeader)) {
+        NetHeader header;
+        memcpy(&header, conn->in + at, sizeof(header));
+        if (header.length > NET_MAX_BODY) {
+            conn->closing = 1;
+            break;
+        }
+        if (conn->inUsed - at < sizeof(header) + header.length) {
+            break;
+        }
+        size_t replyLength;
+        header.status = (uint8_t)netHandle(inv, ledger, header.op, conn->in + at + sizeof(header), header.length,
+                                           reply, &replyLength, changed);
+        at += sizeof(header) + header.length;
+        header.length = (uint32_t)replyLength;
+        if (netReserve(&conn->out, &conn->outCapacity, conn->outUsed + sizeof(header) + replyLength) != 0) {
+            conn->closing = 1;
+            break;
+        }
+        memcpy(conn->out + conn->outUsed, &header, sizeof(header));
+        memcpy(conn->out + conn->outUsed + sizeof(header), reply, replyLength);
+        conn->outUsed += sizeof(header) + replyLength;
+    }
+    memmove(conn->in, conn->in + at, conn->inUsed - at);
+    conn->inUsed -= at;
+}
+
+/**
+ * @brief Checks whether a connection's input holds a request netProcess can act on: a
+ * complete one, or a header announcing an oversized body.
+ *
+ * @param conn Pointer to the connection.
+ * @return 1 if it does, 0 otherwise.
+ */
+static int netHasRequest(const NetConnection *conn) {
+    NetHeader header;
+    if (conn->inUsed < sizeof(header)) {
+        return 0;
+    }
+    memcpy(&header, conn->in, sizeof(header));
+    return header.length > NET_MAX_BODY || conn->inUsed - sizeof(header) >= header.length;
+}
+
+/**
+ * @brief Reads everything a connection's socket has, without blocking.
+ *
+ * @param conn Pointer to the connection; marked closing on end of stream or error.
+ */
+static void netRead(NetConnection *conn) {
+    for (;;) {
+        if (netReserve(&conn->in, &conn->inCapacity, conn->inUsed + 4096) != 0) {
+            conn->closing = 1;
+            return;
+        }
+        ssize_t got = read(conn->fd, conn->in + conn->inUsed, conn->inCapacity - conn->inUsed);
+        if (got > 0) {
+            conn->inUsed += (size_t)got;
+        } else if (got < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                conn->closing = 1;
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Sends as many of a connection's replies as its socket takes, without blocking.
+ *
+ * @param conn Pointer to the connection; marked closing on error.
+ */
+static void netFlush(NetConnection *conn) {
+    while (conn->outSent < conn->outUsed) {
+        ssize_t sent = send(conn->fd, conn->out + conn->outSent, conn->outUsed - conn->outSent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn->outSent += (size_t)sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                conn->closing = 1;
+                conn->outSent = conn->outUsed;
+            }
+            break;
+        }
+    }
+    if (conn->outSent == conn->outUsed) {
+        conn->outSent = conn->outUsed = 0;
+    }
+}
+
+/**
+ * @brief Closes a connection, unlinks it from the open list and frees its buffers.
+ *
+ * @param open Pointer to the head of the list of open connections.
+ * @param conn Pointer to the connection.
+ */
+static void netClose(NetConnection **open, NetConnection *conn) {
+    if (conn->prev != NULL) {
+        conn->prev->next = conn->next;
+    } else {
+        *open = conn->next;
+    }
+    if (conn->next != NULL) {
+        conn->next->prev = conn->prev;
+    }
+    close(conn->fd);
+    free(conn->in);
+    free(conn->out);
+    free(conn);
+}
+
+/**
+ * @brief Resolves a server address.
+ *
+ * @param address A TCP port on 127.0.0.1 if it is all digits, otherwise a Unix socket path.
+ * @param storage Receives the socket address.
+ * @param length Receives the socket address length.
+ * @return AF_INET or AF_UNIX, or -1 if the path is too long.
+ */
+int netAddress(const char *address, struct sockaddr_storage *storage, socklen_t *length) {
+    memset(storage, 0, sizeof(*storage));
+    if (address[0] != '\0' && strspn(address, "0123456789") == strlen(address)) {
+        struct sockaddr_in *in = (struct sockaddr_in *)storage;
+        in->sin_family = AF_INET;
+        in->sin_port = htons((uint16_t)atoi(address));
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        *length = sizeof(*in);
+        return AF_INET;
+    }
+    struct sockaddr_un *un = (struct sockaddr_un *)storage;
+    if (strlen(address) >= sizeof(un->sun_path)) {
+        return -1;
+    }
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, address);
+    *length = sizeof(*un);
+    return AF_UNIX;
+}
+
+/**
+ * @brief Opens a non-blocking listening socket.
+ *
+ * @param address A TCP port on 127.0.0.1 if it is all digits, otherwise a Unix socket path.
+ * @return Listening socket, or -1 on error.
+ */
+static int netListen(const char *address) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    int family = netAddress(address, &storage, &length);
+    int fd = family < 0 ? -1 : socket(family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int on = 1;
+    if (family == AF_UNIX) {
+        unlink(address);
+    } else {
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    if (bind(fd, (struct sockaddr *)&storage, length) != 0 || listen(fd, SOMAXCONN) != 0 ||
+        fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Serves the inventory to POS clients over a socket until SIGINT or SIGTERM.
+ *
+ * One thread runs an epoll loop over every connection. Clients may pipeline requests: each
+ * wake-up answers every complete request received, commits the changes they made to the
+ * change log and sales ledger once, and only then sends the replies, so a reply is never
+ * sent for a change that could still be lost.
+ *
+ * @param inv Pointer to the inventory.
+ * @param ledger Pointer to the sales ledger.
+ * @param address A TCP port on 127.0.0.1 if it is all digits, otherwise a Unix socket path.
+ * @param status Stream for status messages.
+ * @return 0 on a clean stop, -1 if the server could not start or an I/O error stopped it.
+ */
+int runServer(Inventory *inv, Ledger *ledger, const char *address, FILE *status) {
+    int listener = netListen(address);
+    int ep = epoll_create1(0);
+    if (listener < 0 || ep < 0) {
+        fprintf(status, ANSI_COLOR_RED"Could not listen on %s.\n"ANSI_COLOR_RESET, address);
+        if (listener >= 0) {
+            close(listener);
+        }
+        if (ep >= 0) {
+            close(ep);
+        }
+        return -1;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(ep, EPOLL_CTL_ADD, listener, &event);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = serverSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    serverStop = 0;
+    fprintf(status, ANSI_COLOR_GREEN"Serving %zu products on %s.\n"ANSI_COLOR_RESET, inv->liveCount, address);
+
+    int result = 0;
+    NetConnection *open = NULL;
+    struct epoll_event events[NET_MAX_EVENTS];
+    NetConnection *touched[NET_MAX_EVENTS];
+    while (!serverStop) {
+        int ready = epoll_wait(ep, events, NET_MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            result = -1;
+            break;
+        }
+
+        int touchedCount = 0;
+        int changed = 0;
+        for (int i = 0; i < ready; i++) {
+            NetConnection *conn = (NetConnection *)events[i].data.ptr;
+            if (conn == NULL) {
+                int fd;
+                while ((fd = accept(listener, NULL, NULL)) >= 0) {
+                    int on = 1;
+                    conn = (NetConnection *)calloc(1, sizeof(NetConnection));
+                    if (conn == NULL || fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+                        free(conn);
+                        close(fd);
+                        continue;
+                    }
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // fails harmlessly on Unix sockets
+                    conn->fd = fd;
+                    conn->events = EPOLLIN;
+                    conn->next = open;
+                    if (open != NULL) {
+                        open->prev = conn;
+                    }
+                    open = conn;
+                    event.events = EPOLLIN;
+                    event.data.ptr = conn;
+                    if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &event) != 0) {
+                        netClose(&open, conn);
+                    }
+                }
+                continue;
+            }
+            if (conn->outUsed - conn->outSent < NET_MAX_PENDING) {
+                netRead(conn);
+            }
+            netProcess(inv, ledger, conn, &changed);
+            touched[touchedCount++] = conn;
+        }
+
+        // Group commit before any reply of this round goes out
+        if (changed && (inventoryCommit(inv) != INV_OK || ledgerSync(ledger) != INV_OK)) {
+            fprintf(status, ANSI_COLOR_RED"Could not write the change log or sales ledger; stopping.\n"ANSI_COLOR_RESET);
+            result = -1;
+            serverStop = 1;
+            for (int i = 0; i < touchedCount; i++) {
+                touched[i]->outSent = touched[i]->outUsed = 0;
+            }
+        }
+
+        for (int i = 0; i < touchedCount; i++) {
+            NetConnection *conn = touched[i];
+            netFlush(conn);
+            size_t pending = conn->outUsed - conn->outSent;
+            if (conn->closing && (pending == 0 || serverStop)) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, conn->fd, NULL);
+                netClose(&open, conn);
+                continue;
+            }
+            // Requests held back by NET_MAX_PENDING need no more input: keep EPOLLOUT (always
+            // ready on a writable socket) so they are answered next round
+            int held = !conn->closing && pending < NET_MAX_PENDING && netHasRequest(conn);
+            uint32_t wanted = (pending > 0 || held ? EPOLLOUT : 0) | (pending < NET_MAX_PENDING && !conn->closing ? EPOLLIN : 0);
+            if (wanted != conn->events) {
+                event.events = wanted;
+                event.data.ptr = conn;
+                epoll_ctl(ep, EPOLL_CTL_MOD, conn->fd, &event);
+                conn->events = wanted;
+            }
+        }
+    }
+
+    while (open != NULL) {
+        netClose(&open, open);
+    }
+    close(ep);
+    close(listener);
+    if (strspn(address, "0123456789") != strlen(address)) {
+        unlink(address);
+    }
+    return result;
+}
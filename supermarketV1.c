@@ -1,461 +1,1552 @@
-/**
- * @file SuperMarket_Management_System.c
- * @brief A simple inventory management system.
- *
- * This program allows users to manage a list of products in an inventory.
- * Users can add, view, delete, update, and search for products, generate bills,
- * calculate total sales, and backup/restore inventory data. It also includes
- * functionality for management information such as employee details and sales information.
- *
- * @author Sanjai Magilan.S
- * @date [7/4/2024]
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-// Define ANSI color codes for better visual presentation in the terminal
-#define ANSI_COLOR_RED     "\x1b[31m"
-#define ANSI_COLOR_GREEN   "\x1b[32m"
-#define ANSI_COLOR_YELLOW  "\x1b[33m"
-#define ANSI_COLOR_BLUE    "\x1b[34m"
-#define ANSI_COLOR_MAGENTA "\x1b[35m"
-#define ANSI_COLOR_CYAN    "\x1b[36m"
-#define ANSI_COLOR_RESET   "\x1b[0m"
-
-typedef struct {
-    int day, month, year;
-} Date;
-
-typedef struct {
-    int id;
-    char name[100];
-    float price;
-    int quantity;
-} Product;
-
-typedef struct node {
-    Product product;
-    struct node *next;
-} Node;
-
-// Function prototypes
-void addProduct(Node **head);
-void viewProducts(Node *head);
-void deleteProduct(Node **head, int id);
-void generateBill(Node *head);
-float calculateTotalSales(Node *head);
-void searchProduct(Node *head, int id);
-void updateProduct(Node *head, int id);
-void backupInventory(Node *head);
-void restoreInventory(Node **head);
-void emp();
-void sale();
-
-/**
- * @brief Adds a new product to the inventory.
- *
- * This function prompts the user to enter details of a new product and adds it to the inventory.
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- */
-void addProduct(Node **head) {
-    Node *newProduct = (Node *)malloc(sizeof(Node)); // Allocate memory for a new product
-    if (newProduct == NULL) { // Check if memory allocation was successful
-        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
-        return;
-    }
-
-    printf("Enter product ID: ");
-    scanf("%d", &newProduct->product.id); // Read product ID from user input
-    printf("Enter product name: ");
-    scanf("%s", newProduct->product.name); // Read product name from user input
-    printf("Enter product price: ");
-    scanf("%f", &newProduct->product.price); // Read product price from user input
-    printf("Enter product quantity: ");
-    scanf("%d", &newProduct->product.quantity); // Read product quantity from user input
-
-    newProduct->next = *head; // Set the next pointer of the new product to the current head
-    *head = newProduct; // Update the head pointer to point to the new product
-
-    printf("----------------------------------\n");
-    printf(ANSI_COLOR_GREEN "Product added successfully.\n" ANSI_COLOR_RESET);
-    printf("----------------------------------\n");
-}
-
-/**
- * @brief Displays all products in the inventory.
- *
- * This function displays the details of all products currently present in the inventory.
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- */
-void viewProducts(Node *head) {
-    if (head == NULL) {
-        printf("-------------------------------------\n");
-        printf(ANSI_COLOR_RED"Inventory is empty.\n"ANSI_COLOR_RESET);
-        printf("-------------------------------------\n");
-        return;
-    }
-
-    printf("-------------------------------------\n");
-    printf("Product ID\tName\tPrice\tQuantity\n");
-    while (head != NULL) {
-        printf("%d\t     \t%s\t%.2f\t%d\n", head->product.id, head->product.name, head->product.price, head->product.quantity);
-        head = head->next;
-    }
-    printf("\n");
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Deletes a product from the inventory based on its ID.
- *
- * This function allows the user to delete a product from the inventory based on its ID.
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- * @param id ID of the product to be deleted.
- */
-void deleteProduct(Node **head, int id) {
-    Node *temp = *head;
-    Node *prev = NULL;
-
-    while (temp != NULL && temp->product.id != id) {
-        prev = temp;
-        temp = temp->next;
-    }
-
-    if (temp == NULL) {
-        printf("-------------------------------------\n");
-        printf("Product with ID %d not found.\n", id);
-        printf("-------------------------------------\n");
-        return;
-    }
-
-    if (prev != NULL) {
-        prev->next = temp->next;
-    } else {
-        *head = temp->next;
-    }
-
-    free(temp);
-    printf("-------------------------------------\n");
-    printf(ANSI_COLOR_GREEN "Product with ID %d deleted successfully.\n" ANSI_COLOR_RESET, id);
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Generates a bill for the products in the inventory.
- *
- * This function calculates the total cost of products in the inventory and generates a bill.
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- */
-void generateBill(Node *head) {
-    if (head == NULL) {
-        printf("-------------------------------------\n");
-        printf(ANSI_COLOR_RED"Inventory is empty.\n"ANSI_COLOR_RESET);
-        printf("-------------------------------------\n");
-        return;
-    }
-
-    Date currentDate;
-    printf("Enter current date (dd mm yyyy): ");
-    scanf("%d %d %d", &currentDate.day, &currentDate.month, &currentDate.year);
-
-    printf("Bill generated on %d/%d/%d:\n", currentDate.day, currentDate.month, currentDate.year);
-    printf("*************************************\n");
-    printf("Product ID\tName\tPrice\tQuantity\n");
-    float total = 0.0;
-    while (head != NULL) {
-        printf("%d\t     \t%s\t%.2f\t%d\n", head->product.id, head->product.name, head->product.price, head->product.quantity);
-        total += head->product.price * head->product.quantity;
-        head = head->next;
-    }
-    printf("-------------------------------------\n");
-    printf("Total               %.2f\n", total);
-    printf("*************************************\n");
-}
-
-/**
- * @brief Calculates the total sales amount from all products in the inventory.
- *
- * This function calculates and returns the total sales amount from all products in the inventory.
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- * @return Total sales amount.
- */
-float calculateTotalSales(Node *head) {
-    float totalSales = 0;
-
-    while (head != NULL) {
-        totalSales += (head->product.price * head->product.quantity);
-        head = head->next;
-    }
-
-    return totalSales;
-}
-
-/**
- * @brief Searches for a product in the inventory based on its ID.
- *
- * This function allows the user to search for a product in the inventory based on its ID.
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- * @param id ID of the product to be searched.
- */
-void searchProduct(Node *head, int id) {
-    while (head != NULL) {
-        if (head->product.id == id) {
-            printf("-------------------------------------\n");
-            printf("Product found:\n");
-            printf("Product ID\tName\tPrice\tQuantity\n");
-            printf("%d\t     \t%s\t%.2f\t%d\n", head->product.id, head->product.name, head->product.price, head->product.quantity);
-            printf("-------------------------------------\n");
-            return;
-        }
-        head = head->next;
-    }
-    printf("-------------------------------------\n");
-    printf("Product with ID %d not found.\n", id);
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Updates the details of a product in the inventory based on its ID.
- *
- * This function allows the user to update the details (name, price, quantity) of a product in the inventory.
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- * @param id ID of the product to be updated.
- */
-void updateProduct(Node *head, int id) {
-    while (head != NULL) {
-        if (head->product.id == id) {
-            printf("-------------------------------------\n");
-            printf("Enter new product name: ");
-            scanf("%s", head->product.name);
-            printf("Enter new product price: ");
-            scanf("%f", &head->product.price);
-            printf("Enter new product quantity: ");
-            scanf("%d", &head->product.quantity);
-            printf("-------------------------------------\n");
-            printf(ANSI_COLOR_GREEN "Product details updated successfully.\n" ANSI_COLOR_RESET);
-            printf("-------------------------------------\n");
-            return;
-        }
-        head = head->next;
-    }
-    printf("-------------------------------------\n");
-    printf("Product with ID %d not found.\n", id);
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Creates a backup file of the inventory data.
- *
- * This function creates a backup file of the inventory data in a text file named "inventory_backup.txt".
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- */
-void backupInventory(Node *head) {
-    FILE *fp = fopen("inventory_backup.txt", "w");
-
-    if (fp == NULL) {
-        printf("-------------------------------------\n");
-        printf(ANSI_COLOR_BLUE"Error creating backup file.\n"ANSI_COLOR_RESET);
-        printf("-------------------------------------\n");
-        return;
-    }
-
-    while (head != NULL) {
-        fprintf(fp, "%d %s %.2f %d\n", head->product.id, head->product.name, head->product.price, head->product.quantity);
-        head = head->next;
-    }
-
-    fclose(fp);
-    printf("-------------------------------------\n");
-    printf(ANSI_COLOR_GREEN "Inventory backup created successfully.\n" ANSI_COLOR_RESET);
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Restores inventory data from a backup file.
- *
- * This function restores inventory data from a backup file named "inventory_backup.txt".
- *
- * @param head Pointer to the head of the linked list representing the inventory.
- */
-void restoreInventory(Node **head) {
-    FILE *fp = fopen("inventory_backup.txt", "r");
-    if (fp == NULL) {
-        printf(ANSI_COLOR_RED"Backup file not found.\n"ANSI_COLOR_RESET);
-        return;
-    }
-
-    Node *current = *head;
-    Node *prev = NULL;
-
-    while (current != NULL) {
-        prev = current;
-        current = current->next;
-        free(prev);
-    }
-
-    int id, quantity;
-    float price;
-    char name[100];
-    while (fscanf(fp, "%d %s %f %d", &id, name, &price, &quantity) != EOF) {
-        Node *newProduct = (Node *)malloc(sizeof(Node));
-        if (newProduct == NULL) {
-            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
-            return;
-        }
-        newProduct->product.id = id;
-        strcpy(newProduct->product.name, name);
-        newProduct->product.price = price;
-        newProduct->product.quantity = quantity;
-        newProduct->next = *head;
-        *head = newProduct;
-    }
-
-    fclose(fp);
-    printf("-------------------------------------\n");
-    printf(ANSI_COLOR_GREEN "Inventory restored successfully.\n" ANSI_COLOR_RESET);
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Displays employee information.
- *
- * This function displays information about employees, such as leave details.
- */
-void emp() {
-    printf("-------------------------------------\n");
-    printf("Employees leave\n");
-    for (int i = 1; i <= 10; i++) {
-        printf("no%d\tNo\n", i);
-    }
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Displays a message indicating a sale.
- *
- * This function displays a message indicating a sale.
- */
-void sale() {
-    printf(ANSI_COLOR_MAGENTA"\nAthula onnum illa keela potru!\n\n"ANSI_COLOR_RESET);
-    printf("-------------------------------------\n");
-}
-
-/**
- * @brief Main function.
- *
- * The main function for the inventory management system.
- */
-int main() {
-    Node *inventory = NULL;
-    int choice;
-
-    do {
-        printf("\n-- " ANSI_COLOR_CYAN "Inventory Management System" ANSI_COLOR_RESET " --\n");
-        printf(ANSI_COLOR_GREEN "1. Add Product\n");
-        printf("2. View Products\n");
-        printf("3. Delete Product\n");
-        printf("4. Generate Bill\n");
-        printf("5. Search Product\n");
-        printf("6. Update Product\n");
-        printf("7. Backup & Restore Inventory\n");
-        printf("8. Management Info\n");
-        printf("0. Exit\n" ANSI_COLOR_RESET);
-        printf("-------------------------------------\n");
-        printf("Enter your choice: ");
-        scanf("%d", &choice);
-        printf("-------------------------------------\n");
-
-        switch (choice) {
-            case 1:
-                addProduct(&inventory);
-                break;
-            case 2:
-                viewProducts(inventory);
-                break;
-            case 3:
-                printf("Enter product ID to delete: ");
-                int id;
-                scanf("%d", &id);
-                deleteProduct(&inventory, id);
-                break;
-            case 4:
-                generateBill(inventory);
-                break;
-            case 5:
-                printf("Enter product ID to search: ");
-                scanf("%d", &id);
-                searchProduct(inventory, id);
-                break;
-            case 6:
-                printf("Enter product ID to update: ");
-                scanf("%d", &id);
-                updateProduct(inventory, id);
-                break;
-            case 7:
-                printf(ANSI_COLOR_YELLOW"1. Backup Inventory\n");
-                printf("2. Restore Inventory\n"ANSI_COLOR_RESET);
-                printf("-------------------------------------\n");
-                printf("Enter your choice: ");
-                int zz;
-                scanf("%d", &zz);
-                printf("-------------------------------------\n");
-                switch(zz) {
-                    case 2:
-                        restoreInventory(&inventory);
-                        break;
-                    case 1:
-                        backupInventory(inventory);
-                        break;
-                }
-                break;
-            case 8:
-                printf("Enter password: ");
-                int pass;
-                scanf("%d",&pass);
-                if (pass == 189) {
-                    printf(ANSI_COLOR_GREEN"Access granted\n"ANSI_COLOR_RESET);
-                    printf("-------------------------------------\n");
-                    printf(ANSI_COLOR_YELLOW"1. Sales and Income\n");
-                    printf("2. Employees Details\n");
-                    printf("3. Total Sales\n"ANSI_COLOR_RESET);
-                    printf("-------------------------------------\n");
-                    printf("Enter your choice: ");
-                    int xx;
-                    scanf("%d", &xx);
-                    printf("-------------------------------------\n");
-
-                    switch(xx) {
-                        case 1:
-                            sale();
-                            break;
-                        case 2:
-                            emp();
-                            break;
-                        case 3:
-                            printf("Total Sales: %.2f\n", calculateTotalSales(inventory));
-                            break;
-                    }
-                }
-                else
-                    printf(ANSI_COLOR_RED"Password incorrect\n"ANSI_COLOR_RESET);
-                break;
-            case 0:
-                printf(ANSI_COLOR_RED "Exiting...\n" ANSI_COLOR_RESET);
-                break;
-            default:
-                printf(ANSI_COLOR_RED"Invalid choice. Please try again.\n"ANSI_COLOR_RESET);
-                break;
-        }
-    } while (choice != 0);
-    return 0;
-}
+/**
+ * @file SuperMarket_Management_System.c
+ * @brief A simple inventory management system.
+ *
+ * This program allows users to manage a list of products in an inventory.
+ * Users can add, view, delete, update, and search for products, generate bills,
+ * calculate total sales, and backup/restore inventory data. It also includes
+ * functionality for management information such as employee details and sales information.
+ * The inventory engine itself is the library in inventory.c; this file holds the menu, and
+ * batch.c, server.c, loadgen.c and bench.c hold batch mode, the socket server, the load
+ * generator and the benchmarks built on it.
+ *
+ * @author Sanjai Magilan.S
+ * @date [7/4/2024]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "frontend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef struct {
+    int day, month, year;
+} Date;
+
+#define BACKUP_FILE "inventory_backup.txt"
+#define COMPRESSED_FILE "inventory_backup.pak"
+
+// Parser threads used by text imports and compressed restores; 0 means one per online CPU. Set with --threads.
+static int loadThreads = 0;
+#define SNAPSHOT_FILE "inventory_snapshot.bin"
+#define WAL_FILE "inventory.wal"
+#define CHECKPOINT_FILE "inventory_checkpoint.bin"
+#define LEDGER_FILE "sales_ledger.txt"
+#define HISTORY_DIR "sales_history"
+#define PURCHASE_ORDER_FILE "purchase_order.csv"
+#define SALES_TOP_COUNT 5
+#define REPORT_PAGE_ROWS 40
+#define REPORT_CSV_FILE "inventory_report.csv"
+#define REPORT_TSV_FILE "inventory_report.tsv"
+#define STATS_FILE "inventory_stats.json"
+#define STATS_JSON_SIZE 8192
+
+// Where SIGUSR1 (and, with --stats, exit) writes the operation statistics as JSON
+static const char *statsPath = STATS_FILE;
+
+// Function prototypes
+void addProduct(Inventory *inv);
+void viewProducts(const Inventory *inv);
+void deleteProduct(Inventory *inv, int id);
+void generateBill(Inventory *inv, Ledger *ledger);
+void stockSummary(Inventory *inv);
+void searchProduct(const Inventory *inv, int id);
+void searchProductByName(Inventory *inv, const char *query, int prefixOnly);
+void updateProduct(Inventory *inv, int id);
+void stockQueries(Inventory *inv);
+void backupInventory(const Inventory *inv);
+void restoreInventory(Inventory *inv);
+void exportInventory(const Inventory *inv);
+void importInventory(Inventory *inv);
+void exportCompressed(const Inventory *inv);
+void importCompressed(Inventory *inv);
+void exportReport(const Inventory *inv, int format);
+void emp();
+void sale(const Inventory *inv, const Ledger *ledger);
+void salesHistory(const Inventory *inv, const SalesHistory *history);
+void operationStats(void);
+
+/**
+ * @brief Reads a price from standard input.
+ *
+ * @param cents Receives the price in cents.
+ * @return INV_OK on success, INV_ERR_INVALID if the input was not a valid price.
+ */
+static int readPrice(int *cents) {
+    char text[32];
+    if (scanf("%31s", text) != 1) {
+        return INV_ERR_INVALID;
+    }
+    return parseCents(text, cents);
+}
+
+/**
+ * @brief Reads a product name (one word) from standard input.
+ *
+ * At most NAME_SIZE - 1 characters are stored; the rest of a longer word is read and
+ * discarded so it cannot spill into the next prompt.
+ *
+ * @param name Buffer of NAME_SIZE bytes.
+ * @return 0 on success, -1 if the name was too long or missing.
+ */
+static int readName(char *name) {
+    name[0] = '\0';
+    if (scanf("%99s", name) != 1) {
+        return -1;
+    }
+    int next = getchar();
+    if (next == EOF || next == ' ' || next == '\t' || next == '\n' || next == '\r') {
+        return 0;
+    }
+    scanf("%*s");
+    return -1;
+}
+
+/**
+ * @brief Adds a new product to the inventory.
+ *
+ * This function prompts the user to enter details of a new product and adds it to the inventory.
+ * Product IDs must be unique.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void addProduct(Inventory *inv) {
+    Product product;
+
+    printf("Enter product ID: ");
+    scanf("%d", &product.id); // Read product ID from user input
+    printf("Enter product name: ");
+    int nameOk = readName(product.name); // Read product name from user input
+    printf("Enter product price: ");
+    int priceOk = readPrice(&product.priceCents); // Read product price from user input
+    printf("Enter product quantity: ");
+    scanf("%d", &product.quantity); // Read product quantity from user input
+
+    if (nameOk != 0) {
+        printf("----------------------------------\n");
+        printf(ANSI_COLOR_RED "Product names are limited to %d characters.\n" ANSI_COLOR_RESET, NAME_SIZE - 1);
+        printf("----------------------------------\n");
+        return;
+    }
+
+    if (priceOk != INV_OK) {
+        printf("----------------------------------\n");
+        printf(ANSI_COLOR_RED "Invalid price.\n" ANSI_COLOR_RESET);
+        printf("----------------------------------\n");
+        return;
+    }
+
+    int status = inv_add(inv, product.id, product.name, product.priceCents, product.quantity);
+    if (status == INV_ERR_EXISTS) { // IDs are the lookup key, so reject duplicates
+        printf("----------------------------------\n");
+        printf(ANSI_COLOR_RED "Product with ID %d already exists.\n" ANSI_COLOR_RESET, product.id);
+        printf("----------------------------------\n");
+        return;
+    }
+
+    if (status != INV_OK) { // Check if memory allocation was successful
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        return;
+    }
+
+    printf("----------------------------------\n");
+    printf(ANSI_COLOR_GREEN "Product added successfully.\n" ANSI_COLOR_RESET);
+    printf("----------------------------------\n");
+}
+
+/**
+ * @brief Renders every product, most recently added first, through a Report.
+ *
+ * Table names are padded to the longest name in the inventory so columns stay aligned.
+ *
+ * @param inv Pointer to the inventory.
+ * @param fd Descriptor to write to. Standard output is flushed first when it is fd 1.
+ * @param format REPORT_TABLE, REPORT_CSV or REPORT_TSV.
+ * @param pageRows Rows per page, after each of which the user presses Enter (q stops); 0 to
+ *        stream every row without stopping.
+ * @return Rows written, or -1 if memory allocation or a write failed.
+ */
+long long reportProducts(const Inventory *inv, int fd, int format, size_t pageRows) {
+    static const char *const titles[] = {"Product ID", "Name", "Price", "Quantity"};
+    Product product;
+    size_t cursor = 0;
+    int nameWidth = 0;
+    while (format == REPORT_TABLE && inv_next(inv, &cursor, &product)) {
+        int length = (int)strlen(product.name);
+        if (length > nameWidth) {
+            nameWidth = length;
+        }
+    }
+    const int widths[] = {10, -nameWidth, 12, 10};
+
+    Report report;
+    if (reportOpen(&report, fd, format) != INV_OK) {
+        return -1;
+    }
+    if (fd == STDOUT_FILENO) {
+        fflush(stdout);
+    }
+    reportColumns(&report, 4, titles, widths);
+    cursor = 0;
+    while (inv_next(inv, &cursor, &product)) {
+        reportInt(&report, product.id);
+        reportText(&report, product.name);
+        reportCents(&report, product.priceCents);
+        reportInt(&report, product.quantity);
+        reportEndRow(&report);
+        if (pageRows > 0 && report.rows % pageRows == 0 && report.rows < inv->liveCount) {
+            char answer[16];
+            reportFlush(&report);
+            printf(ANSI_COLOR_YELLOW"-- %zu of %zu: Enter for more, q to stop --"ANSI_COLOR_RESET, report.rows, inv->liveCount);
+            fflush(stdout);
+            if (fgets(answer, sizeof(answer), stdin) == NULL || answer[0] == 'q') {
+                break;
+            }
+        }
+    }
+    size_t rows = report.rows;
+    return reportClose(&report) == INV_OK ? (long long)rows : -1;
+}
+
+/**
+ * @brief Displays all products in the inventory.
+ *
+ * This function displays the details of all products currently present in the inventory,
+ * most recently added first.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void viewProducts(const Inventory *inv) {
+    if (inv->liveCount == 0) {
+        printf("-------------------------------------\n");
+        printf(ANSI_COLOR_RED"Inventory is empty.\n"ANSI_COLOR_RESET);
+        printf("-------------------------------------\n");
+        return;
+    }
+
+    printf("-------------------------------------\n");
+    // Page through a terminal; stream everything in one go when input or output is redirected
+    int paged = isatty(STDIN_FILENO) && isatty(STDOUT_FILENO);
+    if (paged) {
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF) { // drop the rest of the menu choice's line
+        }
+    }
+    if (reportProducts(inv, STDOUT_FILENO, REPORT_TABLE, paged ? REPORT_PAGE_ROWS : 0) < 0) {
+        printf(ANSI_COLOR_RED"Could not write the product list.\n"ANSI_COLOR_RESET);
+    }
+    printf("\n");
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Deletes a product from the inventory based on its ID.
+ *
+ * This function allows the user to delete a product from the inventory based on its ID.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id ID of the product to be deleted.
+ */
+void deleteProduct(Inventory *inv, int id) {
+    if (inv_delete(inv, id) == INV_ERR_NOT_FOUND) {
+        printf("-------------------------------------\n");
+        printf("Product with ID %d not found.\n", id);
+        printf("-------------------------------------\n");
+        return;
+    }
+
+    printf("-------------------------------------\n");
+    printf(ANSI_COLOR_GREEN "Product with ID %d deleted successfully.\n" ANSI_COLOR_RESET, id);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Bills a customer.
+ *
+ * This function reads the customer's items into a cart, then sells the whole cart at once:
+ * prices come from the inventory, the units are taken out of stock, and the bill is added to
+ * the sales ledger. If any item is short of stock nothing is sold.
+ *
+ * @param inv Pointer to the inventory.
+ * @param ledger Pointer to the sales ledger.
+ */
+void generateBill(Inventory *inv, Ledger *ledger) {
+    Cart cart;
+    cart.count = 0;
+    char price[CENTS_BUF_SIZE];
+
+    printf("Enter each item's product ID and quantity; ID 0 finishes the bill, -1 cancels it.\n");
+    for (;;) {
+        int id, quantity;
+        printf("Product ID: ");
+        if (scanf("%d", &id) != 1 || id == -1) {
+            printf(ANSI_COLOR_RED"Bill cancelled.\n"ANSI_COLOR_RESET);
+            return;
+        }
+        if (id == 0) {
+            break;
+        }
+        Product product;
+        if (inv_find(inv, id, &product) != INV_OK) {
+            printf(ANSI_COLOR_RED"Product with ID %d not found.\n"ANSI_COLOR_RESET, id);
+            continue;
+        }
+        printf("Quantity of %s (%s each, %d in stock): ", product.name, formatCents(product.priceCents, price), product.quantity);
+        if (scanf("%d", &quantity) != 1 || cartAdd(&cart, id, quantity) != INV_OK) {
+            printf(ANSI_COLOR_RED"Invalid quantity, or the bill already has %d items.\n"ANSI_COLOR_RESET, CART_MAX_LINES);
+        }
+    }
+    printf("-------------------------------------\n");
+    if (cart.count == 0) {
+        printf("No items; nothing billed.\n");
+        printf("-------------------------------------\n");
+        return;
+    }
+
+    const LedgerBill *bill;
+    int failedLine = 0;
+    int status = inventoryCheckout(inv, ledger, &cart, &bill, &failedLine);
+    if (status == INV_ERR_STOCK) {
+        Product product;
+        inv_find(inv, cart.lines[failedLine].id, &product);
+        printf(ANSI_COLOR_RED"Not enough %s in stock (%d wanted, %d left). Nothing was billed.\n"ANSI_COLOR_RESET,
+               product.name, cart.lines[failedLine].quantity, product.quantity);
+        return;
+    }
+    if (status != INV_OK) {
+        printf(ANSI_COLOR_RED"Could not complete the bill. Nothing was billed.\n"ANSI_COLOR_RESET);
+        return;
+    }
+
+    time_t now = (time_t)bill->time;
+    struct tm local;
+    localtime_r(&now, &local);
+    Date currentDate = {local.tm_mday, local.tm_mon + 1, local.tm_year + 1900};
+    printf("Bill #%llu generated on %d/%d/%d:\n", (unsigned long long)bill->number, currentDate.day, currentDate.month, currentDate.year);
+    printf("*************************************\n");
+    static const char *const titles[] = {"Product ID", "Name", "Price", "Quantity", "Amount"};
+    int nameWidth = 0;
+    for (size_t i = 0; i < bill->lineCount; i++) {
+        int length = (int)strlen(inventoryName(inv, inventoryFind(inv, ledger->lines[bill->firstLine + i].id)));
+        nameWidth = length > nameWidth ? length : nameWidth;
+    }
+    const int widths[] = {10, -nameWidth, 10, 8, 12};
+    Report report;
+    if (reportOpen(&report, STDOUT_FILENO, REPORT_TABLE) == INV_OK) {
+        fflush(stdout);
+        reportColumns(&report, 5, titles, widths);
+        for (size_t i = 0; i < bill->lineCount; i++) {
+            const SaleLine *line = &ledger->lines[bill->firstLine + i];
+            reportInt(&report, line->id);
+            reportText(&report, inventoryName(inv, inventoryFind(inv, line->id)));
+            reportCents(&report, line->priceCents);
+            reportInt(&report, line->quantity);
+            reportCents(&report, (long long)line->priceCents * line->quantity);
+            reportEndRow(&report);
+        }
+        reportClose(&report);
+    }
+    printf("-------------------------------------\n");
+    printf("Total               %s\n", formatCents(bill->totalCents, price));
+    printf("*************************************\n");
+}
+
+/**
+ * @brief Displays the stock summary: value, units, products and how many are low on stock.
+ *
+ * Every figure comes from the running totals, so this takes constant time.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void stockSummary(Inventory *inv) {
+    InventoryTotals totals;
+    char value[CENTS_BUF_SIZE];
+    inventoryTotals(inv, &totals);
+    printf("Stock value:        %s\n", formatCents(totals.stockValueCents, value));
+    printf("Units in stock:     %lld\n", totals.units);
+    printf("Products:           %zu\n", totals.skus);
+    printf("Low on stock:       %zu (below %d)\n", totals.lowStock, inv->lowStockThreshold);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Prints the products in a list of store slots as a table.
+ *
+ * @param inv Pointer to the inventory.
+ * @param slots Store slots to print.
+ * @param n Number of slots.
+ */
+static void printSlots(const Inventory *inv, const size_t *slots, size_t n) {
+    printf("-------------------------------------\n");
+    if (n == 0) {
+        printf("No matching products.\n");
+        printf("-------------------------------------\n");
+        return;
+    }
+    printf("Product ID\tName\tPrice\tQuantity\n");
+    char price[CENTS_BUF_SIZE];
+    Product product;
+    for (size_t i = 0; i < n; i++) {
+        inventoryGet(inv, slots[i], &product);
+        printf("%d\t     \t%s\t%s\t%d\n", product.id, product.name, formatCents(product.priceCents, price), product.quantity);
+    }
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Searches for a product in the inventory based on its ID.
+ *
+ * This function allows the user to search for a product in the inventory based on its ID.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id ID of the product to be searched.
+ */
+void searchProduct(const Inventory *inv, int id) {
+    Product product;
+    if (inv_find(inv, id, &product) == INV_OK) {
+        printf("-------------------------------------\n");
+        printf("Product found:\n");
+        char price[CENTS_BUF_SIZE];
+        printf("Product ID\tName\tPrice\tQuantity\n");
+        printf("%d\t     \t%s\t%s\t%d\n", product.id, product.name, formatCents(product.priceCents, price), product.quantity);
+        printf("-------------------------------------\n");
+        return;
+    }
+    printf("-------------------------------------\n");
+    printf("Product with ID %d not found.\n", id);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Searches for products in the inventory by name.
+ *
+ * This function lists the products whose names contain (or start with) the given text,
+ * ignoring case, oldest first. At most NAME_SEARCH_LIMIT matches are printed.
+ *
+ * @param inv Pointer to the inventory.
+ * @param query Text to look for.
+ * @param prefixOnly Non-zero to match only names starting with query.
+ */
+void searchProductByName(Inventory *inv, const char *query, int prefixOnly) {
+    size_t slots[NAME_SEARCH_LIMIT];
+    size_t found = inventorySearchName(inv, query, prefixOnly, slots, NAME_SEARCH_LIMIT);
+    if (found == NO_SLOT) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    printSlots(inv, slots, found < NAME_SEARCH_LIMIT ? found : NAME_SEARCH_LIMIT);
+    if (found > NAME_SEARCH_LIMIT) {
+        printf("More products match. Type more of the name to narrow the search.\n");
+        printf("-------------------------------------\n");
+    }
+}
+
+/**
+ * @brief Updates the details of a product in the inventory based on its ID.
+ *
+ * This function allows the user to update the details (name, price, quantity) of a product in the inventory.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id ID of the product to be updated.
+ */
+void updateProduct(Inventory *inv, int id) {
+    if (inventoryFind(inv, id) != NO_SLOT) {
+        Product product;
+        product.id = id;
+        printf("-------------------------------------\n");
+        printf("Enter new product name: ");
+        int nameOk = readName(product.name);
+        printf("Enter new product price: ");
+        int priceOk = readPrice(&product.priceCents);
+        printf("Enter new product quantity: ");
+        scanf("%d", &product.quantity);
+        printf("-------------------------------------\n");
+        if (nameOk != 0) {
+            printf(ANSI_COLOR_RED "Product names are limited to %d characters.\n" ANSI_COLOR_RESET, NAME_SIZE - 1);
+            printf("-------------------------------------\n");
+            return;
+        }
+        if (priceOk != INV_OK) {
+            printf(ANSI_COLOR_RED "Invalid price.\n" ANSI_COLOR_RESET);
+            printf("-------------------------------------\n");
+            return;
+        }
+        if (inv_update(inv, id, product.name, product.priceCents, product.quantity) != INV_OK) {
+            printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+            return;
+        }
+        printf(ANSI_COLOR_GREEN "Product details updated successfully.\n" ANSI_COLOR_RESET);
+        printf("-------------------------------------\n");
+        return;
+    }
+    printf("-------------------------------------\n");
+    printf("Product with ID %d not found.\n", id);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Lists the products due for reordering, fewest days of cover first.
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void reorderList(const Inventory *inv) {
+    if (inv->reorder == NULL) {
+        printf(ANSI_COLOR_RED"Reordering is off.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    printf("How many products: ");
+    int k;
+    if (scanf("%d", &k) != 1 || k <= 0) {
+        return;
+    }
+    ReorderItem *items = (ReorderItem *)malloc((size_t)k * sizeof(ReorderItem));
+    if (items == NULL) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    size_t found = reorderDue(inv->reorder, (int64_t)time(NULL), items, (size_t)k);
+    printf("-------------------------------------\n");
+    if (found == 0) {
+        printf("Nothing to reorder.\n");
+    } else {
+        printf("Product ID\tName\tStock\tPoint\tPer Day\tDays Left\tOrder\n");
+    }
+    for (size_t i = 0; i < found; i++) {
+        printf("%d\t     \t%s\t%d\t%d\t%.2f\t", items[i].id, inventoryName(inv, inventoryFind(inv, items[i].id)),
+               items[i].quantity, items[i].point, items[i].dailyDemand);
+        if (isinf(items[i].daysOfCover)) {
+            printf("-\t\t%d\n", items[i].orderUnits);
+        } else {
+            printf("%.1f\t\t%d\n", items[i].daysOfCover, items[i].orderUnits);
+        }
+    }
+    printf("-------------------------------------\n");
+    free(items);
+}
+
+/**
+ * @brief Sets a product's reorder point and order size, and saves the rules when changes are
+ * being kept.
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void setReorderPoint(Inventory *inv) {
+    int id, point, units;
+    printf("Enter product ID: ");
+    scanf("%d", &id);
+    printf("Reorder at or below how many units: ");
+    scanf("%d", &point);
+    printf("Units to order (0 to size from demand): ");
+    scanf("%d", &units);
+    switch (reorderSetRule(inv, id, point, units)) {
+        case INV_OK:
+            if (inv->wal != NULL && reorderSaveRules(inv->reorder, REORDER_FILE) != INV_OK) {
+                printf(ANSI_COLOR_RED"Could not save the reorder rules.\n"ANSI_COLOR_RESET);
+            } else {
+                printf(ANSI_COLOR_GREEN"Reorder point set.\n"ANSI_COLOR_RESET);
+            }
+            break;
+        case INV_ERR_NOT_FOUND:
+            printf(ANSI_COLOR_RED"Product with ID %d not found.\n"ANSI_COLOR_RESET, id);
+            break;
+        default:
+            printf(ANSI_COLOR_RED"Invalid reorder point or order size.\n"ANSI_COLOR_RESET);
+    }
+}
+
+/**
+ * @brief Writes one purchase order for every product due for reordering, to "purchase_order.csv".
+ *
+ * @param inv Pointer to the inventory.
+ */
+static void writePurchaseOrder(const Inventory *inv) {
+    size_t lines;
+    long long total;
+    char amount[CENTS_BUF_SIZE];
+    if (reorderWritePurchaseOrder(inv, PURCHASE_ORDER_FILE, (int64_t)time(NULL), &lines, &total) != INV_OK) {
+        printf(ANSI_COLOR_RED"Could not write the purchase order.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    printf(ANSI_COLOR_GREEN"Ordered %zu products for %s in " PURCHASE_ORDER_FILE ".\n"ANSI_COLOR_RESET, lines, formatCents(total, amount));
+}
+
+/**
+ * @brief Answers price-band, low-stock and top-K questions from the ordered indexes, and
+ * reorder questions from the reorder queue.
+ *
+ * This function asks which query to run and prints the matching products, without scanning
+ * the whole inventory.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void stockQueries(Inventory *inv) {
+    printf(ANSI_COLOR_YELLOW"1. Products in a Price Range\n");
+    printf("2. Low Stock Products\n");
+    printf("3. Most Expensive Products\n");
+    printf("4. Lowest Stock Products\n");
+    printf("5. Reorder List\n");
+    printf("6. Set Reorder Point\n");
+    printf("7. Write Purchase Order\n"ANSI_COLOR_RESET);
+    printf("-------------------------------------\n");
+    printf("Enter your choice: ");
+    int choice;
+    scanf("%d", &choice);
+    printf("-------------------------------------\n");
+    if (choice == 5) {
+        reorderList(inv);
+        return;
+    }
+    if (choice == 6) {
+        setReorderPoint(inv);
+        return;
+    }
+    if (choice == 7) {
+        writePurchaseOrder(inv);
+        return;
+    }
+
+    size_t *slots = (size_t *)malloc((inv->liveCount ? inv->liveCount : 1) * sizeof(size_t));
+    if (slots == NULL) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    size_t found = 0;
+    int low, high, k;
+    switch (choice) {
+        case 1:
+            printf("Enter lowest price: ");
+            int lowOk = readPrice(&low);
+            printf("Enter highest price: ");
+            int highOk = readPrice(&high);
+            if (lowOk != INV_OK || highOk != INV_OK) {
+                printf(ANSI_COLOR_RED "Invalid price.\n" ANSI_COLOR_RESET);
+                free(slots);
+                return;
+            }
+            found = inventoryRange(inv, ORDER_PRICE, low, high, slots, inv->liveCount);
+            break;
+        case 2:
+            printf("Show products with quantity below: ");
+            scanf("%d", &high);
+            found = high == INT_MIN ? 0 : inventoryRange(inv, ORDER_QUANTITY, INT_MIN, high - 1, slots, inv->liveCount);
+            break;
+        case 3:
+        case 4:
+            printf("How many products: ");
+            scanf("%d", &k);
+            if (k < 0) {
+                k = 0;
+            }
+            found = inventoryTop(inv, choice == 3 ? ORDER_PRICE : ORDER_QUANTITY, choice == 3,
+                                 (size_t)k < inv->liveCount ? (size_t)k : inv->liveCount, slots);
+            break;
+        default:
+            printf("Invalid choice.\n");
+            free(slots);
+            return;
+    }
+
+    if (found == NO_SLOT) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+    } else {
+        printSlots(inv, slots, found);
+    }
+    free(slots);
+}
+
+/**
+ * @brief Creates a backup file of the inventory data.
+ *
+ * This function creates a binary snapshot of the inventory data in a file named "inventory_snapshot.bin".
+ *
+ * @param inv Pointer to the inventory.
+ */
+void backupInventory(const Inventory *inv) {
+    if (inventorySaveSnapshot(inv, SNAPSHOT_FILE, 0) != INV_OK) {
+        printf("-------------------------------------\n");
+        printf(ANSI_COLOR_BLUE"Error creating backup file.\n"ANSI_COLOR_RESET);
+        printf("-------------------------------------\n");
+        return;
+    }
+
+    printf("-------------------------------------\n");
+    printf(ANSI_COLOR_GREEN "Inventory backup created successfully.\n" ANSI_COLOR_RESET);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Restores inventory data from a backup file.
+ *
+ * This function restores inventory data from the binary snapshot "inventory_snapshot.bin".
+ * A corrupt snapshot is rejected and leaves the inventory unchanged. The restored inventory
+ * is checkpointed so the change log starts over from it.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void restoreInventory(Inventory *inv) {
+    int status = inventoryLoadSnapshot(inv, SNAPSHOT_FILE, NULL, NULL);
+    if (status == INV_ERR_IO) {
+        printf(ANSI_COLOR_RED"Backup file not found.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    if (status == INV_ERR_NOMEM) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    if (status == INV_ERR_INVALID) {
+        printf(ANSI_COLOR_RED"Backup file is corrupt.\n"ANSI_COLOR_RESET);
+        return;
+    }
+
+    if (inventoryCheckpoint(inv) != INV_OK) {
+        printf(ANSI_COLOR_RED"Warning: the restored inventory could not be saved to the change log.\n"ANSI_COLOR_RESET);
+    }
+
+    printf("-------------------------------------\n");
+    printf(ANSI_COLOR_GREEN "Inventory restored successfully.\n" ANSI_COLOR_RESET);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Exports the inventory data as text.
+ *
+ * This function writes the inventory data to a text file named "inventory_backup.txt".
+ *
+ * @param inv Pointer to the inventory.
+ */
+void exportInventory(const Inventory *inv) {
+    if (inventorySaveText(inv, BACKUP_FILE) != INV_OK) {
+        printf("-------------------------------------\n");
+        printf(ANSI_COLOR_BLUE"Error creating export file.\n"ANSI_COLOR_RESET);
+        printf("-------------------------------------\n");
+        return;
+    }
+
+    printf("-------------------------------------\n");
+    printf(ANSI_COLOR_GREEN "Inventory exported successfully.\n" ANSI_COLOR_RESET);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Imports inventory data from a text export.
+ *
+ * This function replaces the inventory with the contents of "inventory_backup.txt".
+ * With more than one parser thread configured the file is parsed in parallel. The imported
+ * inventory is checkpointed so the change log starts over from it.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void importInventory(Inventory *inv) {
+    int threads = loadThreads > 0 ? loadThreads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    size_t records = 0;
+    double start = nowSeconds();
+    int status = threads > 1 ? inventoryLoadTextParallel(inv, BACKUP_FILE, threads, &records)
+                             : inventoryLoadText(inv, BACKUP_FILE, &records);
+    double seconds = nowSeconds() - start;
+    if (status == INV_ERR_IO) {
+        printf(ANSI_COLOR_RED"Export file not found.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    if (status == INV_ERR_NOMEM) {
+        printf(ANSI_COLOR_RED"Memory allocation failed. Inventory left unchanged.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    if (status == INV_ERR_INVALID) {
+        printf(ANSI_COLOR_RED"Export file has an overlong line. Inventory left unchanged.\n"ANSI_COLOR_RESET);
+        return;
+    }
+
+    if (inventoryCheckpoint(inv) != INV_OK) {
+        printf(ANSI_COLOR_RED"Warning: the imported inventory could not be saved to the change log.\n"ANSI_COLOR_RESET);
+    }
+
+    printf("-------------------------------------\n");
+    printf(ANSI_COLOR_GREEN "Inventory imported successfully.\n" ANSI_COLOR_RESET);
+    printf("%zu records in %.3f s (%.0f records/sec)\n", records, seconds, seconds > 0 ? records / seconds : 0.0);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Writes a compressed backup of the inventory.
+ *
+ * This function writes the inventory to "inventory_backup.pak", a compressed binary backup
+ * that is several times smaller than the text export and loads faster.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void exportCompressed(const Inventory *inv) {
+    double start = nowSeconds();
+    int status = inventorySaveCompressed(inv, COMPRESSED_FILE);
+    double seconds = nowSeconds() - start;
+    printf("-------------------------------------\n");
+    if (status != INV_OK) {
+        printf(ANSI_COLOR_BLUE"Error creating compressed backup.\n"ANSI_COLOR_RESET);
+        printf("-------------------------------------\n");
+        return;
+    }
+    struct stat st;
+    printf(ANSI_COLOR_GREEN "Compressed backup created successfully.\n" ANSI_COLOR_RESET);
+    printf("%zu products, %lld bytes in %.3f s\n", inv->liveCount, stat(COMPRESSED_FILE, &st) == 0 ? (long long)st.st_size : 0LL, seconds);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Restores the inventory from a compressed backup.
+ *
+ * This function replaces the inventory with the contents of "inventory_backup.pak", decoding
+ * its blocks on the configured number of threads. A corrupt backup leaves the inventory
+ * unchanged. The restored inventory is checkpointed so the change log starts over from it.
+ *
+ * @param inv Pointer to the inventory.
+ */
+void importCompressed(Inventory *inv) {
+    int threads = loadThreads > 0 ? loadThreads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    size_t records = 0;
+    double start = nowSeconds();
+    int status = inventoryLoadCompressed(inv, COMPRESSED_FILE, threads, &records);
+    double seconds = nowSeconds() - start;
+    if (status == INV_ERR_IO) {
+        printf(ANSI_COLOR_RED"Compressed backup not found.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    if (status == INV_ERR_NOMEM) {
+        printf(ANSI_COLOR_RED"Memory allocation failed. Inventory left unchanged.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    if (status == INV_ERR_INVALID) {
+        printf(ANSI_COLOR_RED"Compressed backup is corrupt. Inventory left unchanged.\n"ANSI_COLOR_RESET);
+        return;
+    }
+
+    if (inventoryCheckpoint(inv) != INV_OK) {
+        printf(ANSI_COLOR_RED"Warning: the restored inventory could not be saved to the change log.\n"ANSI_COLOR_RESET);
+    }
+
+    printf("-------------------------------------\n");
+    printf(ANSI_COLOR_GREEN "Inventory restored successfully.\n" ANSI_COLOR_RESET);
+    printf("%zu records in %.3f s (%.0f records/sec)\n", records, seconds, seconds > 0 ? records / seconds : 0.0);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Exports the product list as a CSV or TSV report for spreadsheets.
+ *
+ * @param inv Pointer to the inventory.
+ * @param format REPORT_CSV or REPORT_TSV.
+ */
+void exportReport(const Inventory *inv, int format) {
+    const char *path = format == REPORT_CSV ? REPORT_CSV_FILE : REPORT_TSV_FILE;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    double start = nowSeconds();
+    long long rows = fd >= 0 ? reportProducts(inv, fd, format, 0) : -1;
+    double seconds = nowSeconds() - start;
+    if (fd >= 0 && close(fd) != 0) {
+        rows = -1;
+    }
+    printf("-------------------------------------\n");
+    if (rows < 0) {
+        printf(ANSI_COLOR_RED"Could not write %s.\n"ANSI_COLOR_RESET, path);
+    } else {
+        printf(ANSI_COLOR_GREEN"Report written to %s.\n"ANSI_COLOR_RESET, path);
+        printf("%lld rows in %.3f s (%.0f rows/sec)\n", rows, seconds, seconds > 0 ? rows / seconds : 0.0);
+    }
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Displays employee information.
+ *
+ * This function displays information about employees, such as leave details.
+ */
+void emp() {
+    printf("-------------------------------------\n");
+    printf("Employees leave\n");
+    for (int i = 1; i <= 10; i++) {
+        printf("no%d\tNo\n", i);
+    }
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Names a product sold in the past, which may since have been deleted.
+ *
+ * @param inv Pointer to the inventory.
+ * @param id Product ID.
+ * @return The product's name, or "(deleted)".
+ */
+static const char *soldName(const Inventory *inv, int id) {
+    size_t slot = inventoryFind(inv, id);
+    return slot == NO_SLOT ? "(deleted)" : inventoryName(inv, slot);
+}
+
+/**
+ * @brief Prints the best sellers over a range of days, by revenue.
+ *
+ * @param inv Pointer to the inventory.
+ * @param history Pointer to the sales history.
+ * @param from First day of the range.
+ * @param to Last day of the range.
+ * @param count Products to list.
+ */
+static void printTopSellers(const Inventory *inv, const SalesHistory *history, int32_t from, int32_t to, size_t count) {
+    ProductSales *top = (ProductSales *)malloc((count ? count : 1) * sizeof(ProductSales));
+    if (top == NULL) {
+        printf(ANSI_COLOR_RED"Memory allocation failed.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    size_t found = historyTopSellers(history, from, to, 1, count, top);
+    char amount[CENTS_BUF_SIZE];
+    printf("Product ID\tName\tUnits\tRevenue\n");
+    for (size_t i = 0; i < found; i++) {
+        printf("%d\t%s\t%lld\t%s\n", top[i].id, soldName(inv, top[i].id), (long long)top[i].units, formatCents(top[i].revenueCents, amount));
+    }
+    if (found == 0) {
+        printf("No sales in this period.\n");
+    }
+    free(top);
+}
+
+/**
+ * @brief Displays a summary of sales and income.
+ *
+ * This function shows the running sales totals from the ledger and the most recent bills, then
+ * today's, this week's and this month's revenue and the month's best sellers from the sales
+ * history.
+ *
+ * @param inv Pointer to the inventory, for product names.
+ * @param ledger Pointer to the sales ledger.
+ */
+void sale(const Inventory *inv, const Ledger *ledger) {
+    char amount[CENTS_BUF_SIZE];
+    printf("-------------------------------------\n");
+    if (ledger->billCount == 0) {
+        printf("No sales yet.\n");
+        printf("-------------------------------------\n");
+        return;
+    }
+    printf("Bills:          %zu\n", ledger->billCount);
+    printf("Units sold:     %lld\n", ledger->units);
+    printf("Total sales:    %s\n", formatCents(calculateTotalSales(ledger), amount));
+    printf("Average bill:   %s\n", formatCents(ledger->totalCents / (long long)ledger->billCount, amount));
+    printf("-------------------------------------\n");
+    printf("Recent bills\n");
+    printf("Bill\tDate\t\tItems\tTotal\n");
+    for (size_t i = ledger->billCount; i-- > 0 && i + 5 >= ledger->billCount;) {
+        const LedgerBill *bill = &ledger->bills[i];
+        time_t when = (time_t)bill->time;
+        struct tm local;
+        localtime_r(&when, &local);
+        printf("#%llu\t%d/%d/%d\t%zu\t%s\n", (unsigned long long)bill->number, local.tm_mday, local.tm_mon + 1,
+               local.tm_year + 1900, bill->lineCount, formatCents(bill->totalCents, amount));
+    }
+    printf("-------------------------------------\n");
+    if (ledger->history == NULL) {
+        return;
+    }
+
+    int32_t today = historyDay((int64_t)time(NULL));
+    int year, month, dayOfMonth;
+    historyDate(today, &year, &month, &dayOfMonth);
+    ProductSales day, week, monthSales;
+    historyTotals(ledger->history, today, today, &day);
+    historyTotals(ledger->history, today - 6, today, &week);
+    historyTotals(ledger->history, today - dayOfMonth + 1, today, &monthSales);
+    printf("Today:          %s\n", formatCents(day.revenueCents, amount));
+    printf("Last 7 days:    %s\n", formatCents(week.revenueCents, amount));
+    printf("This month:     %s\n", formatCents(monthSales.revenueCents, amount));
+    printf("-------------------------------------\n");
+    printf("Top sellers this month\n");
+    printTopSellers(inv, ledger->history, today - dayOfMonth + 1, today, SALES_TOP_COUNT);
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Answers date-range questions from the sales history: one product's sales over the
+ * last few days, or the best sellers of this month or of the last few days.
+ *
+ * @param inv Pointer to the inventory.
+ * @param history Pointer to the sales history, or NULL when bills are not saved.
+ */
+void salesHistory(const Inventory *inv, const SalesHistory *history) {
+    if (history == NULL) {
+        printf(ANSI_COLOR_RED"The sales history is only kept when bills are saved.\n"ANSI_COLOR_RESET);
+        return;
+    }
+    printf(ANSI_COLOR_YELLOW"1. Product Sales over the Last Days\n");
+    printf("2. Top Sellers this Month\n");
+    printf("3. Top Sellers over the Last Days\n"ANSI_COLOR_RESET);
+    printf("-------------------------------------\n");
+    printf("Enter your choice: ");
+    int choice, id = 0, days = 0, count = SALES_TOP_COUNT;
+    if (scanf("%d", &choice) != 1) {
+        return;
+    }
+    if (choice == 1) {
+        printf("Enter product ID and number of days: ");
+        if (scanf("%d %d", &id, &days) != 2) {
+            return;
+        }
+    } else if (choice == 2 || choice == 3) {
+        printf(choice == 2 ? "Enter number of products: " : "Enter number of products and days: ");
+        if (scanf("%d", &count) != 1 || (choice == 3 && scanf("%d", &days) != 1)) {
+            return;
+        }
+    }
+    if (days < 0 || count < 0) {
+        printf(ANSI_COLOR_RED"Invalid number.\n"ANSI_COLOR_RESET);
+        return;
+    }
+
+    int32_t today = historyDay((int64_t)time(NULL));
+    int year, month, dayOfMonth;
+    historyDate(today, &year, &month, &dayOfMonth);
+    char amount[CENTS_BUF_SIZE];
+    printf("-------------------------------------\n");
+    if (choice == 1) {
+        ProductSales sales;
+        historyProductSales(history, id, today - days + 1, today, &sales);
+        printf("Product %d (%s), last %d days: %lld units, %s\n", id, soldName(inv, id), days, (long long)sales.units,
+               formatCents(sales.revenueCents, amount));
+    } else if (choice == 2) {
+        printf("Top sellers since %d/%d/%d\n", 1, month, year);
+        printTopSellers(inv, history, today - dayOfMonth + 1, today, (size_t)count);
+    } else if (choice == 3) {
+        printf("Top sellers over the last %d days\n", days);
+        printTopSellers(inv, history, today - days + 1, today, (size_t)count);
+    }
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Displays how many of each operation ran and how long they took.
+ *
+ * Latencies are percentiles of the library's histograms, so each is within 12.5% of the true
+ * value.
+ */
+void operationStats(void) {
+    InventoryStats stats;
+    printf("-------------------------------------\n");
+    if (inventoryStatsRead(&stats) != INV_OK) {
+        printf(ANSI_COLOR_RED"Statistics are not built into this program.\n"ANSI_COLOR_RESET);
+        printf("-------------------------------------\n");
+        return;
+    }
+    printf("Products:       %llu (peak %llu)\n", (unsigned long long)stats.products, (unsigned long long)stats.peakProducts);
+    printf("%-10s %10s %10s %10s %10s %10s %10s\n", "operation", "count", "mean us", "p50 us", "p99 us", "p99.9 us", "max us");
+    for (int op = 0; op < STAT_COUNT; op++) {
+        const OpStats *opStats = &stats.ops[op];
+        double mean = opStats->count > 0 ? (double)opStats->totalNs / opStats->count : 0;
+        printf("%-10s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", inventoryStatName(op), (unsigned long long)opStats->count,
+               mean / 1e3, inventoryStatsPercentile(opStats, 500) / 1e3, inventoryStatsPercentile(opStats, 990) / 1e3,
+               inventoryStatsPercentile(opStats, 999) / 1e3, opStats->maxNs / 1e3);
+    }
+    printf("-------------------------------------\n");
+}
+
+/**
+ * @brief Appends text to a JSON buffer without the C library, so signal handlers can use it.
+ *
+ * @param buf Buffer.
+ * @param size Buffer size.
+ * @param used Bytes already in the buffer.
+ * @param text Text to append; cut short if the buffer fills.
+ * @return Bytes in the buffer afterwards.
+ */
+static size_t jsonText(char *buf, size_t size, size_t used, const char *text) {
+    while (*text != '\0' && used + 1 < size) {
+        buf[used++] = *text++;
+    }
+    buf[used] = '\0';
+    return used;
+}
+
+/**
+ * @brief Appends "key":value to a JSON buffer, signal-safely.
+ *
+ * @param buf Buffer.
+ * @param size Buffer size.
+ * @param used Bytes already in the buffer.
+ * @param key Member name.
+ * @param value Member value.
+ * @return Bytes in the buffer afterwards.
+ */
+static size_t jsonNumber(char *buf, size_t size, size_t used, const char *key, uint64_t value) {
+    char digits[24];
+    size_t n = sizeof(digits) - 1;
+    digits[n] = '\0';
+    do {
+        digits[--n] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    used = jsonText(buf, size, used, "\"");
+    used = jsonText(buf, size, used, key);
+    used = jsonText(buf, size, used, "\":");
+    return jsonText(buf, size, used, digits + n);
+}
+
+/**
+ * @brief Writes the operation statistics to a file as JSON.
+ *
+ * Uses only async-signal-safe calls, so it can run from the SIGUSR1 handler at any moment.
+ * Latencies are in nanoseconds.
+ *
+ * @param path File to write.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+static int statsDump(const char *path) {
+    static InventoryStats stats;
+    static char json[STATS_JSON_SIZE];
+    inventoryStatsRead(&stats);
+
+    size_t used = jsonText(json, sizeof(json), 0, "{");
+    used = jsonNumber(json, sizeof(json), used, "products", stats.products);
+    used = jsonText(json, sizeof(json), used, ",");
+    used = jsonNumber(json, sizeof(json), used, "peak_products", stats.peakProducts);
+    used = jsonText(json, sizeof(json), used, ",\"operations\":{");
+    for (int op = 0; op < STAT_COUNT; op++) {
+        const OpStats *opStats = &stats.ops[op];
+        used = jsonText(json, sizeof(json), used, op > 0 ? ",\"" : "\"");
+        used = jsonText(json, sizeof(json), used, inventoryStatName(op));
+        used = jsonText(json, sizeof(json), used, "\":{");
+        used = jsonNumber(json, sizeof(json), used, "count", opStats->count);
+        used = jsonText(json, sizeof(json), used, ",");
+        used = jsonNumber(json, sizeof(json), used, "total_ns", opStats->totalNs);
+        used = jsonText(json, sizeof(json), used, ",");
+        used = jsonNumber(json, sizeof(json), used, "p50_ns", inventoryStatsPercentile(opStats, 500));
+        used = jsonText(json, sizeof(json), used, ",");
+        used = jsonNumber(json, sizeof(json), used, "p90_ns", inventoryStatsPercentile(opStats, 900));
+        used = jsonText(json, sizeof(json), used, ",");
+        used = jsonNumber(json, sizeof(json), used, "p99_ns", inventoryStatsPercentile(opStats, 990));
+        used = jsonText(json, sizeof(json), used, ",");
+        used = jsonNumber(json, sizeof(json), used, "p999_ns", inventoryStatsPercentile(opStats, 999));
+        used = jsonText(json, sizeof(json), used, ",");
+        used = jsonNumber(json, sizeof(json), used, "max_ns", opStats->maxNs);
+        used = jsonText(json, sizeof(json), used, "}");
+    }
+    used = jsonText(json, sizeof(json), used, "}}\n");
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t written = 0;
+    while (written < used) {
+        ssize_t n = write(fd, json + written, used - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += (size_t)n;
+    }
+    close(fd);
+    return written == used ? 0 : -1;
+}
+
+/**
+ * @brief SIGUSR1 handler: writes the operation statistics to statsPath.
+ *
+ * @param signal Signal number (unused).
+ */
+static void statsSignal(int signal) {
+    (void)signal;
+    int savedErrno = errno;
+    statsDump(statsPath);
+    errno = savedErrno;
+}
+
+/**
+ * @brief Writes the operation statistics to statsPath when the program exits (--stats).
+ */
+static void statsAtExit(void) {
+    if (statsDump(statsPath) != 0) {
+        fprintf(stderr, "Could not write %s\n", statsPath);
+    }
+}
+
+/**
+ * @brief Main function.
+ *
+ * The main function for the inventory management system.
+ * Run with "--bench <name>" to run a benchmark instead of the interactive menu, and with
+ * "--threads N" to set the number of threads used to parse text imports. Every change is
+ * recorded in a write-ahead log and recovered on the next start, and every bill in the sales
+ * ledger and sales history, unless "--no-wal" is given.
+ * "--batch [file]" runs commands from a file (or standard input) instead of the menu, and
+ * "--serve <port|socket path>" serves the inventory to POS clients over a socket instead;
+ * "--loadgen <port|socket path> ..." drives load against such a server. "--check" recovers
+ * the inventory, verifies its running totals against a full recount and exits; "--low-stock N"
+ * sets the quantity below which a product counts as low on stock. "--report table|csv|tsv"
+ * recovers the inventory and streams the product list to standard output. Products due for
+ * reordering are tracked from the start, with the sales ledger as their demand history.
+ */
+int main(int argc, char *argv[]) {
+    int arg = 1;
+    int useWal = 1;
+    const char *batchPath = NULL;
+    const char *serveAddress = NULL;
+    int checkOnly = 0;
+    int reportFormat = -1;
+    int lowStock = LOW_STOCK_DEFAULT;
+    while (arg < argc) {
+        if (argc >= arg + 2 && strcmp(argv[arg], "--threads") == 0) {
+            loadThreads = atoi(argv[arg + 1]);
+            if (loadThreads < 0 || loadThreads > MAX_LOAD_THREADS) {
+                printf("--threads must be between 0 and %d\n", MAX_LOAD_THREADS);
+                return 1;
+            }
+            arg += 2;
+        } else if (strcmp(argv[arg], "--no-wal") == 0) {
+            useWal = 0;
+            arg++;
+        } else if (strcmp(argv[arg], "--batch") == 0) {
+            batchPath = argc >= arg + 2 ? argv[arg + 1] : "-";
+            arg += argc >= arg + 2 ? 2 : 1;
+        } else if (argc >= arg + 2 && strcmp(argv[arg], "--low-stock") == 0) {
+            lowStock = atoi(argv[arg + 1]);
+            arg += 2;
+        } else if (argc >= arg + 2 && strcmp(argv[arg], "--report") == 0) {
+            const char *format = argv[arg + 1];
+            reportFormat = strcmp(format, "table") == 0 ? REPORT_TABLE : strcmp(format, "csv") == 0 ? REPORT_CSV
+                         : strcmp(format, "tsv") == 0 ? REPORT_TSV : -1;
+            if (reportFormat < 0) {
+                printf("--report takes table, csv or tsv\n");
+                return 1;
+            }
+            arg += 2;
+        } else if (strcmp(argv[arg], "--check") == 0) {
+            checkOnly = 1;
+            arg++;
+        } else if (argc >= arg + 2 && strcmp(argv[arg], "--stats") == 0) {
+            statsPath = argv[arg + 1];
+            atexit(statsAtExit);
+            arg += 2;
+        } else if (argc >= arg + 2 && strcmp(argv[arg], "--serve") == 0) {
+            serveAddress = argv[arg + 1];
+            arg += 2;
+        } else if (strcmp(argv[arg], "--bench") == 0) {
+            return runBenchmark(argc - arg - 1, argv + arg + 1, loadThreads);
+        } else if (strcmp(argv[arg], "--loadgen") == 0) {
+            return runLoadgen(argc - arg - 1, argv + arg + 1);
+        } else {
+            printf("Usage: %s [--threads N] [--no-wal] [--low-stock N] [--stats <json path>] [--batch [file|-] | --serve <port|socket path> | --check | --report table|csv|tsv] [--bench <name>] [--loadgen <port|socket path> ...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // kill -USR1 writes the operation statistics without stopping the program
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = statsSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+
+    FILE *batchInput = NULL;
+    if (batchPath != NULL) {
+        batchInput = strcmp(batchPath, "-") == 0 ? stdin : fopen(batchPath, "r");
+        if (batchInput == NULL) {
+            fprintf(stderr, "Could not open %s\n", batchPath);
+            return 1;
+        }
+    }
+    // In batch mode stdout carries results only, so status messages go to stderr
+    FILE *status = batchInput != NULL || serveAddress != NULL || reportFormat >= 0 ? stderr : stdout;
+
+    Inventory inventory;
+    Wal wal;
+    Ledger ledger;
+    SalesHistory history;
+    ReorderQueue reorder;
+    int choice;
+
+    inventoryInit(&inventory);
+    inventory.lowStockThreshold = lowStock;
+    ledgerInit(&ledger);
+    historyInit(&history);
+    reorderInit(&reorder, lowStock - 1); // by default, reorder what is low on stock
+
+    // Bring back every change made in earlier runs: checkpoint snapshot plus change log
+    if (useWal) {
+        size_t replayed = 0;
+        if (walOpen(&wal, WAL_FILE, CHECKPOINT_FILE) != INV_OK) {
+            fprintf(status, ANSI_COLOR_RED"Could not open the change log; changes will not be saved.\n"ANSI_COLOR_RESET);
+        } else if (inventoryRecover(&inventory, &wal, &replayed) != INV_OK) {
+            fprintf(status, ANSI_COLOR_RED"Could not recover the inventory; changes will not be saved.\n"ANSI_COLOR_RESET);
+            walClose(&wal);
+            inventoryFree(&inventory);
+        } else if (inventory.liveCount > 0 || replayed > 0) {
+            fprintf(status, ANSI_COLOR_GREEN"Recovered %zu products (%zu logged changes replayed).\n"ANSI_COLOR_RESET, inventory.liveCount, replayed);
+        }
+        if (ledgerOpen(&ledger, LEDGER_FILE) != INV_OK) {
+            fprintf(status, ANSI_COLOR_RED"Could not open the sales ledger; bills will not be saved.\n"ANSI_COLOR_RESET);
+            ledgerFree(&ledger);
+        } else if (historyOpen(&history, HISTORY_DIR) != INV_OK || ledgerAttachHistory(&ledger, &history) != INV_OK) {
+            fprintf(status, ANSI_COLOR_RED"Could not open the sales history; date-range reports are off.\n"ANSI_COLOR_RESET);
+            historyFree(&history);
+        }
+    }
+    if (reorderAttach(&reorder, &inventory) != INV_OK) {
+        fprintf(status, ANSI_COLOR_RED"Could not build the reorder list; reordering is off.\n"ANSI_COLOR_RESET);
+    } else {
+        if (inventory.wal != NULL && reorderLoadRules(&inventory, REORDER_FILE) == INV_ERR_INVALID) {
+            fprintf(status, ANSI_COLOR_RED"Ignoring a malformed line in " REORDER_FILE ".\n"ANSI_COLOR_RESET);
+        }
+        reorderReplay(&reorder, &ledger);
+    }
+
+    if (batchInput != NULL) {
+        size_t failures = runBatch(&inventory, &ledger, batchInput, stdout);
+        if (batchInput != stdin) {
+            fclose(batchInput);
+        }
+        if (inventory.wal != NULL) {
+            walClose(&wal);
+        }
+        inventoryFree(&inventory);
+        ledgerFree(&ledger);
+        historyFree(&history);
+        reorderFree(&reorder);
+        return failures == 0 ? 0 : 1;
+    }
+
+    if (reportFormat >= 0) {
+        long long rows = reportProducts(&inventory, STDOUT_FILENO, reportFormat, 0);
+        if (inventory.wal != NULL) {
+            walClose(&wal);
+        }
+        inventoryFree(&inventory);
+        ledgerFree(&ledger);
+        historyFree(&history);
+        reorderFree(&reorder);
+        return rows >= 0 ? 0 : 1;
+    }
+
+    if (checkOnly) {
+        InventoryTotals totals, recounted;
+        char value[CENTS_BUF_SIZE], expected[CENTS_BUF_SIZE];
+        inventoryTotals(&inventory, &totals);
+        inventoryRecount(&inventory, &recounted);
+        int consistent = memcmp(&totals, &recounted, sizeof(totals)) == 0;
+        printf("%-16s %20s %20s\n", "", "running", "recounted");
+        printf("%-16s %20s %20s\n", "stock value", formatCents(totals.stockValueCents, value), formatCents(recounted.stockValueCents, expected));
+        printf("%-16s %20lld %20lld\n", "units", totals.units, recounted.units);
+        printf("%-16s %20zu %20zu\n", "products", totals.skus, recounted.skus);
+        printf("%-16s %20zu %20zu\n", "low on stock", totals.lowStock, recounted.lowStock);
+        printf(consistent ? ANSI_COLOR_GREEN"Totals are consistent.\n"ANSI_COLOR_RESET : ANSI_COLOR_RED"Totals do not match!\n"ANSI_COLOR_RESET);
+        if (inventory.wal != NULL) {
+            walClose(&wal);
+        }
+        inventoryFree(&inventory);
+        ledgerFree(&ledger);
+        historyFree(&history);
+        reorderFree(&reorder);
+        return consistent ? 0 : 1;
+    }
+
+    if (serveAddress != NULL) {
+        int served = runServer(&inventory, &ledger, serveAddress, status);
+        if (inventory.wal != NULL) {
+            walClose(&wal);
+        }
+        inventoryFree(&inventory);
+        ledgerFree(&ledger);
+        historyFree(&history);
+        reorderFree(&reorder);
+        return served == 0 ? 0 : 1;
+    }
+
+    do {
+        printf("\n-- " ANSI_COLOR_CYAN "Inventory Management System" ANSI_COLOR_RESET " --\n");
+        printf(ANSI_COLOR_GREEN "1. Add Product\n");
+        printf("2. View Products\n");
+        printf("3. Delete Product\n");
+        printf("4. Generate Bill\n");
+        printf("5. Search Product\n");
+        printf("6. Update Product\n");
+        printf("7. Backup & Restore Inventory\n");
+        printf("8. Management Info\n");
+        printf("9. Price & Stock Queries\n");
+        printf("0. Exit\n" ANSI_COLOR_RESET);
+        printf("-------------------------------------\n");
+        printf("Enter your choice: ");
+        scanf("%d", &choice);
+        printf("-------------------------------------\n");
+
+        switch (choice) {
+            case 1:
+                addProduct(&inventory);
+                break;
+            case 2:
+                viewProducts(&inventory);
+                break;
+            case 3:
+                printf("Enter product ID to delete: ");
+                int id;
+                scanf("%d", &id);
+                deleteProduct(&inventory, id);
+                break;
+            case 4:
+                generateBill(&inventory, &ledger);
+                break;
+            case 5:
+                printf(ANSI_COLOR_YELLOW"1. Search by ID\n");
+                printf("2. Search by Name\n");
+                printf("3. Search by Name Prefix\n"ANSI_COLOR_RESET);
+                printf("-------------------------------------\n");
+                printf("Enter your choice: ");
+                int how;
+                scanf("%d", &how);
+                if (how == 1) {
+                    printf("Enter product ID to search: ");
+                    scanf("%d", &id);
+                    searchProduct(&inventory, id);
+                } else if (how == 2 || how == 3) {
+                    char query[NAME_SIZE];
+                    printf("Enter product name or part of it: ");
+                    scanf("%99s", query);
+                    searchProductByName(&inventory, query, how == 3);
+                }
+                break;
+            case 6:
+                printf("Enter product ID to update: ");
+                scanf("%d", &id);
+                updateProduct(&inventory, id);
+                break;
+            case 7:
+                printf(ANSI_COLOR_YELLOW"1. Backup Inventory\n");
+                printf("2. Restore Inventory\n");
+                printf("3. Export Inventory as Text\n");
+                printf("4. Import Inventory from Text\n");
+                printf("5. Export Report as CSV\n");
+                printf("6. Export Report as TSV\n");
+                printf("7. Compressed Backup\n");
+                printf("8. Restore Compressed Backup\n"ANSI_COLOR_RESET);
+                printf("-------------------------------------\n");
+                printf("Enter your choice: ");
+                int zz;
+                scanf("%d", &zz);
+                printf("-------------------------------------\n");
+                switch(zz) {
+                    case 2:
+                        restoreInventory(&inventory);
+                        break;
+                    case 1:
+                        backupInventory(&inventory);
+                        break;
+                    case 3:
+                        exportInventory(&inventory);
+                        break;
+                    case 4:
+                        importInventory(&inventory);
+                        break;
+                    case 5:
+                        exportReport(&inventory, REPORT_CSV);
+                        break;
+                    case 6:
+                        exportReport(&inventory, REPORT_TSV);
+                        break;
+                    case 7:
+                        exportCompressed(&inventory);
+                        break;
+                    case 8:
+                        importCompressed(&inventory);
+                        break;
+                }
+                break;
+            case 8:
+                printf("Enter password: ");
+                int pass;
+                scanf("%d",&pass);
+                if (pass == 189) {
+                    printf(ANSI_COLOR_GREEN"Access granted\n"ANSI_COLOR_RESET);
+                    printf("-------------------------------------\n");
+                    printf(ANSI_COLOR_YELLOW"1. Sales and Income\n");
+                    printf("2. Employees Details\n");
+                    printf("3. Total Sales\n");
+                    printf("4. Stock Summary\n");
+                    printf("5. Set Low-Stock Threshold\n");
+                    printf("6. Operation Statistics\n");
+                    printf("7. Sales History\n"ANSI_COLOR_RESET);
+                    printf("-------------------------------------\n");
+                    printf("Enter your choice: ");
+                    int xx;
+                    scanf("%d", &xx);
+                    printf("-------------------------------------\n");
+
+                    switch(xx) {
+                        case 1:
+                            sale(&inventory, &ledger);
+                            break;
+                        case 2:
+                            emp();
+                            break;
+                        case 3: {
+                            char total[CENTS_BUF_SIZE];
+                            printf("Total Sales: %s\n", formatCents(calculateTotalSales(&ledger), total));
+                            break;
+                        }
+                        case 4:
+                            stockSummary(&inventory);
+                            break;
+                        case 5:
+                            printf("Products with fewer units than this are low on stock (now %d): ", inventory.lowStockThreshold);
+                            int threshold;
+                            if (scanf("%d", &threshold) == 1) {
+                                inventorySetLowStock(&inventory, threshold);
+                                printf("%zu products are low on stock.\n", inventory.lowStock);
+                            }
+                            break;
+                        case 6:
+                            operationStats();
+                            break;
+                        case 7:
+                            salesHistory(&inventory, ledger.history);
+                            break;
+                    }
+                }
+                else
+                    printf(ANSI_COLOR_RED"Password incorrect\n"ANSI_COLOR_RESET);
+                break;
+            case 9:
+                stockQueries(&inventory);
+                break;
+            case 0:
+                printf(ANSI_COLOR_RED "Exiting...\n" ANSI_COLOR_RESET);
+                break;
+            default:
+                printf(ANSI_COLOR_RED"Invalid choice. Please try again.\n"ANSI_COLOR_RESET);
+                break;
+        }
+
+        if (inventoryCommit(&inventory) != INV_OK) {
+            printf(ANSI_COLOR_RED"Warning: could not write the change log.\n"ANSI_COLOR_RESET);
+        }
+        if (ledgerSync(&ledger) != INV_OK) {
+            printf(ANSI_COLOR_RED"Warning: could not write the sales ledger.\n"ANSI_COLOR_RESET);
+        }
+    } while (choice != 0);
+
+    if (inventory.wal != NULL) {
+        walClose(&wal);
+    }
+    inventoryFree(&inventory);
+    ledgerFree(&ledger);
+    historyFree(&history);
+    reorderFree(&reorder);
+    return 0;
+}
@@ -1,187 +1,195 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-// Structure for date
-typedef struct {
-    int day, month, year;
-} Date;
-
-// Structure for product details
-typedef struct {
-    int id;
-    char name[100];
-    float price;
-    int quantity;
-} Product;
-
-// Structure for a node in the inventory linked list
-typedef struct node {
-    Product product;
-    struct node *next;
-} Node;
-
-// Function prototypes
-void addProduct(Node **head);
-void viewProducts(Node *head);
-void deleteProduct(Node **head, int id);
-void generateBill(Node *head);
-float calculateTotalSales(Node *head);
-// ... other function prototypes
-
-// Function to add a product to the inventory
-void addProduct(Node **head) {
-    Node *newProduct = (Node*)malloc(sizeof(Node));
-    if (newProduct == NULL) {
-        printf("Memory allocation failed.\n");
-        return;
-    }
-
-    printf("Enter product ID: ");
-    scanf("%d", &newProduct->product.id);
-    printf("Enter product name: ");
-    scanf("%s", newProduct->product.name);
-    printf("Enter product price: ");
-    scanf("%f", &newProduct->product.price);
-    printf("Enter product quantity: ");
-    scanf("%d", &newProduct->product.quantity);
-
-    newProduct->next = *head;
-    *head = newProduct;
-    printf("----------------------------------\n");
-    printf("Product added successfully.\n");
-    printf("----------------------------------\n");
-}
-
-// Function to view all products in the inventory
-void viewProducts(Node *head) {
-    if (head == NULL) {
-        printf("Inventory is empty.\n");
-        return;
-    }
-
-    printf("Product ID\tName\tPrice\tQuantity\n");
-    while (head != NULL) {
-        printf("%d\t     \t %s \t%.2f\t %d\n", head->product.id, head->product.name, head->product.price, head->product.quantity);
-        head = head->next;
-    }
-    printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n");
-
-}
-
-// Function to delete a product from the inventory
-void deleteProduct(Node **head, int id) {
-    Node *temp = *head;
-    Node *prev = NULL;
-
-    while (temp != NULL && temp->product.id != id) {
-        prev = temp;
-        temp = temp->next;
-    }
-
-    if (temp == NULL) {
-        printf("Product with ID %d not found.\n", id);
-        return;
-    }
-
-    if (prev != NULL) {
-        prev->next = temp->next;
-    } else {
-        *head = temp->next;
-    }
-
-    free(temp);
-    printf("Product with ID %d deleted successfully.\n", id);
-}
-
-// Function to generate a bill with date and time
-void generateBill(Node *head) {
-    if (head == NULL) {
-        printf("Inventory is empty.\n");
-        return;
-    }
-
-    Date currentDate;
-    printf("Enter current date (dd mm yyyy): ");
-    scanf("%d %d %d", &currentDate.day, &currentDate.month, &currentDate.year);
-
-    printf("Bill generated on %d/%d/%d:\n", currentDate.day, currentDate.month, currentDate.year);
-    printf("*************************************\n");
-    printf("Product ID\tName\tPrice\tQuantity\n");
-    float total=0.0;
-    while (head != NULL) {
-        printf("%d\t     \t %s \t%.2f\t %d\n", head->product.id, head->product.name, head->product.price, head->product.quantity);
-        total+=head->product.price*head->product.quantity;
-        head = head->next;
-    }
-    printf("-------------------------------------\n");
-    printf("Total               %.2f\n",total);
-    printf("*************************************\n");
-}
-
-// Function to calculate total sales for the day
-float calculateTotalSales(Node *head) {
-    float totalSales = 0;
-
-    while (head != NULL) {
-        totalSales += (head->product.price * head->product.quantity);
-        head = head->next;
-    }
-
-    return totalSales;
-}
-
-// Main function
-int main() {
-    Node *head = NULL;
-    int choice, productId;
-
-    do {
-        printf("\n-- Inventory Management System --\n");
-        printf("1. Add Product\n");
-        printf("2. View Products\n");
-        printf("3. Delete Product\n");
-        printf("4. Generate Bill\n");
-        printf("5. Calculate Total Sales\n");
-        printf("6. Exit\n");
-        printf("----------------------------------\n");
-        printf("Enter your choice: ");
-        scanf("%d", &choice);
-        printf("----------------------------------\n");
-
-        switch (choice) {
-            case 1:
-                addProduct(&head);
-                break;
-            case 2:
-                viewProducts(head);
-                break;
-            case 3:
-                printf("Enter product ID to delete: ");
-                scanf("%d", &productId);
-                deleteProduct(&head, productId);
-                break;
-            case 4:
-                generateBill(head);
-                break;
-            case 5:
-                printf("\nTotal sales for the day: %.2f\n", calculateTotalSales(head));
-                break;
-            case 6:
-                printf("Exiting program.\n");
-                break;
-            default:
-                printf("Invalid choice. Please enter a number between 1 and 6.\n");
-        }
-    } while (choice != 6);
-
-    // Free memory before exiting
-    Node *temp;
-    while (head != NULL) {
-        temp = head;
-        head = head->next;
-        free(temp);
-    }
-
-    return 0;
-}
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inventory.h"
+
+// Structure for date
+typedef struct {
+    int day, month, year;
+} Date;
+
+// Function prototypes
+void addProduct(Inventory *inv);
+void viewProducts(const Inventory *inv);
+void deleteProduct(Inventory *inv, int id);
+void generateBill(Inventory *inv, Ledger *ledger);
+// ... other function prototypes
+
+// Function to add a product to the inventory
+void addProduct(Inventory *inv) {
+    int id, quantity, priceCents;
+    char name[NAME_SIZE];
+    char price[32];
+
+    printf("Enter product ID: ");
+    scanf("%d", &id);
+    printf("Enter product name: ");
+    scanf("%99s", name);
+    printf("Enter product price: ");
+    scanf("%31s", price);
+    printf("Enter product quantity: ");
+    scanf("%d", &quantity);
+
+    if (parseCents(price, &priceCents) != INV_OK) {
+        printf("Invalid price.\n");
+        return;
+    }
+
+    switch (inv_add(inv, id, name, priceCents, quantity)) {
+        case INV_OK:
+            printf("----------------------------------\n");
+            printf("Product added successfully.\n");
+            printf("----------------------------------\n");
+            break;
+        case INV_ERR_EXISTS:
+            printf("Product with ID %d already exists.\n", id);
+            break;
+        case INV_ERR_INVALID:
+            printf("Invalid product name.\n");
+            break;
+        default:
+            printf("Memory allocation failed.\n");
+    }
+}
+
+// Function to view all products in the inventory
+void viewProducts(const Inventory *inv) {
+    if (inv->liveCount == 0) {
+        printf("Inventory is empty.\n");
+        return;
+    }
+
+    char price[CENTS_BUF_SIZE];
+    Product product;
+    size_t cursor = 0;
+    printf("Product ID\tName\tPrice\tQuantity\n");
+    while (inv_next(inv, &cursor, &product)) {
+        printf("%d\t     \t %s \t%s\t %d\n", product.id, product.name, formatCents(product.priceCents, price), product.quantity);
+    }
+    printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n");
+
+}
+
+// Function to delete a product from the inventory
+void deleteProduct(Inventory *inv, int id) {
+    if (inv_delete(inv, id) != INV_OK) {
+        printf("Product with ID %d not found.\n", id);
+        return;
+    }
+    printf("Product with ID %d deleted successfully.\n", id);
+}
+
+// Function to generate a bill with date and time: reads "id quantity" pairs until an ID of 0,
+// then sells the whole cart or nothing
+void generateBill(Inventory *inv, Ledger *ledger) {
+    if (inv->liveCount == 0) {
+        printf("Inventory is empty.\n");
+        return;
+    }
+
+    Date currentDate;
+    printf("Enter current date (dd mm yyyy): ");
+    scanf("%d %d %d", &currentDate.day, &currentDate.month, &currentDate.year);
+
+    Cart cart;
+    cart.count = 0;
+    int id, quantity;
+    while (1) {
+        printf("Enter product ID and quantity (0 to finish): ");
+        if (scanf("%d", &id) != 1 || id == 0 || scanf("%d", &quantity) != 1) {
+            break;
+        }
+        if (cartAdd(&cart, id, quantity) != INV_OK) {
+            printf("Invalid quantity, or the bill is full.\n");
+        }
+    }
+    if (cart.count == 0) {
+        printf("No items billed.\n");
+        return;
+    }
+
+    const LedgerBill *bill;
+    int failedLine;
+    int status = inv_sell(inv, ledger, &cart, &bill, &failedLine);
+    if (status == INV_ERR_NOT_FOUND || status == INV_ERR_STOCK) {
+        printf("Product with ID %d is %s.\n", cart.lines[failedLine].id, status == INV_ERR_STOCK ? "short of stock" : "not found");
+        return;
+    }
+    if (status != INV_OK) {
+        printf("Memory allocation failed.\n");
+        return;
+    }
+
+    char price[CENTS_BUF_SIZE], amount[CENTS_BUF_SIZE];
+    printf("Bill generated on %d/%d/%d:\n", currentDate.day, currentDate.month, currentDate.year);
+    printf("*************************************\n");
+    printf("Product ID\tName\tPrice\tQuantity\n");
+    for (size_t i = 0; i < bill->lineCount; i++) {
+        const SaleLine *line = &ledger->lines[bill->firstLine + i];
+        printf("%d\t     \t %s \t%s\t %d\n", line->id, inventoryName(inv, inventoryFind(inv, line->id)), formatCents(line->priceCents, price), line->quantity);
+    }
+    printf("-------------------------------------\n");
+    printf("Total               %s\n", formatCents(bill->totalCents, amount));
+    printf("*************************************\n");
+}
+
+// Main function
+int main() {
+    Inventory inv;
+    Ledger ledger;
+    int choice, productId;
+    char amount[CENTS_BUF_SIZE];
+
+    inventoryInit(&inv);
+    ledgerInit(&ledger);
+
+    do {
+        printf("\n-- Inventory Management System --\n");
+        printf("1. Add Product\n");
+        printf("2. View Products\n");
+        printf("3. Delete Product\n");
+        printf("4. Generate Bill\n");
+        printf("5. Calculate Total Sales\n");
+        printf("6. Exit\n");
+        printf("----------------------------------\n");
+        printf("Enter your choice: ");
+        if (scanf("%d", &choice) != 1) {
+            choice = 6; // End of input
+        }
+        printf("----------------------------------\n");
+
+        switch (choice) {
+            case 1:
+                addProduct(&inv);
+                break;
+            case 2:
+                viewProducts(&inv);
+                break;
+            case 3:
+                printf("Enter product ID to delete: ");
+                scanf("%d", &productId);
+                deleteProduct(&inv, productId);
+                break;
+            case 4:
+                generateBill(&inv, &ledger);
+                break;
+            case 5:
+                printf("\nTotal sales for the day: %s\n", formatCents(calculateTotalSales(&ledger), amount));
+                break;
+            case 6:
+                printf("Exiting program.\n");
+                break;
+            default:
+                printf("Invalid choice. Please enter a number between 1 and 6.\n");
+        }
+    } while (choice != 6);
+
+    // Free memory before exiting
+    ledgerFree(&ledger);
+    inventoryFree(&inv);
+
+    return 0;
+}